@@ -1,13 +1,26 @@
+#include <assert.h>
 #include <math.h>
+#include <stdlib.h>
 
 #include "camera.h"
 #include "core/color.h"
+#include "core/debug.h"
 #include "core/ray.h"
+#include "core/ray_packet.h"
+#include "core/sampler.h"
+#include "core/sampling.h"
+#include "core/stats.h"
 #include "core/vec3.h"
 #include "hittable/hittable.h"
 #include "hittable/hittable_list.h"
+#include "light/light_list.h"
 #include "material/material.h"
 #include "progress.h"
+#include "wavefront.h"
+
+// Part of the way to a light sample that shadow rays leave out, so they
+// stop short of the light's own surface at any scale
+#define SHADOW_RAY_MARGIN 1e-4
 
 static bool use_lighting = true;
 
@@ -17,9 +30,8 @@ Camera camera_make(int image_width, double aspect_ratio, Vec3 lookfrom,
                    double focus_dist, int samples_per_pixel, int max_depth,
                    Color background, bool is_lighting) {
 
-  use_lighting = is_lighting;
-
   Camera cam = {0}; // Initialize all fields to zero
+  cam.is_lighting = is_lighting;
 
   // Basic camera parameters
   cam.image_width = image_width;
@@ -33,6 +45,10 @@ Camera camera_make(int image_width, double aspect_ratio, Vec3 lookfrom,
   cam.lookat = lookat;
   cam.vup = vup;
   cam.background = background;
+  cam.sampler = SAMPLER_SOBOL;
+  cam.primary_packets = true;
+  cam.wavefront_paths = WAVEFRONT_DEFAULT_PATHS;
+  cam.sort_rays = false;
   cam.center = lookfrom;
 
   // Calculate image height with proper bounds checking
@@ -82,88 +98,321 @@ Camera camera_make(int image_width, double aspect_ratio, Vec3 lookfrom,
   return cam;
 }
 
-static Color ray_color(Ray r, int depth, Hittable *hittable_world, Color background) {
-    if (use_lighting) {
-        if (depth <= 0)
-            return vec3_zero();
+bool camera_sample_direct_light(const HitRecord *rec, Ray r_in,
+                                const LightList *lights, Sampler *sampler,
+                                Ray *shadow, Interval *shadow_t,
+                                Color *contribution) {
+    LightSample ls;
+    const Hittable *light;
+    if (!lightlist_sample(lights, rec->p, rec->normal, r_in.time, sampler, &ls,
+                          &light))
+        return false;
+
+    // Directions the BSDF never scatters into reflect no light either
+    double bsdf_pdf = material_pdf(rec->mat, r_in, rec, ls.wi);
+    if (bsdf_pdf <= 0)
+        return false;
+
+    *shadow = ray_spawn_to(rec->p, rec->normal, ls.p, r_in.time);
+    *shadow_t = interval_make(0, 1 - SHADOW_RAY_MARGIN);
+    Color emitted = material_emitted(light->mat, 0.0, 0.0, &ls.p);
+    Color f = material_eval(rec->mat, r_in, rec, ls.wi);
+    *contribution = vec3_scale(vec3_mul(f, emitted),
+                               power_heuristic(ls.pdf, bsdf_pdf) / ls.pdf);
+    return true;
+}
+
+// Next-event estimation at a non-delta hit, including the shadow ray.
+static Color sample_direct_light(const HitRecord *rec, Ray r_in,
+                                 Hittable *hittable_world,
+                                 const LightList *lights, Sampler *sampler) {
+    Ray shadow;
+    Interval shadow_t;
+    Color contribution;
+    if (!camera_sample_direct_light(rec, r_in, lights, sampler, &shadow,
+                                    &shadow_t, &contribution))
+        return vec3_zero();
 
-        HitRecord rec;
-        if (!hittable_world->hit(hittable_world, r, interval_make(1e-4, INFINITY), &rec)) {
+    STATS_INC(rays);
+    if (hittable_world->occluded(hittable_world, shadow, shadow_t))
+        return vec3_zero();
+    return contribution;
+}
+
+Color camera_sky_color(Ray r) {
+    Vec3 unit_direction = vec3_normalized(r.direction);
+    double a = (unit_direction.y + 1) * 0.5;
+    return vec3_add((Vec3){1.0 - a, 1.0 - a, 1.0 - a},
+                    (Vec3){0.5 * a, 0.7 * a, 1.0 * a});
+}
+
+static Color ray_color(Ray r, int depth, Hittable *hittable_world,
+                       const LightList *lights, Color background,
+                       Sampler *sampler, double scatter_pdf,
+                       Vec3 scatter_normal);
+
+// Radiance arriving along `r`, whose closest hit has already been found and
+// finalized into `rec` (NULL if `r` left the scene). `depth` counts the
+// bounce of `r` itself.
+//
+// `scatter_pdf` is the BSDF density that produced `r` at a bounce which also
+// sampled the light list, and `scatter_normal` the surface normal there, so
+// emission from listed lights it hits is MIS weighted. `scatter_pdf` is
+// negative for camera rays and after delta or unsampled bounces, where that
+// emission counts in full.
+static Color shade_ray(Ray r, HitRecord *rec, int depth,
+                       Hittable *hittable_world, const LightList *lights,
+                       Color background, Sampler *sampler, double scatter_pdf,
+                       Vec3 scatter_normal) {
+    if (use_lighting) {
+        if (rec == NULL) {
             return background;
         }
 
         Ray scatterd;
         Color attenuation;
-        Color color_from_emission = material_emitted(rec.mat, 0.0, 0.0, &rec.p);
+        Color color_from_emission = material_emitted(rec->mat, 0.0, 0.0, &rec->p);
+        if (scatter_pdf >= 0 && lightlist_is_light(rec->obj)) {
+            double light_pdf = lightlist_pdf(lights, r, scatter_normal, rec);
+            color_from_emission = vec3_scale(
+                color_from_emission, power_heuristic(scatter_pdf, light_pdf));
+        }
 
-        if (!rec.mat->scatter(rec.mat, r, &rec, &attenuation, &scatterd)) {
+        uint32_t bounce_dimension = sampler_dimension(sampler);
+        if (!rec->mat->scatter(rec->mat, r, rec, sampler, &attenuation,
+                               &scatterd)) {
             return color_from_emission;
         }
 
+        bool sample_lights = lightlist_size(lights) > 0 &&
+                             !material_is_delta(rec->mat);
+        Color color_from_direct = vec3_zero();
+        double next_pdf = -1.0;
+        if (sample_lights) {
+            color_from_direct =
+                sample_direct_light(rec, r, hittable_world, lights, sampler);
+            next_pdf = material_pdf(rec->mat, r, rec,
+                                    vec3_normalized(scatterd.direction));
+        }
+
+        sampler_set_dimension(sampler, bounce_dimension + BOUNCE_REQUESTS);
         Color color_from_scatter =
-            vec3_mul(ray_color(scatterd, depth - 1, hittable_world, background),
+            vec3_mul(ray_color(scatterd, depth - 1, hittable_world, lights,
+                               background, sampler, next_pdf, rec->normal),
                      attenuation);
 
-        return vec3_add(color_from_emission, color_from_scatter);
+        return vec3_add(vec3_add(color_from_emission, color_from_direct),
+                        color_from_scatter);
     } else {
-        if (depth <= 0)
-            return vec3_zero();
-
-        HitRecord rec;
-        if (hittable_world->hit(hittable_world, r, interval_make(1e-4, INFINITY), &rec)) {
+        if (rec != NULL) {
             Ray scattered;
             Color attenuation;
-            if (rec.mat->scatter(rec.mat, r, &rec, &attenuation, &scattered)) {
-                return vec3_mul(
-                    ray_color(scattered, depth - 1, hittable_world, background),
-                    attenuation);
+            uint32_t bounce_dimension = sampler_dimension(sampler);
+            if (rec->mat->scatter(rec->mat, r, rec, sampler, &attenuation,
+                                  &scattered)) {
+                sampler_set_dimension(sampler,
+                                      bounce_dimension + BOUNCE_REQUESTS);
+                return vec3_mul(ray_color(scattered, depth - 1, hittable_world,
+                                          lights, background, sampler, -1.0,
+                                          vec3_zero()),
+                                attenuation);
             }
             return (Color){0, 0, 0};
         }
 
-        Vec3 unit_direction = vec3_normalized(r.direction);
-        double a = (unit_direction.y + 1) * 0.5;
-        return vec3_add((Vec3){1.0 - a, 1.0 - a, 1.0 - a},
-                        (Vec3){0.5 * a, 0.7 * a, 1.0 * a});
+        return camera_sky_color(r);
+    }
+}
+
+// Traces `r` and shades it, see shade_ray.
+static Color ray_color(Ray r, int depth, Hittable *hittable_world,
+                       const LightList *lights, Color background,
+                       Sampler *sampler, double scatter_pdf,
+                       Vec3 scatter_normal) {
+    if (depth <= 0)
+        return vec3_zero();
+
+    HitRecord rec;
+    STATS_INC(rays);
+    if (!hittable_world->hit(hittable_world, r, interval_make(0, INFINITY),
+                             &rec)) {
+        return shade_ray(r, NULL, depth, hittable_world, lights, background,
+                         sampler, scatter_pdf, scatter_normal);
     }
+    hittable_finalize(&rec, r);
+    return shade_ray(r, &rec, depth, hittable_world, lights, background,
+                     sampler, scatter_pdf, scatter_normal);
 }
 
-// Construct a camera ray originating from the defocus disk and directed at a
-// randomly sampled point around the pixel location i, j.
-static Ray get_ray(const Camera *cam, int i, int j) {
-  Vec3 offset = vec3_sample_square();
+Ray camera_get_ray(const Camera *cam, int i, int j, Sampler *sampler) {
+  double u1, u2;
+  sampler_get_2d(sampler, &u1, &u2);
+  Vec3 offset = vec3_sample_square(u1, u2);
   Vec3 pixel_sample =
       vec3_add(cam->pixel00_loc, vec3_scale(cam->pixel_delta_u, i + offset.x));
   pixel_sample =
       vec3_add(pixel_sample, vec3_scale(cam->pixel_delta_v, j + offset.y));
 
   Vec3 ray_origin;
+  sampler_get_2d(sampler, &u1, &u2);
   if (cam->defocus_angle <= 0) {
     ray_origin = cam->center;
   } else {
     ray_origin = defocus_disk_sample(cam->center, cam->defocus_disk_u,
-                                     cam->defocus_disk_v);
+                                     cam->defocus_disk_v,
+                                     sample_uniform_disk_concentric(u1, u2));
   }
 
   return (Ray){.origin = ray_origin,
                .direction = vec3_sub(pixel_sample, ray_origin),
-               .time = random_double_range(0.0, 1.0)};
+               .time = sampler_get_1d(sampler)};
 }
 
-void camera_render(const Camera *cam, Hittable *hittable_world,
-                   FILE *out_file) {
-  fprintf(out_file, "P3\n%d %d\n255\n", cam->image_width, cam->image_height);
+// camera_get_ray for a whole tile: lane k of `packet` is the pixel
+// (i0 + k % PACKET_SIZE, j0 + k / PACKET_SIZE), drawing from samplers[k],
+// which must already be started on that pixel's sample. Lanes outside the
+// image are left inactive. The variates are drawn lane by lane, then the
+// rays are built one coordinate at a time over all lanes, which the
+// compiler turns into vector arithmetic.
+static void camera_get_packet(const Camera *cam, int i0, int j0,
+                              Sampler *samplers, RayPacket *packet) {
+  real px[PACKET_RAYS], py[PACKET_RAYS];
+  real lens_x[PACKET_RAYS], lens_y[PACKET_RAYS];
+  for (int k = 0; k < PACKET_RAYS; k++) {
+    int i = i0 + k % PACKET_SIZE;
+    int j = j0 + k / PACKET_SIZE;
+    packet->active[k] = i < cam->image_width && j < cam->image_height;
+    packet->t_max[k] = INFINITY;
+    if (!packet->active[k]) {
+      // Any finite ray; inactive lanes are never tested
+      px[k] = py[k] = lens_x[k] = lens_y[k] = 0.0;
+      packet->rays[k].time = 0.0;
+      continue;
+    }
+
+    double u1, u2;
+    sampler_get_2d(&samplers[k], &u1, &u2);
+    Vec3 offset = vec3_sample_square(u1, u2);
+    px[k] = i + offset.x;
+    py[k] = j + offset.y;
+    sampler_get_2d(&samplers[k], &u1, &u2);
+    Vec3 lens = cam->defocus_angle <= 0 ? vec3_zero()
+                                        : sample_uniform_disk_concentric(u1, u2);
+    lens_x[k] = lens.x;
+    lens_y[k] = lens.y;
+    packet->rays[k].time = sampler_get_1d(&samplers[k]);
+  }
+
+  for (int axis = 0; axis < 3; axis++) {
+    real pixel00 = vec3_axis(cam->pixel00_loc, axis);
+    real delta_u = vec3_axis(cam->pixel_delta_u, axis);
+    real delta_v = vec3_axis(cam->pixel_delta_v, axis);
+    real center = vec3_axis(cam->center, axis);
+    real disk_u = vec3_axis(cam->defocus_disk_u, axis);
+    real disk_v = vec3_axis(cam->defocus_disk_v, axis);
+    real *org = packet->org[axis];
+    real *dir = packet->inv_dir[axis]; // Filled with 1/d by prepare
+    for (int k = 0; k < PACKET_RAYS; k++) {
+      real pixel_sample = pixel00 + delta_u * px[k] + delta_v * py[k];
+      org[k] = center + disk_u * lens_x[k] + disk_v * lens_y[k];
+      dir[k] = pixel_sample - org[k];
+    }
+  }
+
+  for (int k = 0; k < PACKET_RAYS; k++) {
+    packet->rays[k].origin =
+        (Vec3){packet->org[0][k], packet->org[1][k], packet->org[2][k]};
+    packet->rays[k].direction = (Vec3){
+        packet->inv_dir[0][k], packet->inv_dir[1][k], packet->inv_dir[2][k]};
+  }
+  packet->t_min = 0;
+  ray_packet_prepare(packet);
+}
+
+// Renders PACKET_SIZE x PACKET_SIZE pixel tiles, tracing the camera rays of
+// one sample index across a tile as a packet. Bounces past the first are
+// traced one ray at a time as in render_rays.
+static void render_packets(const Camera *cam, Hittable *hittable_world,
+                           const LightList *lights, Color *pixels) {
+  Sampler sampler = sampler_make(cam->sampler, 0);
+  Sampler samplers[PACKET_RAYS];
+  RayPacket packet;
+  HitRecord recs[PACKET_RAYS];
+  for (int j0 = 0; j0 < cam->image_height; j0 += PACKET_SIZE) {
+    int rows = j0 + PACKET_SIZE < cam->image_height ? j0 + PACKET_SIZE
+                                                    : cam->image_height;
+    update_progress_bar(rows, cam->image_height);
+    for (int i0 = 0; i0 < cam->image_width; i0 += PACKET_SIZE) {
+      for (int sample = 0; sample < cam->samples_per_pixel; sample++) {
+        for (int k = 0; k < PACKET_RAYS; k++) {
+          samplers[k] = sampler;
+          sampler_start_pixel_sample(&samplers[k], i0 + k % PACKET_SIZE,
+                                     j0 + k / PACKET_SIZE, sample);
+        }
+        camera_get_packet(cam, i0, j0, samplers, &packet);
+        hittable_hit_packet(hittable_world, &packet, packet.active, recs);
+
+        for (int k = 0; k < PACKET_RAYS; k++) {
+          if (!packet.active[k])
+            continue;
+          assert(sampler_dimension(&samplers[k]) == CAMERA_REQUESTS);
+          STATS_INC(rays);
+          Ray r = packet.rays[k];
+          HitRecord *rec = NULL;
+          if (packet.hit[k]) {
+            rec = &recs[k];
+            hittable_finalize(rec, r);
+          }
+          int pixel = (j0 + k / PACKET_SIZE) * cam->image_width + i0 +
+                      k % PACKET_SIZE;
+          pixels[pixel] = vec3_add(
+              pixels[pixel],
+              shade_ray(r, rec, cam->max_depth, hittable_world, lights,
+                        cam->background, &samplers[k], -1.0, vec3_zero()));
+        }
+      }
+    }
+  }
+}
+
+// Renders pixel by pixel, every ray traced on its own.
+static void render_rays(const Camera *cam, Hittable *hittable_world,
+                        const LightList *lights, Color *pixels) {
+  Sampler sampler = sampler_make(cam->sampler, 0);
   for (int j = 0; j < cam->image_height; j++) {
     update_progress_bar(j + 1, cam->image_height);
     for (int i = 0; i < cam->image_width; i++) {
       Vec3 pixel_color = vec3_zero();
       for (int sample = 0; sample < cam->samples_per_pixel; sample++) {
-        Ray r = get_ray(cam, i, j);
+        sampler_start_pixel_sample(&sampler, i, j, sample);
+        Ray r = camera_get_ray(cam, i, j, &sampler);
+        assert(sampler_dimension(&sampler) == CAMERA_REQUESTS);
         pixel_color =
             vec3_add(pixel_color, ray_color(r, cam->max_depth, hittable_world,
-                                            cam->background));
+                                            lights, cam->background, &sampler,
+                                            -1.0, vec3_zero()));
       }
-      write_color(out_file, vec3_divs(pixel_color, cam->samples_per_pixel));
+      pixels[j * cam->image_width + i] = pixel_color;
     }
   }
-}
\ No newline at end of file
+}
+
+void camera_render(const Camera *cam, Hittable *hittable_world,
+                   const LightList *lights, FILE *out_file) {
+  int pixel_count = cam->image_width * cam->image_height;
+  Color *pixels = calloc((size_t)pixel_count, sizeof(Color));
+  PANIC_IF(pixels == NULL, "camera: failed to allocate the image");
+
+  // Taken from the camera being rendered, which need not come from
+  // camera_make in this run (compiled scenes store it)
+  use_lighting = cam->is_lighting;
+  if (cam->primary_packets && cam->max_depth > 0)
+    render_packets(cam, hittable_world, lights, pixels);
+  else
+    render_rays(cam, hittable_world, lights, pixels);
+
+  fprintf(out_file, "P3\n%d %d\n255\n", cam->image_width, cam->image_height);
+  for (int k = 0; k < pixel_count; k++)
+    write_color(out_file, vec3_divs(pixels[k], cam->samples_per_pixel));
+  free(pixels);
+}
@@ -3,10 +3,19 @@
 
 #include "../core/color.h"
 #include "../core/dyn_array.h"
+#include "../core/sampler.h"
 #include "../core/vec3.h"
 #include "../hittable/hittable.h"
+#include "../light/light_list.h"
 #include <stdbool.h>
 
+// Sampler requests made for the camera ray (pixel, lens, time) and at every
+// bounce (BSDF, light). Each bounce starts on a fixed request number, so
+// request k means the same thing in every sample of a pixel even when a
+// bounce leaves some of its requests unused.
+#define CAMERA_REQUESTS 3
+#define BOUNCE_REQUESTS 2
+
 typedef struct Camera {
   int image_width;
   int image_height;
@@ -21,6 +30,11 @@ typedef struct Camera {
   Vec3 lookat;
   Vec3 vup;
   Color background;
+  bool is_lighting;    // Emitters and background light the scene, else a sky
+  SamplerType sampler; // Sobol unless overridden with --sampler
+  bool primary_packets; // Trace camera rays in tiles, unless --no-packets
+  int wavefront_paths;  // Paths in flight for wavefront_render
+  bool sort_rays;       // Reorder wavefront rays before tracing them
 
   // computed
   double pixel_samples_scale;
@@ -39,7 +53,31 @@ extern Camera camera_make(int image_width, double aspect_ratio, Vec3 lookfrom,
                           double defocus_angle, double focus_dist,
                           int samples_per_pixel, int max_depth,
                           Color background, bool is_lighting);
+// Renders the image. With lighting on, `lights` (may be NULL) are sampled
+// directly at every diffuse bounce. Unless `primary_packets` is off, camera
+// rays are traced as PACKET_SIZE x PACKET_SIZE tiles.
 extern void camera_render(const Camera *cam, Hittable *hittable_world,
-                          FILE *out_file);
+                          const LightList *lights, FILE *out_file);
+
+// Pieces of the integrator shared with the wavefront renderer.
+
+// Constructs a camera ray originating from the defocus disk and directed at
+// a randomly sampled point around the pixel location i, j. Makes the
+// CAMERA_REQUESTS requests of the current sample.
+extern Ray camera_get_ray(const Camera *cam, int i, int j, Sampler *sampler);
+
+// Next-event estimation at a non-delta hit, without the visibility test:
+// samples one emitter and returns the shadow ray, its t interval and the
+// radiance it carries if unoccluded, MIS weighted against the chance that
+// the BSDF would have sampled the same direction. Returns false if the
+// sample contributes nothing.
+extern bool camera_sample_direct_light(const HitRecord *rec, Ray r_in,
+                                       const LightList *lights,
+                                       Sampler *sampler, Ray *shadow,
+                                       Interval *shadow_t,
+                                       Color *contribution);
+
+// Radiance of a ray that leaves the scene when lighting is off.
+extern Color camera_sky_color(Ray r);
 
 #endif // CAMERA_H
\ No newline at end of file
@@ -1,22 +1,68 @@
+#include <stdio.h>
+
 #include "scene.h"
+#include "scene_snapshot.h"
+#include "core/arena.h"
 #include "core/dyn_array.h"
 #include "core/generic_types.h"
+#include "hittable/bvh_node.h"
 #include "hittable/hittable.h"
 #include "hittable/hittable_list.h"
+#include "hittable/lazy_hittable.h"
+#include "light/light_list.h"
 #include "material/material.h"
 #include "texture/texture.h"
 
 Scene scene_create() {
   Scene scene;
+  scene.arena = arena_create();
+  rt_set_arena(scene.arena);
   scene.objects = hittablelist_empty();
   scene.materials = dynarray_create(2, (GPrintFn)material_print,
                                     (GDestroyFn)material_destroy);
   scene.textures = dynarray_create(2, NULL,
                                     (GDestroyFn)texture_destroy);
+  scene.bvh = NULL;
+  scene.world = NULL;
+  scene.lights = NULL;
+  scene.snapshot = NULL;
   return scene;
 }
 
 void scene_destroy(Scene *self) {
+  if (self->lights) {
+    lightlist_destroy(self->lights);
+    self->lights = NULL;
+  }
+  if (self->snapshot) {
+    scene_snapshot_release(self->snapshot);
+    self->snapshot = NULL;
+    self->world = NULL;
+    self->bvh = NULL;
+  }
+  if (self->arena) {
+    // Objects, BVH nodes, materials and textures all live in the arena, so
+    // only the malloc'd containers indexing them need releasing first.
+    // Paged meshes close their files from the arena's cleanups.
+    if (self->world && self->world != self->bvh &&
+        self->world != self->objects) {
+      dynarray_release(self->world->data);
+    }
+    dynarray_release(self->objects->data);
+    dynarray_release(self->materials);
+    dynarray_release(self->textures);
+    arena_destroy(self->arena);
+    self->arena = NULL;
+    return;
+  }
+
+  if (self->world && self->world != self->bvh &&
+      self->world != self->objects) {
+    self->world->destroy(self->world);
+  }
+  if (self->bvh) {
+    self->bvh->destroy(self->bvh);
+  }
   self->objects->destroy(self->objects);
   dynarray_destroy(self->materials);
   dynarray_destroy(self->textures);
@@ -35,4 +81,81 @@ Material *scene_add_material(Scene *self, Material *mat) {
 Texture *scene_add_texture(Scene *self, Texture *tex) {
     dynarray_push(self->textures, tex);
     return tex;
-}
\ No newline at end of file
+}
+int scene_bake_transforms(Scene *self) {
+  DynArray *objects = (DynArray *)self->objects->data;
+  int removed = 0;
+
+  self->objects->bbox = aabb_empty();
+  for (int i = 0; i < dynarray_size(objects); i++) {
+    Hittable *obj = hittable_bake_transforms(dynarray_get(objects, i), &removed);
+    dynarray_set(objects, i, obj);
+    self->objects->bbox = aabb_surrounding_box(&self->objects->bbox, &obj->bbox);
+  }
+  return removed;
+}
+
+int scene_load_lazy(Scene *self) {
+  DynArray *objects = (DynArray *)self->objects->data;
+  int loaded = 0;
+  int kept = 0;
+  for (int i = 0; i < dynarray_size(objects); i++) {
+    Hittable *obj = dynarray_get(objects, i);
+    if (obj->type == HITTABLE_LAZY) {
+      obj = lazy_hittable_resolve(obj);
+      loaded++;
+    }
+    // Proxies whose model failed to load leave nothing behind
+    if (obj)
+      dynarray_set(objects, kept++, obj);
+  }
+  while (dynarray_size(objects) > kept)
+    dynarray_pop(objects);
+  return loaded;
+}
+
+Hittable *scene_build_world(Scene *self, bool use_bvh) {
+  DynArray *objects = (DynArray *)self->objects->data;
+
+  Hittable *bounded = hittablelist_empty();
+  Hittable *unbounded = hittablelist_empty();
+  for (int i = 0; i < dynarray_size(objects); i++) {
+    Hittable *obj = dynarray_get(objects, i);
+    hittablelist_add(aabb_is_bounded(&obj->bbox) ? bounded : unbounded, obj);
+  }
+
+  self->lights = lightlist_create(self->objects);
+  printf("Lights: %d emitters sampled directly (light BVH: %d nodes)\n",
+         lightlist_size(self->lights), lightbvh_node_count(self->lights->bvh));
+
+  int bounded_count = dynarray_size((DynArray *)bounded->data);
+  int unbounded_count = dynarray_size((DynArray *)unbounded->data);
+  printf("World: %d bounded objects, %d unbounded objects\n", bounded_count,
+         unbounded_count);
+
+  if (!use_bvh || bounded_count == 0) {
+    bounded->destroy(bounded);
+    unbounded->destroy(unbounded);
+    self->world = self->objects;
+    return self->world;
+  }
+
+  self->bvh = bvhnode_create(bounded);
+  bounded->destroy(bounded);
+
+  if (unbounded_count == 0) {
+    unbounded->destroy(unbounded);
+    self->world = self->bvh;
+  } else {
+    // Test the BVH first so its hit tightens the interval for the planes
+    Hittable *world = hittablelist_empty();
+    hittablelist_add(world, self->bvh);
+    DynArray *infinite = (DynArray *)unbounded->data;
+    for (int i = 0; i < unbounded_count; i++) {
+      hittablelist_add(world, dynarray_get(infinite, i));
+    }
+    unbounded->destroy(unbounded);
+    self->world = world;
+  }
+  return self->world;
+}
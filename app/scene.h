@@ -1,17 +1,39 @@
 #ifndef SCENE_H
 #define SCENE_H
 
+#include "../core/arena.h"
 #include "../core/dyn_array.h"
 #include "../hittable/hittable.h"
+#include "../light/light_list.h"
 #include "../material/material.h"
 #include "../texture/texture.h"
 
+typedef struct SceneSnapshot SceneSnapshot;
+
 typedef struct Scene {
   Hittable *objects;
   DynArray *materials;
   DynArray *textures;
+
+  // Built by scene_build_world: the BVH over bounded objects, and the
+  // top-level hittable to render (the BVH plus any unbounded primitives).
+  Hittable *bvh;
+  Hittable *world;
+
+  // Emitters sampled explicitly by the integrator, also built by
+  // scene_build_world.
+  LightList *lights;
+
+  // Backing store for every hittable, material and texture created while the
+  // scene is alive; released in one step by scene_destroy.
+  Arena *arena;
+
+  // Set when the world was loaded from a compiled scene (scene_snapshot.h)
+  // instead of built: world and bvh then live in the snapshot's mapping.
+  SceneSnapshot *snapshot;
 } Scene;
 
+// Creates the scene's arena and makes it the active allocation target.
 extern Scene scene_create(void);
 extern void scene_destroy(Scene *self);
 
@@ -19,4 +41,18 @@ extern Hittable *scene_add_obj(Scene *self, Hittable *obj);
 extern Material *scene_add_material(Scene *self, Material *mat);
 extern Texture *scene_add_texture(Scene *self, Texture *tex);
 
+// Scene compilation pass run after parsing and before the BVH build: folds
+// static translate/rotate_y wrappers into the primitives they wrap. Returns
+// the number of wrapper nodes removed.
+extern int scene_bake_transforms(Scene *self);
+
+// Loads every lazy proxy (obj_model with `lazy on`) in the object list now
+// and puts what it loaded in its place, for scenes that are saved rather
+// than rendered. Returns the number of proxies loaded.
+extern int scene_load_lazy(Scene *self);
+
+// Builds the hittable to render. Unbounded primitives (infinite planes) are
+// kept out of the BVH and tested alongside it in a small top-level list.
+extern Hittable *scene_build_world(Scene *self, bool use_bvh);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,609 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "scene_snapshot.h"
+#include "core/arena.h"
+#include "core/debug.h"
+#include "core/dyn_array.h"
+#include "core/generic_types.h"
+#include "hittable/hittable.h"
+#include "hittable/hittable_list.h"
+#include "light/light_list.h"
+#include "material/material.h"
+#include "texture/checkered.h"
+#include "texture/solid_color.h"
+#include "texture/texture.h"
+
+#define SNAPSHOT_MAGIC "RTSCENE\n"
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_NONE UINT64_MAX
+// Arena allocations are 16-byte aligned, so the image starts on a multiple
+// of that and one visited bit covers each 16-byte slot
+#define SNAPSHOT_ALIGN 16
+#define SNAPSHOT_ROUND_UP(n, a) (((n) + (a) - 1) & ~((uint64_t)(a) - 1))
+// Relocations are stored as uint32 indices of 8-byte words
+#define SNAPSHOT_MAX_IMAGE ((uint64_t)UINT32_MAX * sizeof(uint64_t))
+
+typedef struct SnapshotHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t header_size;
+  // The executable that wrote the file; code offsets are only valid in it
+  uint64_t build_size;
+  int64_t build_mtime_sec;
+  int64_t build_mtime_nsec;
+  Camera camera;
+  // Sections, as byte offsets from the start of the file
+  uint64_t image_offset, image_size;
+  uint64_t data_reloc_offset, data_reloc_count; // uint32 word indices
+  uint64_t code_reloc_offset, code_reloc_count; // uint32 word indices
+  uint64_t list_offset, list_words; // {list, n, n element offsets}, uint64
+  uint64_t light_offset, light_count; // uint64 image offsets
+  // Image offsets of the roots, SNAPSHOT_NONE if the scene has none
+  uint64_t world, bvh;
+} SnapshotHeader;
+
+_Static_assert(sizeof(void *) == sizeof(uint64_t),
+               "pointers are stored as 64-bit offsets");
+
+struct SceneSnapshot {
+  char *map;
+  size_t size;
+  DynArray **lists; // Rebuilt element arrays of the list nodes
+  size_t list_count;
+};
+
+// Code pointers are stored relative to this function
+static uintptr_t code_base(void) { return (uintptr_t)&scene_snapshot_write; }
+
+static bool build_stamp(SnapshotHeader *header) {
+  struct stat st;
+  if (stat("/proc/self/exe", &st) != 0)
+    return false;
+  header->build_size = (uint64_t)st.st_size;
+  header->build_mtime_sec = (int64_t)st.st_mtim.tv_sec;
+  header->build_mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+  return true;
+}
+
+typedef struct U64Array {
+  uint64_t *data;
+  size_t size;
+  size_t capacity;
+} U64Array;
+
+static void u64_push(U64Array *self, uint64_t value) {
+  if (self->size == self->capacity) {
+    self->capacity = self->capacity ? self->capacity * 2 : 256;
+    self->data = realloc(self->data, self->capacity * sizeof(uint64_t));
+    PANIC_IF(self->data == NULL, "snapshot: out of memory");
+  }
+  self->data[self->size++] = value;
+}
+
+// Relocation table: image word indices of the pointers to patch
+typedef struct RelocArray {
+  uint32_t *data;
+  size_t size;
+  size_t capacity;
+} RelocArray;
+
+static void reloc_push(RelocArray *self, uint64_t at) {
+  if (self->size == self->capacity) {
+    self->capacity = self->capacity ? self->capacity * 2 : 256;
+    self->data = realloc(self->data, self->capacity * sizeof(uint32_t));
+    PANIC_IF(self->data == NULL, "snapshot: out of memory");
+  }
+  self->data[self->size++] = (uint32_t)(at / sizeof(uint64_t));
+}
+
+typedef struct ChunkRange {
+  const char *begin;
+  size_t size;
+  uint64_t offset; // Where the chunk starts in the image
+} ChunkRange;
+
+typedef struct SnapshotWriter {
+  ChunkRange *chunks; // Sorted by address once gathered
+  size_t chunk_count;
+  size_t chunk_capacity;
+  char *image;
+  uint64_t image_size;
+  uint8_t *visited; // One bit per SNAPSHOT_ALIGN bytes of image
+  RelocArray data_relocs, code_relocs;
+  U64Array lists, lights;
+} SnapshotWriter;
+
+static void writer_add_chunk(const void *data, size_t size, void *ctx) {
+  SnapshotWriter *w = ctx;
+  if (size == 0)
+    return;
+  if (w->chunk_count == w->chunk_capacity) {
+    w->chunk_capacity = w->chunk_capacity ? w->chunk_capacity * 2 : 16;
+    w->chunks = realloc(w->chunks, w->chunk_capacity * sizeof(ChunkRange));
+    PANIC_IF(w->chunks == NULL, "snapshot: out of memory");
+  }
+  w->chunks[w->chunk_count++] = (ChunkRange){data, size, 0};
+}
+
+static int chunk_compare(const void *a, const void *b) {
+  const char *x = ((const ChunkRange *)a)->begin;
+  const char *y = ((const ChunkRange *)b)->begin;
+  return x < y ? -1 : x > y;
+}
+
+// Image offset of `ptr`, which must point into the scene's arena.
+static uint64_t writer_offset(const SnapshotWriter *w, const void *ptr) {
+  const char *p = ptr;
+  size_t lo = 0, hi = w->chunk_count;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (p < w->chunks[mid].begin)
+      hi = mid;
+    else if (p >= w->chunks[mid].begin + w->chunks[mid].size)
+      lo = mid + 1;
+    else
+      return w->chunks[mid].offset + (uint64_t)(p - w->chunks[mid].begin);
+  }
+  PANIC("snapshot: %p is not in the scene arena", ptr);
+}
+
+// Marks the object at `ptr` visited; false if it already was.
+static bool writer_visit(SnapshotWriter *w, const void *ptr) {
+  uint64_t slot = writer_offset(w, ptr) / SNAPSHOT_ALIGN;
+  uint8_t bit = (uint8_t)(1u << (slot % 8));
+  if (w->visited[slot / 8] & bit)
+    return false;
+  w->visited[slot / 8] |= bit;
+  return true;
+}
+
+static void writer_store(SnapshotWriter *w, uint64_t at, uint64_t value) {
+  memcpy(w->image + at, &value, sizeof(value));
+}
+
+// Replaces the pointer at `field` (in the arena) to `target` by the target's
+// image offset. NULL pointers stay 0 and need no relocation.
+static void writer_data(SnapshotWriter *w, const void *field,
+                        const void *target) {
+  uint64_t at = writer_offset(w, field);
+  if (target == NULL)
+    return;
+  writer_store(w, at, writer_offset(w, target));
+  reloc_push(&w->data_relocs, at);
+}
+
+// Replaces the function pointer at `field` by its offset from code_base.
+static void writer_code(SnapshotWriter *w, const void *field) {
+  uintptr_t fn;
+  memcpy(&fn, field, sizeof(fn));
+  if (fn == 0)
+    return;
+  uint64_t at = writer_offset(w, field);
+  writer_store(w, at, (uint64_t)(fn - code_base()));
+  reloc_push(&w->code_relocs, at);
+}
+
+static void writer_texture(SnapshotWriter *w, Texture *tex) {
+  if (!writer_visit(w, tex))
+    return;
+  writer_code(w, &tex->value);
+  writer_code(w, &tex->destroy);
+  if (tex->value == checkered_value) {
+    Checkered *checkered = (Checkered *)tex;
+    writer_data(w, &checkered->even, checkered->even);
+    writer_data(w, &checkered->odd, checkered->odd);
+    writer_texture(w, checkered->even);
+    writer_texture(w, checkered->odd);
+  } else {
+    PANIC_IF(tex->value != solid_color_value,
+             "snapshot: unknown texture type");
+  }
+}
+
+static void writer_material(SnapshotWriter *w, Material *mat) {
+  if (!writer_visit(w, mat))
+    return;
+  writer_code(w, &mat->scatter);
+  writer_code(w, &mat->destroy);
+  writer_code(w, &mat->emitted);
+  writer_code(w, &mat->eval);
+  writer_code(w, &mat->pdf);
+  writer_code(w, &mat->is_delta);
+  writer_data(w, &mat->data, mat->data);
+
+  Texture **slot = material_texture_slot(mat);
+  if (slot && *slot) {
+    writer_data(w, slot, *slot);
+    writer_texture(w, *slot);
+  }
+}
+
+static void writer_hittable(SnapshotWriter *w, Hittable *obj) {
+  PANIC_IF(obj->type == HITTABLE_LAZY,
+           "snapshot: lazy models must be loaded first (scene_load_lazy)");
+  PANIC_IF(obj->type == HITTABLE_PAGED_MESH,
+           "snapshot: paged models are refused by scene_snapshot_write");
+  if (!writer_visit(w, obj))
+    return;
+  writer_code(w, &obj->hit);
+  writer_code(w, &obj->finalize);
+  writer_code(w, &obj->occluded);
+  writer_code(w, &obj->destroy);
+  if (obj->mat) {
+    writer_data(w, &obj->mat, obj->mat);
+    writer_material(w, obj->mat);
+  }
+
+  if (obj->type == HITTABLE_LIST) {
+    // The element array is malloc'd; record the elements so the load can
+    // rebuild it, and leave the pointer empty in the image
+    DynArray *elems = obj->data;
+    int n = dynarray_size(elems);
+    writer_store(w, writer_offset(w, &obj->data), 0);
+    u64_push(&w->lists, writer_offset(w, obj));
+    u64_push(&w->lists, (uint64_t)n);
+    for (int i = 0; i < n; i++)
+      u64_push(&w->lists, writer_offset(w, dynarray_get(elems, i)));
+    for (int i = 0; i < n; i++)
+      writer_hittable(w, dynarray_get(elems, i));
+    return;
+  }
+
+  writer_data(w, &obj->data, obj->data);
+  Hittable **slots[2];
+  int n = hittable_child_slots(obj, slots);
+  for (int i = 0; i < n; i++) {
+    writer_data(w, slots[i], *slots[i]);
+    writer_hittable(w, *slots[i]);
+  }
+}
+
+// True if `obj` is or contains a paged model. Those keep their triangles in
+// a page file, outside the arena, and cannot be compiled.
+static bool contains_paged_mesh(Hittable *obj) {
+  if (obj->type == HITTABLE_PAGED_MESH)
+    return true;
+  if (obj->type == HITTABLE_LIST) {
+    DynArray *elems = obj->data;
+    for (int i = 0; i < dynarray_size(elems); i++)
+      if (contains_paged_mesh(dynarray_get(elems, i)))
+        return true;
+    return false;
+  }
+  Hittable **slots[2];
+  int n = hittable_child_slots(obj, slots);
+  for (int i = 0; i < n; i++)
+    if (contains_paged_mesh(*slots[i]))
+      return true;
+  return false;
+}
+
+static void writer_release(SnapshotWriter *w) {
+  free(w->chunks);
+  free(w->image);
+  free(w->visited);
+  free(w->data_relocs.data);
+  free(w->code_relocs.data);
+  free(w->lists.data);
+  free(w->lights.data);
+}
+
+static bool write_section(FILE *file, uint64_t *position, uint64_t offset,
+                          const void *data, size_t size) {
+  static const char zeros[SNAPSHOT_ALIGN];
+  if (offset > *position &&
+      fwrite(zeros, 1, offset - *position, file) != offset - *position)
+    return false;
+  if (size > 0 && fwrite(data, 1, size, file) != size)
+    return false;
+  *position = offset + size;
+  return true;
+}
+
+bool scene_snapshot_write(const char *path, const Scene *scene,
+                          const Camera *cam, char *error, size_t error_size) {
+  assert(scene->world != NULL);
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  if (!build_stamp(&header)) {
+    snprintf(error, error_size, "cannot stat the running executable");
+    return false;
+  }
+
+  if (contains_paged_mesh(scene->objects)) {
+    snprintf(error, error_size,
+             "paged models stay on disk and cannot be compiled");
+    return false;
+  }
+
+  SnapshotWriter w;
+  memset(&w, 0, sizeof(w));
+  arena_each_chunk(scene->arena, writer_add_chunk, &w);
+  qsort(w.chunks, w.chunk_count, sizeof(ChunkRange), chunk_compare);
+  for (size_t i = 0; i < w.chunk_count; i++) {
+    w.chunks[i].offset = w.image_size;
+    w.image_size += SNAPSHOT_ROUND_UP(w.chunks[i].size, SNAPSHOT_ALIGN);
+  }
+  if (w.image_size > SNAPSHOT_MAX_IMAGE) {
+    snprintf(error, error_size, "scene arena too large (%llu bytes)",
+             (unsigned long long)w.image_size);
+    writer_release(&w);
+    return false;
+  }
+  w.image = calloc(w.image_size > 0 ? w.image_size : 1, 1);
+  w.visited = calloc(w.image_size / SNAPSHOT_ALIGN / 8 + 1, 1);
+  PANIC_IF(w.image == NULL || w.visited == NULL, "snapshot: out of memory");
+  for (size_t i = 0; i < w.chunk_count; i++)
+    memcpy(w.image + w.chunks[i].offset, w.chunks[i].begin, w.chunks[i].size);
+
+  writer_hittable(&w, scene->world);
+  if (scene->bvh)
+    writer_hittable(&w, scene->bvh);
+  DynArray *lights = scene->lights->lights;
+  for (int i = 0; i < dynarray_size(lights); i++) {
+    Hittable *light = dynarray_get(lights, i);
+    writer_hittable(&w, light);
+    u64_push(&w.lights, writer_offset(&w, light));
+  }
+
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+  header.version = SNAPSHOT_VERSION;
+  header.header_size = sizeof(header);
+  header.camera = *cam;
+  header.image_offset = SNAPSHOT_ROUND_UP(sizeof(header), SNAPSHOT_ALIGN);
+  header.image_size = w.image_size;
+  header.data_reloc_offset = header.image_offset + w.image_size;
+  header.data_reloc_count = w.data_relocs.size;
+  header.code_reloc_offset = SNAPSHOT_ROUND_UP(
+      header.data_reloc_offset + w.data_relocs.size * sizeof(uint32_t),
+      sizeof(uint64_t));
+  header.code_reloc_count = w.code_relocs.size;
+  header.list_offset = SNAPSHOT_ROUND_UP(
+      header.code_reloc_offset + w.code_relocs.size * sizeof(uint32_t),
+      sizeof(uint64_t));
+  header.list_words = w.lists.size;
+  header.light_offset = header.list_offset + w.lists.size * sizeof(uint64_t);
+  header.light_count = w.lights.size;
+  header.world = writer_offset(&w, scene->world);
+  header.bvh = scene->bvh ? writer_offset(&w, scene->bvh) : SNAPSHOT_NONE;
+
+  FILE *file = fopen(path, "wb");
+  if (!file) {
+    snprintf(error, error_size, "cannot create %s: %s", path, strerror(errno));
+    writer_release(&w);
+    return false;
+  }
+  uint64_t position = 0;
+  bool ok =
+      write_section(file, &position, 0, &header, sizeof(header)) &&
+      write_section(file, &position, header.image_offset, w.image,
+                    w.image_size) &&
+      write_section(file, &position, header.data_reloc_offset,
+                    w.data_relocs.data, w.data_relocs.size * sizeof(uint32_t)) &&
+      write_section(file, &position, header.code_reloc_offset,
+                    w.code_relocs.data, w.code_relocs.size * sizeof(uint32_t)) &&
+      write_section(file, &position, header.list_offset, w.lists.data,
+                    w.lists.size * sizeof(uint64_t)) &&
+      write_section(file, &position, header.light_offset, w.lights.data,
+                    w.lights.size * sizeof(uint64_t));
+  ok = fclose(file) == 0 && ok;
+  writer_release(&w);
+  if (!ok) {
+    snprintf(error, error_size, "failed writing %s: %s", path,
+             strerror(errno));
+    remove(path);
+  }
+  return ok;
+}
+
+bool scene_snapshot_is_snapshot(const char *path) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+  char magic[sizeof(SNAPSHOT_MAGIC) - 1];
+  bool is_snapshot = fread(magic, sizeof(magic), 1, file) == 1 &&
+                     memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+  fclose(file);
+  return is_snapshot;
+}
+
+// True if a Hittable can start at image offset `at`.
+static bool object_fits(const SnapshotHeader *header, uint64_t at) {
+  return at % SNAPSHOT_ALIGN == 0 && at < header->image_size &&
+         header->image_size - at >= sizeof(Hittable);
+}
+
+// True if `count` items of `item` bytes at `offset` fit in a `size` byte
+// file.
+static bool section_fits(uint64_t offset, uint64_t count, uint64_t item,
+                         uint64_t size) {
+  return offset <= size && count <= (size - offset) / item;
+}
+
+static bool header_valid(const SnapshotHeader *header, size_t size,
+                         char *error, size_t error_size) {
+  SnapshotHeader build;
+  if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != SNAPSHOT_VERSION ||
+      header->header_size != sizeof(SnapshotHeader)) {
+    snprintf(error, error_size, "not a version %d scene snapshot",
+             SNAPSHOT_VERSION);
+    return false;
+  }
+  if (!build_stamp(&build) || build.build_size != header->build_size ||
+      build.build_mtime_sec != header->build_mtime_sec ||
+      build.build_mtime_nsec != header->build_mtime_nsec) {
+    snprintf(error, error_size,
+             "written by a different build of the renderer; compile the "
+             "scene again");
+    return false;
+  }
+  if (header->image_offset % SNAPSHOT_ALIGN != 0 ||
+      header->image_size % SNAPSHOT_ALIGN != 0 ||
+      !section_fits(header->image_offset, header->image_size, 1, size) ||
+      !section_fits(header->data_reloc_offset, header->data_reloc_count,
+                    sizeof(uint32_t), size) ||
+      !section_fits(header->code_reloc_offset, header->code_reloc_count,
+                    sizeof(uint32_t), size) ||
+      header->list_offset % sizeof(uint64_t) != 0 ||
+      !section_fits(header->list_offset, header->list_words,
+                    sizeof(uint64_t), size) ||
+      header->light_offset % sizeof(uint64_t) != 0 ||
+      !section_fits(header->light_offset, header->light_count,
+                    sizeof(uint64_t), size) ||
+      !object_fits(header, header->world) ||
+      (header->bvh != SNAPSHOT_NONE && !object_fits(header, header->bvh))) {
+    snprintf(error, error_size, "truncated or corrupt scene snapshot");
+    return false;
+  }
+  return true;
+}
+
+// Applies the relocation tables to the mapped image. Returns false if one
+// of them points outside it.
+static bool apply_relocations(const SnapshotHeader *header, char *map) {
+  char *image = map + header->image_offset;
+  uint64_t words = header->image_size / sizeof(uint64_t);
+
+  const uint32_t *data = (const uint32_t *)(map + header->data_reloc_offset);
+  for (uint64_t i = 0; i < header->data_reloc_count; i++) {
+    if (data[i] >= words)
+      return false;
+    uint64_t offset;
+    memcpy(&offset, image + data[i] * sizeof(uint64_t), sizeof(offset));
+    if (offset >= header->image_size)
+      return false;
+    char *target = image + offset;
+    memcpy(image + data[i] * sizeof(uint64_t), &target, sizeof(target));
+  }
+
+  uintptr_t base = code_base();
+  const uint32_t *code = (const uint32_t *)(map + header->code_reloc_offset);
+  for (uint64_t i = 0; i < header->code_reloc_count; i++) {
+    if (code[i] >= words)
+      return false;
+    uintptr_t fn;
+    memcpy(&fn, image + code[i] * sizeof(uint64_t), sizeof(fn));
+    fn += base;
+    memcpy(image + code[i] * sizeof(uint64_t), &fn, sizeof(fn));
+  }
+  return true;
+}
+
+// Rebuilds the element arrays of the list nodes.
+static bool rebuild_lists(SceneSnapshot *self, const SnapshotHeader *header) {
+  char *image = self->map + header->image_offset;
+  const uint64_t *words = (const uint64_t *)(self->map + header->list_offset);
+  uint64_t at = 0;
+  size_t capacity = 0;
+  while (at < header->list_words) {
+    if (header->list_words - at < 2)
+      return false;
+    uint64_t list = words[at], n = words[at + 1];
+    at += 2;
+    if (!object_fits(header, list) || n > header->list_words - at ||
+        n > INT32_MAX)
+      return false;
+    Hittable *obj = (Hittable *)(image + list);
+    if (obj->type != HITTABLE_LIST)
+      return false;
+
+    DynArray *elems = dynarray_create(n > 0 ? (int)n : 1,
+                                      (GPrintFn)hittable_print,
+                                      (GDestroyFn)hittable_destroy);
+    if (self->list_count == capacity) {
+      capacity = capacity ? capacity * 2 : 4;
+      self->lists = realloc(self->lists, capacity * sizeof(DynArray *));
+      PANIC_IF(self->lists == NULL, "snapshot: out of memory");
+    }
+    self->lists[self->list_count++] = elems;
+    obj->data = elems;
+    for (uint64_t i = 0; i < n; i++) {
+      if (!object_fits(header, words[at + i]))
+        return false;
+      dynarray_push(elems, image + words[at + i]);
+    }
+    at += n;
+  }
+  return true;
+}
+
+bool scene_snapshot_load(const char *path, Scene *scene, Camera *cam,
+                         char *error, size_t error_size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    snprintf(error, error_size, "cannot open %s: %s", path, strerror(errno));
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(SnapshotHeader)) {
+    close(fd);
+    snprintf(error, error_size, "truncated or corrupt scene snapshot");
+    return false;
+  }
+  // Private and writable: relocation patches pages in memory only, and
+  // pages it never touches are read straight from the page cache
+  size_t size = (size_t)st.st_size;
+  char *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    snprintf(error, error_size, "cannot map %s: %s", path, strerror(errno));
+    return false;
+  }
+
+  SceneSnapshot *self = calloc(1, sizeof(SceneSnapshot));
+  assert(self != NULL);
+  self->map = map;
+  self->size = size;
+  const SnapshotHeader *header = (const SnapshotHeader *)map;
+  if (!header_valid(header, size, error, error_size)) {
+    scene_snapshot_release(self);
+    return false;
+  }
+  if (!apply_relocations(header, map) || !rebuild_lists(self, header)) {
+    snprintf(error, error_size, "truncated or corrupt scene snapshot");
+    scene_snapshot_release(self);
+    return false;
+  }
+
+  char *image = map + header->image_offset;
+  const uint64_t *lights = (const uint64_t *)(map + header->light_offset);
+  Hittable *emitters = hittablelist_empty();
+  for (uint64_t i = 0; i < header->light_count; i++) {
+    if (!object_fits(header, lights[i])) {
+      dynarray_release(emitters->data);
+      snprintf(error, error_size, "truncated or corrupt scene snapshot");
+      scene_snapshot_release(self);
+      return false;
+    }
+    hittablelist_add(emitters, (Hittable *)(image + lights[i]));
+  }
+  scene->lights = lightlist_create(emitters);
+  dynarray_release(emitters->data);
+
+  scene->snapshot = self;
+  scene->world = (Hittable *)(image + header->world);
+  scene->bvh =
+      header->bvh != SNAPSHOT_NONE ? (Hittable *)(image + header->bvh) : NULL;
+  *cam = header->camera;
+  return true;
+}
+
+void scene_snapshot_release(SceneSnapshot *self) {
+  if (self == NULL)
+    return;
+  for (size_t i = 0; i < self->list_count; i++)
+    dynarray_release(self->lists[i]);
+  free(self->lists);
+  munmap(self->map, self->size);
+  free(self);
+}
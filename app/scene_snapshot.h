@@ -0,0 +1,46 @@
+#ifndef SCENE_SNAPSHOT_H
+#define SCENE_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "camera.h"
+#include "scene.h"
+
+// A prepared scene saved by `--compile-scene`: the camera and everything in
+// the scene's arena (objects, BVH nodes, materials, textures) once the
+// world has been built, so that later runs map one file instead of parsing
+// the scene, loading its OBJ files and building the BVH.
+//
+// The arena is stored as an image in which every pointer between scene
+// objects holds an offset into the image, and every vtable entry an offset
+// from a function in this program. Loading maps the file copy-on-write and
+// adds the image and code addresses back in one pass over a table of those
+// locations; only the DynArrays of list nodes and the light list are
+// rebuilt. Code offsets only hold for the executable that wrote them, so
+// the file records that executable's size and modification time and any
+// other build refuses it.
+#define SCENE_SNAPSHOT_EXTENSION ".rtscene"
+
+typedef struct SceneSnapshot SceneSnapshot;
+
+// Writes `scene`, after scene_build_world, and `cam` to `path`. Returns
+// false with the reason in `error` if it cannot.
+extern bool scene_snapshot_write(const char *path, const Scene *scene,
+                                 const Camera *cam, char *error,
+                                 size_t error_size);
+
+// True if `path` is a file that starts like a snapshot.
+extern bool scene_snapshot_is_snapshot(const char *path);
+
+// Loads a snapshot into `scene`, fresh from scene_create, and `cam`. The
+// scene's world, bvh and lights are set and the scene keeps the mapping
+// until scene_destroy. Returns false with the reason in `error` if the file
+// is not a snapshot from this build.
+extern bool scene_snapshot_load(const char *path, Scene *scene, Camera *cam,
+                                char *error, size_t error_size);
+
+// Unmaps the snapshot and frees the containers rebuilt by the load.
+extern void scene_snapshot_release(SceneSnapshot *self);
+
+#endif // SCENE_SNAPSHOT_H
@@ -0,0 +1,388 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "camera.h"
+#include "core/color.h"
+#include "core/debug.h"
+#include "core/perf_counters.h"
+#include "core/sampler.h"
+#include "core/sampling.h"
+#include "core/stats.h"
+#include "core/vec3.h"
+#include "hittable/hittable.h"
+#include "light/light_list.h"
+#include "material/material.h"
+#include "progress.h"
+#include "wavefront.h"
+
+#define MATERIAL_TYPES (MATERIAL_DIFFUSE_LIGHT + 1)
+
+// Bits per axis of the origin Morton code in a ray sort key. With the three
+// octant bits on top a key has 30 bits, sorted in three 10-bit passes.
+#define SORT_MORTON_BITS 9
+#define SORT_RADIX_BITS 10
+#define SORT_PASSES 3
+
+// Everything ray_color keeps on the stack between bounces, made explicit.
+typedef struct PathState {
+  Ray ray;
+  HitRecord rec;
+  Color throughput; // Product of the attenuations so far
+  Color radiance;   // Light gathered so far, already scaled by throughput
+  Vec3 scatter_normal;
+  double scatter_pdf; // As in ray_color: negative if emission counts in full
+  Sampler sampler;
+  int pixel;
+  int depth; // Bounces left
+} PathState;
+
+typedef struct ShadowRay {
+  Ray ray;
+  Interval t;
+  Color contribution; // Added to the path's radiance if unoccluded
+  int path;
+} ShadowRay;
+
+// Queues hold indices into `paths`. A path is in exactly one of them, or in
+// a material queue between intersection and shading.
+typedef struct Wavefront {
+  const Camera *cam;
+  Hittable *world;
+  const LightList *lights;
+  Sampler sampler; // Scrambling seeds copied into every new path
+  int path_count;
+  bool sort_rays;
+
+  PathState *paths;
+  int *free_slots;
+  int free_count;
+  int *active; // Paths whose ray is traced next
+  int active_count;
+  int *material_queues[MATERIAL_TYPES];
+  int material_counts[MATERIAL_TYPES];
+  int *finished;
+  int finished_count;
+  ShadowRay *shadows;
+  int shadow_count;
+  uint32_t *sort_keys; // Two buffers of path_count keys for the radix sort
+  int *sort_scratch;
+
+  Color *pixels;
+  long long next_sample;
+  long long done_samples;
+  long long total_samples;
+
+  PerfCounters counters; // Counting during stage_intersect only
+  unsigned long long intersected;
+} Wavefront;
+
+static void *wavefront_alloc(size_t count, size_t size) {
+  void *ptr = calloc(count, size);
+  PANIC_IF(ptr == NULL, "wavefront: failed to allocate %zu bytes",
+           count * size);
+  return ptr;
+}
+
+static void path_finish(Wavefront *wf, int index) {
+  wf->finished[wf->finished_count++] = index;
+}
+
+// Stage 1: starts a camera path in every free slot, in pixel order.
+static void stage_generate(Wavefront *wf) {
+  const Camera *cam = wf->cam;
+  while (wf->free_count > 0 && wf->next_sample < wf->total_samples) {
+    int index = wf->free_slots[--wf->free_count];
+    long long sample = wf->next_sample++;
+    int pixel = (int)(sample / cam->samples_per_pixel);
+    int i = pixel % cam->image_width;
+    int j = pixel / cam->image_width;
+
+    PathState *path = &wf->paths[index];
+    path->sampler = wf->sampler;
+    sampler_start_pixel_sample(&path->sampler, i, j,
+                               (uint32_t)(sample % cam->samples_per_pixel));
+    path->ray = camera_get_ray(cam, i, j, &path->sampler);
+    path->throughput = (Color){1.0, 1.0, 1.0};
+    path->radiance = vec3_zero();
+    path->scatter_normal = vec3_zero();
+    path->scatter_pdf = -1.0;
+    path->pixel = pixel;
+    path->depth = cam->max_depth;
+    if (path->depth <= 0)
+      path_finish(wf, index);
+    else
+      wf->active[wf->active_count++] = index;
+  }
+}
+
+// Stage 2: finds the closest hit of every active ray and sorts the paths
+// that hit something into queues by material type. Misses pick up the
+// background and finish.
+static void stage_intersect(Wavefront *wf) {
+  for (int k = 0; k < wf->active_count; k++) {
+    int index = wf->active[k];
+    PathState *path = &wf->paths[index];
+    STATS_INC(rays);
+    if (!wf->world->hit(wf->world, path->ray, interval_make(0, INFINITY),
+                        &path->rec)) {
+      Color miss = wf->cam->is_lighting ? wf->cam->background
+                                        : camera_sky_color(path->ray);
+      path->radiance =
+          vec3_add(path->radiance, vec3_mul(path->throughput, miss));
+      path_finish(wf, index);
+      continue;
+    }
+    hittable_finalize(&path->rec, path->ray);
+    MaterialType type = path->rec.mat->type;
+    wf->material_queues[type][wf->material_counts[type]++] = index;
+  }
+  wf->active_count = 0;
+}
+
+// One bounce of ray_color for a path whose hit is in `rec`: emission, the
+// scattered ray and, at non-delta hits, a shadow ray for the light sample.
+static void shade_path(Wavefront *wf, int index) {
+  PathState *path = &wf->paths[index];
+  HitRecord *rec = &path->rec;
+  Ray r = path->ray;
+
+  if (wf->cam->is_lighting) {
+    Color emitted = material_emitted(rec->mat, 0.0, 0.0, &rec->p);
+    if (path->scatter_pdf >= 0 && lightlist_is_light(rec->obj)) {
+      double light_pdf =
+          lightlist_pdf(wf->lights, r, path->scatter_normal, rec);
+      emitted =
+          vec3_scale(emitted, power_heuristic(path->scatter_pdf, light_pdf));
+    }
+    path->radiance =
+        vec3_add(path->radiance, vec3_mul(path->throughput, emitted));
+  }
+
+  uint32_t bounce_dimension = sampler_dimension(&path->sampler);
+  Ray scattered;
+  Color attenuation;
+  if (!rec->mat->scatter(rec->mat, r, rec, &path->sampler, &attenuation,
+                         &scattered)) {
+    path_finish(wf, index);
+    return;
+  }
+
+  double next_pdf = -1.0;
+  if (wf->cam->is_lighting && lightlist_size(wf->lights) > 0 &&
+      !material_is_delta(rec->mat)) {
+    ShadowRay *shadow = &wf->shadows[wf->shadow_count];
+    if (camera_sample_direct_light(rec, r, wf->lights, &path->sampler,
+                                   &shadow->ray, &shadow->t,
+                                   &shadow->contribution)) {
+      shadow->contribution =
+          vec3_mul(shadow->contribution, path->throughput);
+      shadow->path = index;
+      wf->shadow_count++;
+    }
+    next_pdf =
+        material_pdf(rec->mat, r, rec, vec3_normalized(scattered.direction));
+  }
+  sampler_set_dimension(&path->sampler, bounce_dimension + BOUNCE_REQUESTS);
+
+  path->throughput = vec3_mul(path->throughput, attenuation);
+  path->ray = scattered;
+  path->scatter_pdf = next_pdf;
+  path->scatter_normal = rec->normal;
+  if (--path->depth <= 0)
+    path_finish(wf, index);
+  else
+    wf->active[wf->active_count++] = index;
+}
+
+// Spreads the low SORT_MORTON_BITS bits of `v` two zero bits apart.
+static uint32_t morton_spread(uint32_t v) {
+  v &= (1u << SORT_MORTON_BITS) - 1;
+  v = (v | (v << 16)) & 0x030000ff;
+  v = (v | (v << 8)) & 0x0300f00f;
+  v = (v | (v << 4)) & 0x030c30c3;
+  v = (v | (v << 2)) & 0x09249249;
+  return v;
+}
+
+// Key of a ray for stage_sort: its direction octant above the Morton code
+// of its origin, quantized within [lo, lo + 1 / scale].
+static uint32_t ray_sort_key(Ray r, Vec3 lo, Vec3 scale) {
+  uint32_t octant = (r.direction.x < 0) | (r.direction.y < 0) << 1 |
+                    (r.direction.z < 0) << 2;
+  uint32_t qx = (uint32_t)((r.origin.x - lo.x) * scale.x);
+  uint32_t qy = (uint32_t)((r.origin.y - lo.y) * scale.y);
+  uint32_t qz = (uint32_t)((r.origin.z - lo.z) * scale.z);
+  uint32_t morton =
+      morton_spread(qx) | morton_spread(qy) << 1 | morton_spread(qz) << 2;
+  return octant << (3 * SORT_MORTON_BITS) | morton;
+}
+
+// Optional stage between shading and the next intersection: reorders the
+// bounced rays in `active` so that rays leaving nearby points in the same
+// direction octant are traced one after another and find the BVH nodes
+// they share still in cache. Origins are quantized within the bounds of
+// this batch. The radix sort is stable, so rays with equal keys keep their
+// previous order.
+static void stage_sort(Wavefront *wf) {
+  int count = wf->active_count;
+  if (!wf->sort_rays || count < 2)
+    return;
+
+  Vec3 lo = wf->paths[wf->active[0]].ray.origin;
+  Vec3 hi = lo;
+  for (int k = 1; k < count; k++) {
+    Vec3 o = wf->paths[wf->active[k]].ray.origin;
+    lo = (Vec3){fmin(lo.x, o.x), fmin(lo.y, o.y), fmin(lo.z, o.z)};
+    hi = (Vec3){fmax(hi.x, o.x), fmax(hi.y, o.y), fmax(hi.z, o.z)};
+  }
+  const double cells = (double)((1u << SORT_MORTON_BITS) - 1);
+  Vec3 extent = vec3_sub(hi, lo);
+  Vec3 scale = {extent.x > 0 ? cells / extent.x : 0.0,
+                extent.y > 0 ? cells / extent.y : 0.0,
+                extent.z > 0 ? cells / extent.z : 0.0};
+
+  uint32_t *keys = wf->sort_keys;
+  uint32_t *keys_out = wf->sort_keys + wf->path_count;
+  int *indices = wf->active;
+  int *indices_out = wf->sort_scratch;
+  for (int k = 0; k < count; k++)
+    keys[k] = ray_sort_key(wf->paths[indices[k]].ray, lo, scale);
+
+  for (int pass = 0; pass < SORT_PASSES; pass++) {
+    int shift = pass * SORT_RADIX_BITS;
+    int offsets[1 << SORT_RADIX_BITS] = {0};
+    for (int k = 0; k < count; k++)
+      offsets[(keys[k] >> shift) & ((1 << SORT_RADIX_BITS) - 1)]++;
+    int total = 0;
+    for (int b = 0; b < (1 << SORT_RADIX_BITS); b++) {
+      int n = offsets[b];
+      offsets[b] = total;
+      total += n;
+    }
+    for (int k = 0; k < count; k++) {
+      int dst = offsets[(keys[k] >> shift) & ((1 << SORT_RADIX_BITS) - 1)]++;
+      keys_out[dst] = keys[k];
+      indices_out[dst] = indices[k];
+    }
+    uint32_t *swap_keys = keys;
+    keys = keys_out;
+    keys_out = swap_keys;
+    int *swap_indices = indices;
+    indices = indices_out;
+    indices_out = swap_indices;
+  }
+
+  // An odd number of passes leaves the result in the scratch buffer
+  if (indices != wf->active) {
+    wf->sort_scratch = wf->active;
+    wf->active = indices;
+  }
+}
+
+// Stage 3: shades one material queue at a time, so each pass runs a single
+// scatter/eval/pdf implementation.
+static void stage_shade(Wavefront *wf) {
+  for (int type = 0; type < MATERIAL_TYPES; type++) {
+    for (int k = 0; k < wf->material_counts[type]; k++)
+      shade_path(wf, wf->material_queues[type][k]);
+    wf->material_counts[type] = 0;
+  }
+}
+
+// Stage 4: traces the shadow rays queued by shading.
+static void stage_shadow(Wavefront *wf) {
+  for (int k = 0; k < wf->shadow_count; k++) {
+    const ShadowRay *shadow = &wf->shadows[k];
+    STATS_INC(rays);
+    if (!wf->world->occluded(wf->world, shadow->ray, shadow->t)) {
+      PathState *path = &wf->paths[shadow->path];
+      path->radiance = vec3_add(path->radiance, shadow->contribution);
+    }
+  }
+  wf->shadow_count = 0;
+}
+
+// Stage 5: adds finished paths to their pixels and frees their slots.
+static void stage_accumulate(Wavefront *wf) {
+  for (int k = 0; k < wf->finished_count; k++) {
+    int index = wf->finished[k];
+    const PathState *path = &wf->paths[index];
+    wf->pixels[path->pixel] = vec3_add(wf->pixels[path->pixel], path->radiance);
+    wf->free_slots[wf->free_count++] = index;
+  }
+  wf->done_samples += wf->finished_count;
+  wf->finished_count = 0;
+}
+
+void wavefront_render(const Camera *cam, Hittable *hittable_world,
+                      const LightList *lights, FILE *out_file) {
+  int pixel_count = cam->image_width * cam->image_height;
+  int paths = cam->wavefront_paths;
+  PANIC_IF(paths <= 0, "wavefront: need at least one path in flight");
+  Wavefront wf = {
+      .cam = cam,
+      .world = hittable_world,
+      .lights = lights,
+      .sampler = sampler_make(cam->sampler, 0),
+      .path_count = paths,
+      .sort_rays = cam->sort_rays,
+      .paths = wavefront_alloc(paths, sizeof(PathState)),
+      .free_slots = wavefront_alloc(paths, sizeof(int)),
+      .active = wavefront_alloc(paths, sizeof(int)),
+      .finished = wavefront_alloc(paths, sizeof(int)),
+      .shadows = wavefront_alloc(paths, sizeof(ShadowRay)),
+      .sort_keys = wavefront_alloc(2 * (size_t)paths, sizeof(uint32_t)),
+      .sort_scratch = wavefront_alloc(paths, sizeof(int)),
+      .pixels = wavefront_alloc((size_t)pixel_count, sizeof(Color)),
+      .total_samples = (long long)pixel_count * cam->samples_per_pixel,
+  };
+  for (int type = 0; type < MATERIAL_TYPES; type++)
+    wf.material_queues[type] = wavefront_alloc(paths, sizeof(int));
+  // Hand out slots from 0 upwards
+  for (int k = 0; k < paths; k++)
+    wf.free_slots[wf.free_count++] = paths - 1 - k;
+
+  perf_counters_open(&wf.counters);
+
+  int percent = -1;
+  for (;;) {
+    stage_generate(&wf);
+    if (wf.active_count == 0 && wf.finished_count == 0)
+      break;
+    wf.intersected += (unsigned long long)wf.active_count;
+    perf_counters_resume(&wf.counters);
+    stage_intersect(&wf);
+    perf_counters_pause(&wf.counters);
+    stage_shade(&wf);
+    stage_sort(&wf);
+    stage_shadow(&wf);
+    stage_accumulate(&wf);
+
+    int done = (int)(100 * wf.done_samples / wf.total_samples);
+    if (done != percent) {
+      percent = done;
+      update_progress_bar(percent, 100);
+    }
+  }
+
+  fprintf(out_file, "P3\n%d %d\n255\n", cam->image_width, cam->image_height);
+  for (int k = 0; k < pixel_count; k++)
+    write_color(out_file, vec3_divs(wf.pixels[k], cam->samples_per_pixel));
+
+  perf_counters_print(&wf.counters, stdout, "Closest-hit traversal",
+                      wf.intersected);
+  perf_counters_close(&wf.counters);
+
+  for (int type = 0; type < MATERIAL_TYPES; type++)
+    free(wf.material_queues[type]);
+  free(wf.sort_scratch);
+  free(wf.sort_keys);
+  free(wf.pixels);
+  free(wf.shadows);
+  free(wf.finished);
+  free(wf.active);
+  free(wf.free_slots);
+  free(wf.paths);
+}
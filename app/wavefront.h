@@ -0,0 +1,33 @@
+#ifndef WAVEFRONT_H
+#define WAVEFRONT_H
+
+#include <stdio.h>
+
+#include "../hittable/hittable.h"
+#include "../light/light_list.h"
+#include "camera.h"
+
+// Paths in flight unless overridden with --wavefront-paths. Large enough
+// that every stage loops over thousands of rays, small enough that the path
+// states (about 1 MB) stay in cache.
+#define WAVEFRONT_DEFAULT_PATHS (1 << 12)
+
+// Alternative to camera_render that keeps a large pool of paths in flight
+// and advances all of them one bounce at a time through separate stages:
+// generate camera rays, intersect, shade (grouped by material type), trace
+// shadow rays and accumulate finished paths. Each stage runs the same code
+// over thousands of paths in a row instead of interleaving traversal,
+// shading and texturing per ray.
+//
+// cam->wavefront_paths sets how many paths are in flight. With
+// cam->sort_rays, the rays of each bounce are reordered by origin and
+// direction octant before they are traced, so that consecutive rays share
+// BVH nodes; the L1D and last-level cache misses of the closest-hit stage
+// are printed after the render where the CPU exposes counters.
+//
+// Estimates the same integral with the same sampler requests as
+// camera_render, so images match it up to floating-point summation order.
+extern void wavefront_render(const Camera *cam, Hittable *hittable_world,
+                             const LightList *lights, FILE *out_file);
+
+#endif // WAVEFRONT_H
@@ -0,0 +1,36 @@
+#!/bin/bash
+# Renders the scenes/ suite with a double and a float build of the renderer
+# and prints the render time of each. The images are kept in
+# build-precision/ for comparison.
+# Usage: bench/precision_bench.sh [scene names...]
+
+set -e
+cd "$(dirname "$0")/.."
+
+out=build-precision
+for precision in double float; do
+  flag=OFF
+  [ "$precision" = float ] && flag=ON
+  cmake -S . -B "$out/$precision" -DRAYTRACER_FLOAT=$flag >/dev/null
+  cmake --build "$out/$precision" --target raytracer >/dev/null
+done
+
+scenes=("$@")
+if [ ${#scenes[@]} -eq 0 ]; then
+  for file in scenes/*.txt; do
+    scenes+=("$(basename "$file" .txt)")
+  done
+fi
+
+printf "%-26s %10s %10s\n" scene double float
+for scene in "${scenes[@]}"; do
+  printf "%-26s" "$scene"
+  for precision in double float; do
+    start=$(date +%s.%N)
+    "$out/$precision/raytracer" "scenes/$scene.txt" \
+      "$out/$scene.$precision.ppm" >/dev/null
+    end=$(date +%s.%N)
+    awk -v s="$start" -v e="$end" 'BEGIN { printf " %9.2fs", e - s }'
+  done
+  printf "\n"
+done
@@ -0,0 +1,118 @@
+// Parse-time benchmark for parsers/scene_parser.c. Writes a procedurally
+// generated scene, a grid of spheres spread over a set of named materials
+// (some textured, the way generated scenes pick a random material per
+// object), to a temporary file and times parse_scene on it.
+// Usage: scene_parse_bench [spheres] [materials]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "app/camera.h"
+#include "app/scene.h"
+#include "core/dyn_array.h"
+#include "parsers/scene_parser.h"
+
+#define DEFAULT_SPHERES 1000000
+#define DEFAULT_MATERIALS 1024
+#define TEXTURE_COUNT 16
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Fixed LCG so every run parses the same file
+static unsigned long long lcg_state = 1;
+
+static double next_uniform(void) {
+  lcg_state = lcg_state * 6364136223846793005ull + 1442695040888963407ull;
+  return (lcg_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void write_scene(FILE *out, int spheres, int materials) {
+  fprintf(out, "camera {\n  lookfrom 13 2 3\n  lookat 0 0 0\n  vfov 20\n"
+               "  samples_per_pixel 1\n  width 64\n}\n\n");
+  for (int k = 0; k < TEXTURE_COUNT; k++) {
+    fprintf(out,
+            "texture {\n  name tex_%d\n  type checkered\n  scale %.3f\n"
+            "  color1 %.6f %.6f %.6f\n  color2 0.9 0.9 0.9\n}\n",
+            k, 0.1 + next_uniform(), next_uniform(), next_uniform(),
+            next_uniform());
+  }
+  for (int k = 0; k < materials; k++) {
+    switch (k % 4) {
+    case 0:
+      fprintf(out, "material {\n  name mat_%d\n  type lambertian\n"
+                   "  texture tex_%d\n}\n",
+              k, k % TEXTURE_COUNT);
+      break;
+    case 1:
+      fprintf(out, "material {\n  name mat_%d\n  type metal\n"
+                   "  color %.6f %.6f %.6f\n  fuzz %.4f\n}\n",
+              k, next_uniform(), next_uniform(), next_uniform(),
+              0.5 * next_uniform());
+      break;
+    case 2:
+      fprintf(out, "material {\n  name mat_%d\n  type dielectric\n"
+                   "  ref_idx 1.5\n}\n",
+              k);
+      break;
+    default:
+      fprintf(out, "material {\n  name mat_%d\n  type lambertian\n"
+                   "  color %.6f %.6f %.6f\n}\n",
+              k, next_uniform(), next_uniform(), next_uniform());
+      break;
+    }
+  }
+
+  int side = 1;
+  while (side * side < spheres)
+    side++;
+  for (int k = 0; k < spheres; k++) {
+    double x = (k % side) - side / 2 + 0.9 * next_uniform();
+    double z = (k / side) - side / 2 + 0.9 * next_uniform();
+    int material = (int)(next_uniform() * materials);
+    fprintf(out,
+            "sphere {\n  center %.6f 0.2 %.6f\n  radius 0.2\n"
+            "  material mat_%d\n}\n",
+            x, z, material);
+  }
+}
+
+int main(int argc, char **argv) {
+  int spheres = argc > 1 ? atoi(argv[1]) : DEFAULT_SPHERES;
+  int materials = argc > 2 ? atoi(argv[2]) : DEFAULT_MATERIALS;
+  if (spheres < 1 || materials < 1) {
+    fprintf(stderr, "usage: %s [spheres] [materials]\n", argv[0]);
+    return 1;
+  }
+
+  char path[] = "/tmp/scene_parse_bench_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    perror("mkstemp");
+    return 1;
+  }
+  FILE *out = fdopen(fd, "w");
+  write_scene(out, spheres, materials);
+  long bytes = ftell(out);
+  fclose(out);
+
+  Scene scene = scene_create();
+  Camera cam;
+  double start = now_seconds();
+  parse_scene(path, &scene, &cam);
+  double elapsed = now_seconds() - start;
+  int objects = dynarray_size((DynArray *)scene.objects->data);
+  unlink(path);
+
+  printf("Parsed %d spheres, %d materials (%.1f MB) in %.3f s: %.0f ns per "
+         "sphere, %.1f MB/s\n",
+         objects, materials, bytes / 1e6, elapsed, elapsed * 1e9 / objects,
+         bytes / 1e6 / elapsed);
+  scene_destroy(&scene);
+  return 0;
+}
@@ -0,0 +1,182 @@
+// Micro-benchmark for core/sampling.h and core/fast_math.h against the code
+// they replaced: rejection sampling for the sphere and disk, and libm for
+// acos, atan2 and sin/cos. Both sides draw their variates from the same
+// inline generator, so the rejection loops pay for the variates they throw
+// away. Usage: warp_bench [calls]
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "core/fast_math.h"
+#include "core/sampling.h"
+#include "core/vec3.h"
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+// xorshift64*, cheap enough not to dominate the timings
+static inline double next_uniform(void) {
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return (rng_state * 0x2545f4914f6cdd1dull >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The loops that used to live in core/vec3.h
+static Vec3 rejection_unit_vector(void) {
+  while (true) {
+    Vec3 p = {2 * next_uniform() - 1, 2 * next_uniform() - 1,
+              2 * next_uniform() - 1};
+    double lensq = vec3_length_squared(p);
+    if (1e-160 < lensq && lensq <= 1)
+      return vec3_divs(p, sqrt(lensq));
+  }
+}
+
+static Vec3 rejection_in_unit_disk(void) {
+  while (true) {
+    Vec3 p = {2 * next_uniform() - 1, 2 * next_uniform() - 1, 0};
+    if (vec3_length_squared(p) < 1)
+      return p;
+  }
+}
+
+static Vec3 libm_uniform_sphere(double u1, double u2) {
+  double z = 1 - 2 * u1;
+  double r = sqrt(fmax(0.0, 1 - z * z));
+  double phi = 2 * PI * u2;
+  return (Vec3){r * cos(phi), r * sin(phi), z};
+}
+
+// Loops whose per-call body differs between the baseline and replacement.
+// Results are summed into `sink` so nothing is optimised away.
+typedef enum {
+  BENCH_SPHERE,
+  BENCH_DISK,
+  BENCH_COSINE_HEMISPHERE,
+  BENCH_SINCOS,
+  BENCH_ACOS,
+  BENCH_ATAN2,
+  BENCH_COUNT,
+} BenchKind;
+
+static const char *bench_names[BENCH_COUNT] = {
+    "unit sphere",  "unit disk", "cosine hemisphere", "sin+cos",
+    "acos",         "atan2",
+};
+
+static double run(BenchKind kind, bool fast, long calls, double *sink) {
+  double acc = 0;
+  rng_state = 0x9e3779b97f4a7c15ull;
+  double start = now_seconds();
+  for (long i = 0; i < calls; i++) {
+    double u1 = next_uniform();
+    double u2 = next_uniform();
+    switch (kind) {
+    case BENCH_SPHERE: {
+      Vec3 d = fast ? sample_uniform_sphere(u1, u2) : rejection_unit_vector();
+      acc += d.x + d.y + d.z;
+      break;
+    }
+    case BENCH_DISK: {
+      Vec3 d =
+          fast ? sample_uniform_disk_concentric(u1, u2) : rejection_in_unit_disk();
+      acc += d.x + d.y;
+      break;
+    }
+    case BENCH_COSINE_HEMISPHERE: {
+      // The old Lambertian scatter: normal plus a unit vector
+      Vec3 d = fast ? sample_cosine_hemisphere(u1, u2)
+                    : vec3_normalized(vec3_add((Vec3){0, 0, 1},
+                                               rejection_unit_vector()));
+      acc += d.x + d.y + d.z;
+      break;
+    }
+    case BENCH_SINCOS: {
+      Vec3 d = fast ? sample_uniform_sphere(u1, u2)
+                    : libm_uniform_sphere(u1, u2);
+      acc += d.x + d.y + d.z;
+      break;
+    }
+    case BENCH_ACOS:
+      acc += fast ? fast_acos(2 * u1 - 1) : acos(2 * u1 - 1);
+      break;
+    case BENCH_ATAN2:
+      acc += fast ? fast_atan2(u1 - 0.5, u2 - 0.5) : atan2(u1 - 0.5, u2 - 0.5);
+      break;
+    case BENCH_COUNT:
+      break;
+    }
+  }
+  double elapsed = now_seconds() - start;
+  *sink += acc;
+  return elapsed * 1e9 / calls;
+}
+
+// Time of the loop that only draws the two variates, subtracted from both
+// sides of every case.
+static double run_empty(long calls, double *sink) {
+  double acc = 0;
+  rng_state = 0x9e3779b97f4a7c15ull;
+  double start = now_seconds();
+  for (long i = 0; i < calls; i++)
+    acc += next_uniform() + next_uniform();
+  double elapsed = now_seconds() - start;
+  *sink += acc;
+  return elapsed * 1e9 / calls;
+}
+
+// Largest absolute difference from libm over a dense sweep of the domain.
+static void print_accuracy(void) {
+  const int steps = 1 << 20;
+  double err_acos = 0, err_atan2 = 0, err_sincos = 0;
+  for (int i = 0; i <= steps; i++) {
+    double t = (double)i / steps;
+    double x = 2 * t - 1;
+    err_acos = fmax(err_acos, fabs(fast_acos(x) - acos(x)));
+
+    double angle = 2 * PI * t;
+    double y = sin(angle);
+    double xx = cos(angle);
+    err_atan2 = fmax(err_atan2, fabs(fast_atan2(y, xx) - atan2(y, xx)));
+
+    double s, c;
+    fast_sincos_turns(t, &s, &c);
+    err_sincos = fmax(err_sincos, fmax(fabs(s - y), fabs(c - xx)));
+  }
+  printf("\nMax abs error over %d points:\n", steps + 1);
+  printf("  fast_acos          %.2e\n", err_acos);
+  printf("  fast_atan2         %.2e\n", err_atan2);
+  printf("  fast_sincos_turns  %.2e\n", err_sincos);
+}
+
+int main(int argc, char **argv) {
+  long calls = argc > 1 ? atol(argv[1]) : 20000000;
+  if (calls <= 0) {
+    fprintf(stderr, "Usage: %s [calls]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  double sink = 0;
+  double overhead = run_empty(calls, &sink);
+  printf("%ld calls per case, loop overhead %.2f ns/call\n\n", calls, overhead);
+  printf("%-18s %12s %12s %8s\n", "case", "before ns", "after ns", "speedup");
+  for (int kind = 0; kind < BENCH_COUNT; kind++) {
+    double before = run((BenchKind)kind, false, calls, &sink) - overhead;
+    double after = run((BenchKind)kind, true, calls, &sink) - overhead;
+    printf("%-18s %12.2f %12.2f %7.2fx\n", bench_names[kind], before, after,
+           after > 0 ? before / after : 0.0);
+  }
+  print_accuracy();
+  printf("\n(checksum %g)\n", sink);
+  return 0;
+}
@@ -11,10 +11,10 @@ bool aabb_hit(AABB *box, Ray ray, Interval *ray_t) {
 
   for (int axis = 0; axis < 3; axis++) {
     Interval ax = axis_interval(box, axis);
-    double adinv = 1.0 / vec3_axis(ray_direction, axis);
+    real adinv = 1 / vec3_axis(ray_direction, axis);
 
-    double t0 = (ax.min - vec3_axis(ray_origin, axis)) * adinv;
-    double t1 = (ax.max - vec3_axis(ray_origin, axis)) * adinv;
+    real t0 = (ax.min - vec3_axis(ray_origin, axis)) * adinv;
+    real t1 = (ax.max - vec3_axis(ray_origin, axis)) * adinv;
 
     if (t0 < t1) {
       if (t0 > ray_t->min)
@@ -17,6 +17,20 @@ static inline AABB aabb_empty() {
   return (AABB){interval_empty(), interval_empty(), interval_empty()};
 }
 
+static inline AABB aabb_universe() {
+  return (AABB){interval_universe(), interval_universe(), interval_universe()};
+}
+
+// Returns false for the boxes of infinite primitives such as planes.
+// NOTE: compares against a finite limit because -ffast-math folds isinf();
+// the limit has to fit in a float.
+static inline bool aabb_is_bounded(const AABB *box) {
+  const real limit = 1e30;
+  return fabs(box->x.min) < limit && fabs(box->x.max) < limit &&
+         fabs(box->y.min) < limit && fabs(box->y.max) < limit &&
+         fabs(box->z.min) < limit && fabs(box->z.max) < limit;
+}
+
 static inline AABB aabb_make(Interval x, Interval y, Interval z) {
   return (AABB){x, y, z};
 }
@@ -45,9 +59,9 @@ static inline Interval axis_interval(AABB *box, int n) {
 
 // Returns the index of the longest axis of the bounding box.
 static inline int aabb_longest_axis(AABB *self) {
-  double x_size = interval_size(self->x);
-  double y_size = interval_size(self->y);
-  double z_size = interval_size(self->z);
+  real x_size = interval_size(self->x);
+  real y_size = interval_size(self->y);
+  real z_size = interval_size(self->z);
   if (x_size > y_size) {
     return x_size > z_size ? 0 : 2;
   } else {
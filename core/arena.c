@@ -0,0 +1,253 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifdef RT_HUGEPAGES
+#include <sys/mman.h>
+#endif
+
+#include "arena.h"
+#include "debug.h"
+
+// One transparent huge page. Chunk sizes are always a multiple of this.
+#define ARENA_CHUNK_SIZE ((size_t)2 << 20)
+#define ARENA_ALIGN 16
+#define ARENA_ROUND_UP(n, a) (((n) + (a) - 1) & ~((size_t)(a) - 1))
+
+typedef struct ArenaChunk {
+  struct ArenaChunk *next;
+  size_t size; // Total bytes, header included
+  size_t used; // Offset of the first free byte
+} ArenaChunk;
+
+#define ARENA_HEADER_SIZE ARENA_ROUND_UP(sizeof(ArenaChunk), ARENA_ALIGN)
+
+struct Arena {
+  uint64_t id;                   // Tells cursors of different arenas apart
+  pthread_mutex_t lock;          // Guards the lists and bytes_reserved
+  ArenaChunk *head;              // All chunks, newest first
+  struct ArenaCleanup *cleanups; // Newest first
+  size_t bytes_reserved;
+};
+
+// Each thread fills a chunk of its own, so allocating only takes the
+// arena's lock to link in a new chunk. The cursor belongs to the arena
+// with id `arena_id` and is ignored for any other.
+typedef struct ArenaCursor {
+  uint64_t arena_id;
+  ArenaChunk *chunk;
+} ArenaCursor;
+
+// Cleanup registered with arena_add_cleanup, allocated from the arena
+typedef struct ArenaCleanup {
+  struct ArenaCleanup *next;
+  ArenaCleanupFn fn;
+  void *ctx;
+} ArenaCleanup;
+
+// Chunks start on an ARENA_CHUNK_SIZE boundary and span whole multiples of
+// it, so every such slot of the address space is either entirely arena
+// memory or holds none. rt_free looks the slot of a pointer up in a
+// two-level map of the slots of live chunks: two loads, no lock and no
+// search, and no header in front of the blocks. Leaves are made on demand,
+// 16 KiB for each 32 GiB of address space chunks are found in, and kept.
+#define SLOT_SHIFT 21
+#define SLOT_BITS (48 - SLOT_SHIFT)
+#define SLOT_LEAF_BITS 14
+#define SLOT_LEAF_SIZE ((size_t)1 << SLOT_LEAF_BITS)
+#define SLOT_ROOT_SIZE ((size_t)1 << (SLOT_BITS - SLOT_LEAF_BITS))
+
+_Static_assert(((size_t)1 << SLOT_SHIFT) == ARENA_CHUNK_SIZE,
+               "arena slots must be one chunk size");
+
+typedef struct SlotLeaf {
+  atomic_bool live[SLOT_LEAF_SIZE];
+} SlotLeaf;
+
+static SlotLeaf *_Atomic slot_root[SLOT_ROOT_SIZE];
+static pthread_mutex_t slot_leaf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _Thread_local ArenaCursor cursor = {0, NULL};
+static atomic_uint_fast64_t next_arena_id = 1;
+static Arena *active_arena = NULL;
+
+static void *chunk_map(size_t size) {
+#ifdef RT_HUGEPAGES
+  // Over-map by one huge page so the chunk can start on a 2 MiB boundary,
+  // then hand the unused head and tail back
+  size_t span = size + ARENA_CHUNK_SIZE;
+  char *raw = mmap(NULL, span, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (raw == MAP_FAILED)
+    return NULL;
+  char *aligned = (char *)ARENA_ROUND_UP((uintptr_t)raw, ARENA_CHUNK_SIZE);
+  size_t head = (size_t)(aligned - raw);
+  if (head > 0)
+    munmap(raw, head);
+  if (span - head - size > 0)
+    munmap(aligned + size, span - head - size);
+  madvise(aligned, size, MADV_HUGEPAGE);
+  return aligned;
+#else
+  return aligned_alloc(ARENA_CHUNK_SIZE, size);
+#endif
+}
+
+static void chunk_unmap(ArenaChunk *chunk) {
+#ifdef RT_HUGEPAGES
+  munmap(chunk, chunk->size);
+#else
+  free(chunk);
+#endif
+}
+
+static void slot_map_mark(const ArenaChunk *chunk, bool live) {
+  uintptr_t first = (uintptr_t)chunk >> SLOT_SHIFT;
+  uintptr_t end = first + (chunk->size >> SLOT_SHIFT);
+  PANIC_IF(end > ((uintptr_t)1 << SLOT_BITS),
+           "arena: chunk %p lies beyond the slot map", (const void *)chunk);
+  for (uintptr_t slot = first; slot < end; slot++) {
+    SlotLeaf *_Atomic *root = &slot_root[slot >> SLOT_LEAF_BITS];
+    SlotLeaf *leaf = atomic_load(root);
+    if (!leaf) {
+      pthread_mutex_lock(&slot_leaf_lock);
+      leaf = atomic_load(root);
+      if (!leaf) {
+        leaf = calloc(1, sizeof(SlotLeaf));
+        assert(leaf != NULL);
+        atomic_store(root, leaf);
+      }
+      pthread_mutex_unlock(&slot_leaf_lock);
+    }
+    atomic_store(&leaf->live[slot & (SLOT_LEAF_SIZE - 1)], live);
+  }
+}
+
+static bool slot_map_contains(const void *ptr) {
+  uintptr_t slot = (uintptr_t)ptr >> SLOT_SHIFT;
+  if (slot >= ((uintptr_t)1 << SLOT_BITS))
+    return false;
+  SlotLeaf *leaf = atomic_load(&slot_root[slot >> SLOT_LEAF_BITS]);
+  return leaf && atomic_load(&leaf->live[slot & (SLOT_LEAF_SIZE - 1)]);
+}
+
+static ArenaChunk *chunk_create(size_t min_payload) {
+  size_t size =
+      ARENA_ROUND_UP(ARENA_HEADER_SIZE + min_payload, ARENA_CHUNK_SIZE);
+  ArenaChunk *chunk = chunk_map(size);
+  PANIC_IF(chunk == NULL, "arena: failed to reserve %zu bytes", size);
+  chunk->next = NULL;
+  chunk->size = size;
+  chunk->used = ARENA_HEADER_SIZE;
+  slot_map_mark(chunk, true);
+  return chunk;
+}
+
+Arena *arena_create(void) {
+  Arena *arena = malloc(sizeof(struct Arena));
+  assert(arena != NULL);
+  arena->id = atomic_fetch_add(&next_arena_id, 1);
+  pthread_mutex_init(&arena->lock, NULL);
+  arena->head = NULL; // Chunks are made by the threads that allocate
+  arena->cleanups = NULL;
+  arena->bytes_reserved = 0;
+  return arena;
+}
+
+void arena_destroy(Arena *self) {
+  assert(self != NULL);
+  if (active_arena == self)
+    active_arena = NULL;
+
+  // Cleanups live in the chunks, so they run before any chunk is released
+  for (ArenaCleanup *cleanup = self->cleanups; cleanup; cleanup = cleanup->next)
+    cleanup->fn(cleanup->ctx);
+
+  ArenaChunk *chunk = self->head;
+  while (chunk) {
+    ArenaChunk *next = chunk->next;
+    slot_map_mark(chunk, false);
+    chunk_unmap(chunk);
+    chunk = next;
+  }
+  pthread_mutex_destroy(&self->lock);
+  free(self);
+}
+
+static ArenaChunk *arena_add_chunk(Arena *self, size_t min_payload) {
+  ArenaChunk *chunk = chunk_create(min_payload);
+  pthread_mutex_lock(&self->lock);
+  chunk->next = self->head;
+  self->head = chunk;
+  self->bytes_reserved += chunk->size;
+  pthread_mutex_unlock(&self->lock);
+  return chunk;
+}
+
+void *arena_alloc(Arena *self, size_t size) {
+  assert(self != NULL);
+  size = ARENA_ROUND_UP(size > 0 ? size : 1, ARENA_ALIGN);
+
+  ArenaChunk *current = cursor.arena_id == self->id ? cursor.chunk : NULL;
+  ArenaChunk *chunk = current;
+  if (!chunk || chunk->used + size > chunk->size) {
+    chunk = arena_add_chunk(self, size);
+    // Oversized blocks get a chunk to themselves, and the thread keeps
+    // filling the one it had so the space left in it is not abandoned
+    if (!current || size <= ARENA_CHUNK_SIZE / 4) {
+      cursor.arena_id = self->id;
+      cursor.chunk = chunk;
+    }
+  }
+
+  void *ptr = (char *)chunk + chunk->used;
+  chunk->used += size;
+  return ptr;
+}
+
+void arena_add_cleanup(Arena *self, ArenaCleanupFn fn, void *ctx) {
+  assert(self != NULL && fn != NULL);
+  ArenaCleanup *cleanup = arena_alloc(self, sizeof(ArenaCleanup));
+  cleanup->fn = fn;
+  cleanup->ctx = ctx;
+  pthread_mutex_lock(&self->lock);
+  cleanup->next = self->cleanups;
+  self->cleanups = cleanup;
+  pthread_mutex_unlock(&self->lock);
+}
+
+void arena_each_chunk(const Arena *self, ArenaChunkFn fn, void *ctx) {
+  assert(self != NULL);
+  for (const ArenaChunk *chunk = self->head; chunk; chunk = chunk->next)
+    fn((const char *)chunk + ARENA_HEADER_SIZE,
+       chunk->used - ARENA_HEADER_SIZE, ctx);
+}
+
+size_t arena_bytes_used(const Arena *self) {
+  size_t used = 0;
+  for (const ArenaChunk *chunk = self->head; chunk; chunk = chunk->next)
+    used += chunk->used - ARENA_HEADER_SIZE;
+  return used;
+}
+
+size_t arena_bytes_reserved(const Arena *self) { return self->bytes_reserved; }
+
+void rt_set_arena(Arena *arena) { active_arena = arena; }
+
+Arena *rt_get_arena(void) { return active_arena; }
+
+void *rt_alloc(size_t size) {
+  if (active_arena)
+    return arena_alloc(active_arena, size);
+  return malloc(size);
+}
+
+void rt_free(void *ptr) {
+  // Arena memory is reclaimed all at once by arena_destroy, whichever arena
+  // the block came from and whether or not it is still active
+  if (ptr == NULL || slot_map_contains(ptr))
+    return;
+  free(ptr);
+}
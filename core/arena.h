@@ -0,0 +1,48 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bump allocator for data that lives exactly as long as a scene. Allocations
+// are carved sequentially out of large chunks, so objects created together
+// sit next to each other, and the whole arena is released chunk by chunk
+// without visiting the objects in it. Chunks are 2 MiB aligned; with
+// -DRAYTRACER_HUGEPAGES=ON they are mappings advised for transparent huge
+// pages.
+//
+// Allocation is thread safe: every thread carves from a chunk of its own
+// and only adding a chunk takes a lock, so models loaded in parallel (see
+// parse_scene) allocate without contending. The queries and
+// arena_each_chunk expect no allocation to be under way.
+typedef struct Arena Arena;
+
+extern Arena *arena_create(void);
+extern void arena_destroy(Arena *self);
+extern void *arena_alloc(Arena *self, size_t size);
+extern size_t arena_bytes_used(const Arena *self);
+extern size_t arena_bytes_reserved(const Arena *self);
+
+// Calls `fn(ctx)` when the arena is destroyed, before its memory is
+// released, newest registration first. For objects in the arena that hold
+// something outside it, like a file and pages read from it, so teardown
+// visits only those.
+typedef void (*ArenaCleanupFn)(void *ctx);
+extern void arena_add_cleanup(Arena *self, ArenaCleanupFn fn, void *ctx);
+
+// Calls `fn` with the allocated part of each chunk. Every allocation lies
+// entirely inside one such range, 16-byte aligned relative to its start.
+typedef void (*ArenaChunkFn)(const void *data, size_t size, void *ctx);
+extern void arena_each_chunk(const Arena *self, ArenaChunkFn fn, void *ctx);
+
+// Allocation entry points for everything owned by a scene (hittables,
+// materials, textures and their data). While an arena is active they
+// allocate from it, otherwise from malloc. rt_free tells the two apart by
+// address, without a lock, and ignores arena blocks, even after their arena
+// has been deactivated; those go with arena_destroy.
+extern void rt_set_arena(Arena *arena);
+extern Arena *rt_get_arena(void);
+extern void *rt_alloc(size_t size);
+extern void rt_free(void *ptr);
+
+#endif // ARENA_H
@@ -43,6 +43,13 @@ void dynarray_destroy(DynArray *arr) {
   free(arr);
 }
 
+// Frees the array without destroying its elements.
+void dynarray_release(DynArray *arr) {
+  assert(arr != NULL);
+  free(arr->data);
+  free(arr);
+}
+
 int dynarray_size(const DynArray *arr) {
   assert(arr != NULL);
   return arr->size;
@@ -97,6 +104,12 @@ GVal dynarray_get(const DynArray *arr, int index) {
   return arr->data[index];
 }
 
+void dynarray_set(DynArray *arr, int index, GVal elem) {
+  assert(arr != NULL);
+  assert(index >= 0 && index < arr->size);
+  arr->data[index] = elem;
+}
+
 void dynarray_sort(DynArray *arr, GCmp compare) {
   qsort(arr->data, arr->size, sizeof(GVal), compare);
 }
@@ -9,10 +9,12 @@ typedef struct DynArray DynArray;
 extern DynArray *dynarray_create(int initial_capacity, GPrintFn pelem,
                                  GDestroyFn delem);
 extern void dynarray_destroy(DynArray *arr);
+extern void dynarray_release(DynArray *arr);
 extern void dynarray_push(DynArray *arr, GVal elem);
 extern GVal dynarray_pop(DynArray *arr);
 GVal dynarray_pop_and_destroy(DynArray *arr);
 extern GVal dynarray_get(const DynArray *arr, int index);
+extern void dynarray_set(DynArray *arr, int index, GVal elem);
 extern int dynarray_size(const DynArray *arr);
 extern int dynarray_capacity(const DynArray *arr);
 extern void dynarray_sort(DynArray *arr, GCmp compare);
@@ -0,0 +1,91 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <math.h>
+
+#include "util.h"
+
+// Polynomial replacements for the libm calls on the per-ray paths. Each one
+// is accurate to well below what an 8-bit pixel or a texture lookup can
+// resolve (errors are listed per function) and compiles to straight-line
+// code with no table lookups or calls.
+
+// x^5 by three multiplies instead of pow(). Exact up to rounding.
+static inline double pow5(double x) {
+  double x2 = x * x;
+  return x2 * x2 * x;
+}
+
+// sin(a) and cos(a) for |a| <= pi/4 by their Taylor series up to a^9 and
+// a^10. Absolute error below 2e-9.
+static inline void fast_sincos_octant(double a, double *s, double *c) {
+  double a2 = a * a;
+  *s = a * (1 + a2 * (-1.0 / 6 +
+                      a2 * (1.0 / 120 +
+                            a2 * (-1.0 / 5040 + a2 * (1.0 / 362880)))));
+  *c = 1 + a2 * (-1.0 / 2 +
+                 a2 * (1.0 / 24 +
+                       a2 * (-1.0 / 720 +
+                             a2 * (1.0 / 40320 + a2 * (-1.0 / 3628800)))));
+}
+
+// sin and cos of the angle 2 pi t, for any t. Reduces to the nearest
+// quarter turn and evaluates the octant polynomials; the quadrant is applied
+// with selects rather than a branch, since random angles would mispredict
+// it most of the time. Absolute error below 2e-9.
+static inline void fast_sincos_turns(double t, double *s, double *c) {
+  double quarters = 4.0 * t;
+  // Round by truncation; floor() is a libm call without SSE4.1
+  long long nearest = (long long)(quarters + (quarters < 0 ? -0.5 : 0.5));
+  double so, co;
+  fast_sincos_octant((quarters - (double)nearest) * (PI / 2), &so, &co);
+  int quadrant = (int)(nearest & 3);
+  double sa = (quadrant & 1) ? co : so;
+  double ca = (quadrant & 1) ? so : co;
+  *s = (quadrant & 2) ? -sa : sa;
+  *c = ((quadrant + 1) & 2) ? -ca : ca;
+}
+
+// acos(x) for x in [-1, 1] (Abramowitz and Stegun 4.4.46). Absolute error
+// below 3e-8 rad.
+static inline double fast_acos(double x) {
+  double ax = fabs(x);
+  double p = -0.0012624911;
+  p = p * ax + 0.0066700901;
+  p = p * ax - 0.0170881256;
+  p = p * ax + 0.0308918810;
+  p = p * ax - 0.0501743046;
+  p = p * ax + 0.0889789874;
+  p = p * ax - 0.2145988016;
+  p = p * ax + 1.5707963050;
+  double r = sqrt(fmax(0.0, 1 - ax)) * p;
+  return x < 0 ? PI - r : r;
+}
+
+// atan2(y, x) in [-pi, pi]. Reduces to atan on [0, 1] and evaluates
+// Abramowitz and Stegun 4.4.49. Absolute error below 2e-8 rad. Returns 0
+// for (0, 0) like atan2.
+static inline double fast_atan2(double y, double x) {
+  double ax = fabs(x);
+  double ay = fabs(y);
+  double hi = fmax(ax, ay);
+  if (hi == 0)
+    return 0.0;
+  double z = fmin(ax, ay) / hi;
+  double z2 = z * z;
+  double p = 0.0028662257;
+  p = p * z2 - 0.0161657367;
+  p = p * z2 + 0.0429096138;
+  p = p * z2 - 0.0752896400;
+  p = p * z2 + 0.1065626393;
+  p = p * z2 - 0.1420889944;
+  p = p * z2 + 0.1999355085;
+  p = p * z2 - 0.3333314528;
+  double r = z * (1 + z2 * p);
+  // Octant fix-ups as selects; the signs of hit points are unpredictable
+  r = ay > ax ? PI / 2 - r : r;
+  r = x < 0 ? PI - r : r;
+  return copysign(r, y);
+}
+
+#endif // FAST_MATH_H
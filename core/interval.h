@@ -4,9 +4,11 @@
 #include <math.h>
 #include <stdbool.h>
 
+#include "real.h"
+
 typedef struct Interval {
-  double min;
-  double max;
+  real min;
+  real max;
 } Interval;
 
 // Returns an empty interval
@@ -20,30 +22,30 @@ static inline Interval interval_universe(void) {
 }
 
 // Constructor with explicit bounds
-static inline Interval interval_make(double min, double max) {
+static inline Interval interval_make(real min, real max) {
   return (Interval){min, max};
 }
 
 static inline Interval interval_enclose(Interval a, Interval b) {
-  double min = a.min <= b.min ? a.min : b.min;
-  double max = a.max >= b.max ? a.max : b.max;
+  real min = a.min <= b.min ? a.min : b.min;
+  real max = a.max >= b.max ? a.max : b.max;
   return (Interval){min, max};
 }
 
 // Returns the size of the interval
-static inline double interval_size(Interval i) { return i.max - i.min; }
+static inline real interval_size(Interval i) { return i.max - i.min; }
 
 // Returns true if x is in [min, max]
-static inline bool interval_contains(Interval i, double x) {
+static inline bool interval_contains(Interval i, real x) {
   return i.min <= x && x <= i.max;
 }
 
 // Returns true if x is in (min, max)
-static inline bool interval_surrounds(Interval i, double x) {
+static inline bool interval_surrounds(Interval i, real x) {
   return i.min < x && x < i.max;
 }
 
-static inline double interval_clamp(Interval i, double x) {
+static inline real interval_clamp(Interval i, real x) {
   if (x < i.min)
     return i.min;
   if (x > i.max)
@@ -51,8 +53,8 @@ static inline double interval_clamp(Interval i, double x) {
   return x;
 }
 
-static inline Interval interval_expand(Interval i, double delta) {
-  double padding = delta / 2;
+static inline Interval interval_expand(Interval i, real delta) {
+  real padding = delta / 2;
   return interval_make(i.min - padding, i.max + padding);
 }
 
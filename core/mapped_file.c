@@ -0,0 +1,45 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.h"
+
+bool mapped_file_open(MappedFile *self, const char *path) {
+  self->data = NULL;
+  self->size = 0;
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    return false;
+  }
+  if (st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file referenced after the descriptor is closed
+  close(fd);
+  if (data == MAP_FAILED)
+    return false;
+  // Parsers read the file front to back exactly once
+  madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+  self->data = data;
+  self->size = (size_t)st.st_size;
+  return true;
+}
+
+void mapped_file_close(MappedFile *self) {
+  if (self->data != NULL)
+    munmap((void *)self->data, self->size);
+  self->data = NULL;
+  self->size = 0;
+}
@@ -0,0 +1,22 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// A whole file mapped read-only into memory. The contents are not NUL
+// terminated; parsers scan `data` up to `data + size`.
+typedef struct MappedFile {
+  const char *data;
+  size_t size;
+} MappedFile;
+
+// Maps `path`. Returns false and leaves `self` empty if the file cannot be
+// opened or mapped; errno is left as set by the failing call. Empty files
+// map successfully with size 0.
+extern bool mapped_file_open(MappedFile *self, const char *path);
+
+// Unmaps the file. Safe on an empty MappedFile.
+extern void mapped_file_close(MappedFile *self);
+
+#endif // MAPPED_FILE_H
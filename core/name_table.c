@@ -0,0 +1,94 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "name_table.h"
+
+#define MIN_CAPACITY 16
+
+typedef struct NameEntry {
+  char *name; // NULL if the slot is free
+  uint32_t hash;
+  int value;
+} NameEntry;
+
+struct NameTable {
+  int size;
+  int capacity; // Power of two, kept at least twice size
+  NameEntry *entries;
+};
+
+// 32-bit FNV-1a
+static uint32_t name_hash(const char *name) {
+  uint32_t hash = 2166136261u;
+  for (const unsigned char *c = (const unsigned char *)name; *c; c++)
+    hash = (hash ^ *c) * 16777619u;
+  return hash;
+}
+
+NameTable *name_table_create(void) {
+  NameTable *self = malloc(sizeof(NameTable));
+  assert(self);
+  self->size = 0;
+  self->capacity = MIN_CAPACITY;
+  self->entries = calloc((size_t)self->capacity, sizeof(NameEntry));
+  assert(self->entries);
+  return self;
+}
+
+void name_table_destroy(NameTable *self) {
+  assert(self != NULL);
+  for (int i = 0; i < self->capacity; i++)
+    free(self->entries[i].name);
+  free(self->entries);
+  free(self);
+}
+
+// Slot holding `name`, or the free slot where it would go.
+static NameEntry *name_table_slot(const NameTable *self, const char *name,
+                                  uint32_t hash) {
+  uint32_t mask = (uint32_t)self->capacity - 1;
+  for (uint32_t i = hash & mask;; i = (i + 1) & mask) {
+    NameEntry *entry = &self->entries[i];
+    if (!entry->name ||
+        (entry->hash == hash && strcmp(entry->name, name) == 0))
+      return entry;
+  }
+}
+
+static void name_table_grow(NameTable *self) {
+  NameEntry *old = self->entries;
+  int old_capacity = self->capacity;
+  self->capacity *= 2;
+  self->entries = calloc((size_t)self->capacity, sizeof(NameEntry));
+  assert(self->entries);
+  for (int i = 0; i < old_capacity; i++) {
+    if (old[i].name)
+      *name_table_slot(self, old[i].name, old[i].hash) = old[i];
+  }
+  free(old);
+}
+
+bool name_table_insert(NameTable *self, const char *name, int value) {
+  assert(self != NULL && name != NULL);
+  if (2 * (self->size + 1) > self->capacity)
+    name_table_grow(self);
+  uint32_t hash = name_hash(name);
+  NameEntry *entry = name_table_slot(self, name, hash);
+  if (entry->name)
+    return false;
+  entry->name = strdup(name);
+  assert(entry->name);
+  entry->hash = hash;
+  entry->value = value;
+  self->size++;
+  return true;
+}
+
+int name_table_find(const NameTable *self, const char *name) {
+  assert(self != NULL && name != NULL);
+  NameEntry *entry = name_table_slot(self, name, name_hash(name));
+  return entry->name ? entry->value : -1;
+}
@@ -0,0 +1,21 @@
+#ifndef NAME_TABLE_H
+#define NAME_TABLE_H
+
+#include <stdbool.h>
+
+// Hash table from names to small integers, such as a scene file's material
+// names to their index in the scene. Open addressing with linear probing;
+// names are copied in.
+typedef struct NameTable NameTable;
+
+extern NameTable *name_table_create(void);
+extern void name_table_destroy(NameTable *self);
+
+// Maps `name` to `value`. If `name` is already present it keeps its first
+// value and false is returned.
+extern bool name_table_insert(NameTable *self, const char *name, int value);
+
+// Returns the value of `name`, or -1 if it is not in the table.
+extern int name_table_find(const NameTable *self, const char *name);
+
+#endif // NAME_TABLE_H
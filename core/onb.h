@@ -0,0 +1,30 @@
+#ifndef ONB_H
+#define ONB_H
+
+#include <math.h>
+
+#include "vec3.h"
+
+// Orthonormal basis around a unit vector `w`.
+typedef struct Onb {
+  Vec3 u, v, w;
+} Onb;
+
+// Builds the basis without normalising or branching on the largest axis
+// (Duff et al., "Building an Orthonormal Basis, Revisited").
+static inline Onb onb_from_w(Vec3 w) {
+  real sign = copysign((real)1, w.z);
+  real a = -1 / (sign + w.z);
+  real b = w.x * w.y * a;
+  return (Onb){.u = {1 + sign * w.x * w.x * a, sign * b, -sign * w.x},
+               .v = {b, sign + w.y * w.y * a, -w.y},
+               .w = w};
+}
+
+// Maps local coordinates (x along u, y along v, z along w) to world space.
+static inline Vec3 onb_local(const Onb *onb, Vec3 a) {
+  return vec3_add(vec3_add(vec3_scale(onb->u, a.x), vec3_scale(onb->v, a.y)),
+                  vec3_scale(onb->w, a.z));
+}
+
+#endif // ONB_H
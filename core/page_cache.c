@@ -0,0 +1,115 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "debug.h"
+#include "page_cache.h"
+
+static size_t budget = PAGE_CACHE_DEFAULT_BUDGET;
+static CachedPage *newest = NULL;
+static CachedPage *oldest = NULL;
+static PageCacheStats stats = {0};
+
+static double now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void lru_unlink(CachedPage *page) {
+  if (page->newer)
+    page->newer->older = page->older;
+  else
+    newest = page->older;
+  if (page->older)
+    page->older->newer = page->newer;
+  else
+    oldest = page->newer;
+  page->newer = page->older = NULL;
+}
+
+static void lru_push_newest(CachedPage *page) {
+  page->newer = NULL;
+  page->older = newest;
+  if (newest)
+    newest->newer = page;
+  newest = page;
+  if (!oldest)
+    oldest = page;
+}
+
+void page_cache_set_budget(size_t bytes) { budget = bytes; }
+
+size_t page_cache_budget(void) { return budget; }
+
+void page_cache_drop(CachedPage *page) {
+  if (page->data == NULL)
+    return;
+  lru_unlink(page);
+  free(page->data);
+  page->data = NULL;
+  stats.resident_bytes -= page->size;
+}
+
+static void read_page(CachedPage *page) {
+  void *data = malloc(page->size > 0 ? page->size : 1);
+  PANIC_IF(data == NULL, "page cache: failed to allocate %zu bytes",
+           page->size);
+  size_t done = 0;
+  while (done < page->size) {
+    ssize_t n = pread(page->fd, (char *)data + done, page->size - done,
+                      (off_t)(page->offset + done));
+    if (n < 0 && errno == EINTR)
+      continue;
+    PANIC_IF(n <= 0, "page cache: failed to read %zu bytes at offset %llu",
+             page->size, (unsigned long long)page->offset);
+    done += (size_t)n;
+  }
+  page->data = data;
+}
+
+const void *page_cache_acquire(CachedPage *page) {
+  assert(page != NULL);
+  stats.requests++;
+  if (page->data) {
+    if (newest != page) {
+      lru_unlink(page);
+      lru_push_newest(page);
+    }
+    return page->data;
+  }
+
+  // Make room first so the resident set never exceeds the budget by more
+  // than this page
+  while (oldest && stats.resident_bytes + page->size > budget) {
+    page_cache_drop(oldest);
+    stats.evictions++;
+  }
+
+  double start = now_seconds();
+  read_page(page);
+  stats.stall_seconds += now_seconds() - start;
+  stats.faults++;
+  stats.bytes_read += page->size;
+
+  lru_push_newest(page);
+  stats.resident_bytes += page->size;
+  if (stats.resident_bytes > stats.peak_resident_bytes)
+    stats.peak_resident_bytes = stats.resident_bytes;
+  return page->data;
+}
+
+void page_cache_prefetch(const CachedPage *page) {
+  if (page->data)
+    return;
+  stats.prefetches++;
+#ifdef POSIX_FADV_WILLNEED
+  posix_fadvise(page->fd, (off_t)page->offset, (off_t)page->size,
+                POSIX_FADV_WILLNEED);
+#endif
+}
+
+PageCacheStats page_cache_stats(void) { return stats; }
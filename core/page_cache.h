@@ -0,0 +1,51 @@
+#ifndef PAGE_CACHE_H
+#define PAGE_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Resident set for geometry paged in from disk (hittable/paged_mesh.h). Each
+// page is a block of a file read on first use and kept until the bytes of
+// all resident pages would exceed the budget, when the least recently used
+// pages are dropped. One budget is shared by every paged file. Not thread
+// safe: pages are acquired by the rendering thread.
+#define PAGE_CACHE_DEFAULT_BUDGET ((size_t)256 << 20)
+
+// One page of a paged file, owned by its client; only the cache writes it.
+typedef struct CachedPage {
+  int fd;
+  uint64_t offset;
+  size_t size;
+  void *data; // NULL while not resident
+  struct CachedPage *newer, *older; // LRU list links while resident
+} CachedPage;
+
+typedef struct PageCacheStats {
+  unsigned long long requests;  // page_cache_acquire calls
+  unsigned long long faults;    // ... that had to read the page
+  unsigned long long evictions; // Pages dropped to stay within the budget
+  unsigned long long prefetches;
+  unsigned long long bytes_read;
+  double stall_seconds; // Spent waiting for page reads
+  size_t resident_bytes;
+  size_t peak_resident_bytes;
+} PageCacheStats;
+
+// Sets the byte budget (at least one page is always kept, whatever it is).
+extern void page_cache_set_budget(size_t bytes);
+extern size_t page_cache_budget(void);
+
+// Returns the page's data, reading it if it is not resident and evicting
+// other pages as needed. The data stays valid until the next acquire.
+extern const void *page_cache_acquire(CachedPage *page);
+
+// Asks the kernel to start reading a page that is not resident, so a later
+// acquire finds it in the page cache instead of waiting for the disk.
+extern void page_cache_prefetch(const CachedPage *page);
+
+// Drops the page from the resident set, e.g. before its file is closed.
+extern void page_cache_drop(CachedPage *page);
+
+extern PageCacheStats page_cache_stats(void);
+
+#endif // PAGE_CACHE_H
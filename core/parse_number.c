@@ -0,0 +1,87 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "parse_number.h"
+
+// Longest number handed to strtod when the fast path below cannot take it
+#define MAX_NUMBER_LENGTH 64
+
+static inline bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+bool parse_int(const char **p, const char *end, long *out) {
+  const char *s = *p;
+  bool negative = s < end && *s == '-';
+  if (s < end && (*s == '-' || *s == '+'))
+    s++;
+  const char *digits = s;
+  long value = 0;
+  while (s < end && is_digit(*s))
+    value = value * 10 + (*s++ - '0');
+  // Nine digits cannot overflow a long on any platform
+  if (s == digits || s - digits > 9)
+    return false;
+  *out = negative ? -value : value;
+  *p = s;
+  return true;
+}
+
+// Exact powers of ten; every one of them is representable as a double.
+static const double powers_of_ten[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+bool parse_double(const char **p, const char *end, double *out) {
+  const char *s = *p;
+  bool negative = s < end && *s == '-';
+  if (s < end && (*s == '-' || *s == '+'))
+    s++;
+
+  // Digits are accumulated without checking for overflow; more than 19 of
+  // them go to strtod below
+  uint64_t mantissa = 0;
+  const char *integer = s;
+  while (s < end && is_digit(*s))
+    mantissa = mantissa * 10 + (uint64_t)(*s++ - '0');
+  long digits = s - integer;
+  int exponent = 0; // Decimal exponent to apply to mantissa
+  if (s < end && *s == '.') {
+    const char *fraction = ++s;
+    while (s < end && is_digit(*s))
+      mantissa = mantissa * 10 + (uint64_t)(*s++ - '0');
+    exponent = -(int)(s - fraction);
+    digits += s - fraction;
+  }
+  if (digits == 0)
+    return false;
+  if (s < end && (*s == 'e' || *s == 'E')) {
+    const char *e = s + 1;
+    long exp_value;
+    if (parse_int(&e, end, &exp_value)) {
+      exponent += (int)exp_value;
+      s = e;
+    }
+  }
+
+  if (digits <= 19 && mantissa <= (UINT64_C(1) << 53) && exponent >= -22 &&
+      exponent <= 22) {
+    double value = (double)mantissa;
+    value = exponent < 0 ? value / powers_of_ten[-exponent]
+                         : value * powers_of_ten[exponent];
+    *out = negative ? -value : value;
+    *p = s;
+    return true;
+  }
+
+  char buffer[MAX_NUMBER_LENGTH];
+  size_t length = (size_t)(s - *p);
+  if (length >= sizeof(buffer))
+    return false;
+  memcpy(buffer, *p, length);
+  buffer[length] = '\0';
+  *out = strtod(buffer, NULL);
+  *p = s;
+  return true;
+}
@@ -0,0 +1,22 @@
+#ifndef PARSE_NUMBER_H
+#define PARSE_NUMBER_H
+
+#include <stdbool.h>
+
+// Number parsers for text scanned in place, such as a mapped file with no
+// terminating NUL. Each reads from `*p` up to `end`, never past it, advances
+// `*p` past what it consumed and returns false without consuming anything
+// on bad input. Neither skips leading whitespace.
+
+// Optionally signed decimal integer of at most nine digits.
+extern bool parse_int(const char **p, const char *end, long *out);
+
+// Decimal floating-point number, as strtod would read it. Numbers whose
+// digits fit in 53 bits and whose decimal exponent is at most 22 in
+// magnitude are one multiplication or division of two exact doubles, hence
+// correctly rounded (Clinger's fast path); that covers the fixed-point
+// values every exporter writes. Anything else is copied out and handed to
+// strtod.
+extern bool parse_double(const char **p, const char *end, double *out);
+
+#endif // PARSE_NUMBER_H
@@ -0,0 +1,109 @@
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static const char *counter_names[PERF_COUNTER_COUNT] = {
+    "L1D read misses",
+    "LLC read misses",
+};
+
+static unsigned long long counter_config(PerfCounterKind kind) {
+  unsigned long long cache = kind == PERF_L1D_READ_MISSES
+                                 ? PERF_COUNT_HW_CACHE_L1D
+                                 : PERF_COUNT_HW_CACHE_LL;
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+void perf_counters_open(PerfCounters *self) {
+  memset(self, 0, sizeof(*self));
+  for (int k = 0; k < PERF_COUNTER_COUNT; k++)
+    self->fds[k] = -1;
+
+  for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = counter_config((PerfCounterKind)k);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    self->fds[k] = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (self->fds[k] < 0) {
+      self->error = errno;
+      perf_counters_close(self);
+      return;
+    }
+  }
+  self->available = true;
+}
+
+void perf_counters_resume(PerfCounters *self) {
+  if (!self->available)
+    return;
+  for (int k = 0; k < PERF_COUNTER_COUNT; k++)
+    ioctl(self->fds[k], PERF_EVENT_IOC_ENABLE, 0);
+}
+
+void perf_counters_pause(PerfCounters *self) {
+  if (!self->available)
+    return;
+  for (int k = 0; k < PERF_COUNTER_COUNT; k++)
+    ioctl(self->fds[k], PERF_EVENT_IOC_DISABLE, 0);
+}
+
+void perf_counters_print(PerfCounters *self, FILE *out, const char *label,
+                         unsigned long long rays) {
+  if (!self->available) {
+    fprintf(out, "%s: cache counters unavailable (%s)\n", label,
+            strerror(self->error));
+    return;
+  }
+  fprintf(out, "%s:\n", label);
+  double per = rays > 0 ? (double)rays : 1.0;
+  for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+    if (read(self->fds[k], &self->values[k], sizeof(self->values[k])) !=
+        (ssize_t)sizeof(self->values[k]))
+      self->values[k] = 0;
+    fprintf(out, "  %-16s %llu (%.3f per ray)\n", counter_names[k],
+            self->values[k], self->values[k] / per);
+  }
+}
+
+void perf_counters_close(PerfCounters *self) {
+  for (int k = 0; k < PERF_COUNTER_COUNT; k++) {
+    if (self->fds[k] >= 0)
+      close(self->fds[k]);
+    self->fds[k] = -1;
+  }
+  self->available = false;
+}
+#else
+void perf_counters_open(PerfCounters *self) {
+  memset(self, 0, sizeof(*self));
+  self->error = ENOSYS;
+}
+
+void perf_counters_resume(PerfCounters *self) { (void)self; }
+
+void perf_counters_pause(PerfCounters *self) { (void)self; }
+
+void perf_counters_print(PerfCounters *self, FILE *out, const char *label,
+                         unsigned long long rays) {
+  (void)rays;
+  fprintf(out, "%s: cache counters unavailable (%s)\n", label,
+          strerror(self->error));
+}
+
+void perf_counters_close(PerfCounters *self) { self->available = false; }
+#endif
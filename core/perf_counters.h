@@ -0,0 +1,39 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+// Hardware cache-miss counters for the calling thread, read through Linux
+// perf events. Where they cannot be opened (other systems, virtual machines
+// without a PMU, perf_event_paranoid above 2) the calls below do nothing and
+// perf_counters_print says why, so callers never need to check.
+typedef enum {
+  PERF_L1D_READ_MISSES,
+  PERF_LLC_READ_MISSES,
+  PERF_COUNTER_COUNT,
+} PerfCounterKind;
+
+typedef struct PerfCounters {
+  int fds[PERF_COUNTER_COUNT];
+  unsigned long long values[PERF_COUNTER_COUNT];
+  bool available;
+  int error; // errno of the failed open if not available
+} PerfCounters;
+
+// Opens the counters stopped and at zero.
+extern void perf_counters_open(PerfCounters *self);
+
+// Counting only happens between resume and pause, so a caller can measure
+// one stage of a loop.
+extern void perf_counters_resume(PerfCounters *self);
+extern void perf_counters_pause(PerfCounters *self);
+
+// Prints the totals under `label`, also divided by the number of rays
+// traced while counting.
+extern void perf_counters_print(PerfCounters *self, FILE *out,
+                                const char *label, unsigned long long rays);
+
+extern void perf_counters_close(PerfCounters *self);
+
+#endif // PERF_COUNTERS_H
@@ -3,14 +3,59 @@
 
 #include "vec3.h"
 
+// A float ray is 28 bytes, which calls passing it by value copy with two
+// overlapping 16-byte moves that stall on the stores of its fields. Aligned
+// to 16 it is copied as two whole halves.
+#ifdef RT_FLOAT
+#define RAY_ALIGN _Alignas(16)
+#else
+#define RAY_ALIGN
+#endif
+
 typedef struct Ray {
-  Vec3 origin;
+  RAY_ALIGN Vec3 origin;
   Vec3 direction;
-  double time;
+  real time;
 } Ray;
 
-static inline Vec3 ray_at(Ray r, double pos) {
+static inline Vec3 ray_at(Ray r, real pos) {
   return vec3_add(vec3_scale(r.direction, pos), r.origin);
 }
 
+// Ray leaving the surface point `p`, whose geometric normal is `n`, along
+// `direction`. The origin is pushed off the surface to the side the ray
+// leaves by, a fixed number of ulps per coordinate (a small absolute step
+// for coordinates near zero), so the ray cannot hit the surface it starts on
+// again however large the scene is, and needs no t-min (Waechter and Binder,
+// "A Fast and Robust Method for Avoiding Self-Intersection", 2019).
+//
+// The offset only covers an error of a few ulps of `p` itself. A point from
+// ray_at also carries the rounding of the ray's origin, which can be much
+// larger, so finalize functions place hit points on the surface instead.
+static inline Ray ray_spawn(Vec3 p, Vec3 n, Vec3 direction, real time) {
+  if (vec3_dot(direction, n) < 0)
+    n = vec3_negate(n);
+  real_bits ux = (real_bits)(REAL_OFFSET_ULPS * n.x);
+  real_bits uy = (real_bits)(REAL_OFFSET_ULPS * n.y);
+  real_bits uz = (real_bits)(REAL_OFFSET_ULPS * n.z);
+  Vec3 origin = {
+      fabs(p.x) < REAL_OFFSET_ORIGIN ? p.x + REAL_OFFSET_NEAR_ZERO * n.x
+                                     : real_step_ulps(p.x, ux),
+      fabs(p.y) < REAL_OFFSET_ORIGIN ? p.y + REAL_OFFSET_NEAR_ZERO * n.y
+                                     : real_step_ulps(p.y, uy),
+      fabs(p.z) < REAL_OFFSET_ORIGIN ? p.z + REAL_OFFSET_NEAR_ZERO * n.z
+                                     : real_step_ulps(p.z, uz)};
+  return (Ray){.origin = origin, .direction = direction, .time = time};
+}
+
+// Ray from the surface point `p` (normal `n`) to `target`, reached at t = 1.
+// Aiming from the offset origin rather than reusing the direction from `p`
+// keeps the target at t = 1 however obliquely the ray meets the surface
+// around it, so shadow rays can stop just short of it.
+static inline Ray ray_spawn_to(Vec3 p, Vec3 n, Vec3 target, real time) {
+  Vec3 origin = ray_spawn(p, n, vec3_sub(target, p), time).origin;
+  return (Ray){
+      .origin = origin, .direction = vec3_sub(target, origin), .time = time};
+}
+
 #endif // RAY_H
@@ -0,0 +1,101 @@
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aabb.h"
+#include "interval.h"
+#include "ray.h"
+#include "ray_packet.h"
+#include "vec3.h"
+
+void ray_packet_prepare(RayPacket *self) {
+  for (int axis = 0; axis < 3; axis++) {
+    self->org_bounds[axis] = interval_empty();
+    self->inv_dir_bounds[axis] = interval_empty();
+  }
+  self->t_max_bound = self->t_min;
+  bool positive[3] = {true, true, true};
+  bool negative[3] = {true, true, true};
+
+  for (int k = 0; k < PACKET_RAYS; k++) {
+    self->hit[k] = 0;
+    for (int axis = 0; axis < 3; axis++) {
+      real o = vec3_axis(self->rays[k].origin, axis);
+      real d = vec3_axis(self->rays[k].direction, axis);
+      self->org[axis][k] = o;
+      self->inv_dir[axis][k] = 1 / d;
+      if (!self->active[k])
+        continue;
+      Interval *ob = &self->org_bounds[axis];
+      Interval *ib = &self->inv_dir_bounds[axis];
+      ob->min = fmin(ob->min, o);
+      ob->max = fmax(ob->max, o);
+      ib->min = fmin(ib->min, 1 / d);
+      ib->max = fmax(ib->max, 1 / d);
+      positive[axis] = positive[axis] && d > 0;
+      negative[axis] = negative[axis] && d < 0;
+    }
+    if (self->active[k])
+      self->t_max_bound = fmax(self->t_max_bound, self->t_max[k]);
+  }
+
+  self->coherent = true;
+  for (int axis = 0; axis < 3; axis++)
+    self->coherent = self->coherent && (positive[axis] || negative[axis]);
+}
+
+// Smallest and largest product of a value in `a` and a value in `b`.
+static inline real product_min(Interval a, Interval b) {
+  return fmin(fmin(a.min * b.min, a.min * b.max),
+              fmin(a.max * b.min, a.max * b.max));
+}
+
+static inline real product_max(Interval a, Interval b) {
+  return fmax(fmax(a.min * b.min, a.min * b.max),
+              fmax(a.max * b.min, a.max * b.max));
+}
+
+bool ray_packet_misses_box(const RayPacket *self, const AABB *box) {
+  if (!self->coherent)
+    return false;
+
+  // Every lane enters the box no earlier than t_near and leaves it no later
+  // than t_far, so if those cross, no lane overlaps it
+  real t_near = self->t_min;
+  real t_far = self->t_max_bound;
+  for (int axis = 0; axis < 3; axis++) {
+    Interval slab = axis_interval((AABB *)box, axis);
+    Interval org = self->org_bounds[axis];
+    Interval inv = self->inv_dir_bounds[axis];
+    real near_plane = inv.min > 0 ? slab.min : slab.max;
+    real far_plane = inv.min > 0 ? slab.max : slab.min;
+    Interval to_near = {near_plane - org.max, near_plane - org.min};
+    Interval to_far = {far_plane - org.max, far_plane - org.min};
+    t_near = fmax(t_near, product_min(to_near, inv));
+    t_far = fmin(t_far, product_max(to_far, inv));
+  }
+  return t_far <= t_near;
+}
+
+int ray_packet_hit_box(const RayPacket *self, const AABB *box,
+                       uint8_t *mask) {
+  const real lo[3] = {box->x.min, box->y.min, box->z.min};
+  const real hi[3] = {box->x.max, box->y.max, box->z.max};
+
+  // No early exit per lane: all lanes run the same instructions, so the
+  // loop maps onto vector registers
+  int count = 0;
+  for (int k = 0; k < PACKET_RAYS; k++) {
+    real t_near = self->t_min;
+    real t_far = self->t_max[k];
+    for (int axis = 0; axis < 3; axis++) {
+      real t0 = (lo[axis] - self->org[axis][k]) * self->inv_dir[axis][k];
+      real t1 = (hi[axis] - self->org[axis][k]) * self->inv_dir[axis][k];
+      t_near = fmax(t_near, fmin(t0, t1));
+      t_far = fmin(t_far, fmax(t0, t1));
+    }
+    mask[k] = mask[k] & (t_near < t_far);
+    count += mask[k];
+  }
+  return count;
+}
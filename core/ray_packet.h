@@ -0,0 +1,52 @@
+#ifndef RAY_PACKET_H
+#define RAY_PACKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aabb.h"
+#include "interval.h"
+#include "ray.h"
+
+// Side of the square pixel tile whose camera rays are traced as one packet,
+// and the number of rays in it.
+#define PACKET_SIZE 8
+#define PACKET_RAYS (PACKET_SIZE * PACKET_SIZE)
+
+// A bundle of rays traced through the BVH together. Lanes with active[k]
+// clear are padding, for tiles clipped by the image edge, and are never
+// tested. Origins and inverse directions are also kept as one array per
+// axis so that the per-lane box test is a loop the compiler vectorizes.
+typedef struct RayPacket {
+  Ray rays[PACKET_RAYS];
+  uint8_t active[PACKET_RAYS];
+  uint8_t hit[PACKET_RAYS]; // Set once the lane's ray has hit something
+  real t_min;               // Lower bound shared by every lane
+  real t_max[PACKET_RAYS];  // Upper bound per lane, the closest hit so far
+  real org[3][PACKET_RAYS];
+  real inv_dir[3][PACKET_RAYS];
+
+  // Bounds over the active lanes, used to reject a box for all of them at
+  // once. Only meaningful if `coherent`: every direction component has the
+  // same sign in every lane, so all lanes enter a box through the same slab
+  // planes.
+  Interval org_bounds[3];
+  Interval inv_dir_bounds[3];
+  real t_max_bound;
+  bool coherent;
+} RayPacket;
+
+// Fills in the per-axis arrays and bounds once rays, active, t_min and t_max
+// are set, and clears `hit`.
+extern void ray_packet_prepare(RayPacket *self);
+
+// Interval-arithmetic test of the packet as a whole: returns true only if
+// no active lane can hit `box`. Always false for incoherent packets.
+extern bool ray_packet_misses_box(const RayPacket *self, const AABB *box);
+
+// Slab test of every lane against `box`, in the same form as aabb_hit.
+// Clears the lanes of `mask` whose ray misses and returns how many are left.
+extern int ray_packet_hit_box(const RayPacket *self, const AABB *box,
+                              uint8_t *mask);
+
+#endif // RAY_PACKET_H
@@ -0,0 +1,52 @@
+#ifndef REAL_H
+#define REAL_H
+
+#include <stdint.h>
+#include <string.h>
+#include <tgmath.h>
+
+// Scalar type of the geometry: vectors, intervals, rays, bounding boxes,
+// primitives and materials. Configure with -DRAYTRACER_FLOAT=ON to make it
+// float, which halves the size of every BVH node and triangle and doubles
+// the lanes per vector register. <tgmath.h> makes sqrt, fabs, fmin and the
+// rest pick their float or double version from the arguments, so the same
+// code compiles for either.
+//
+// Random variates, timers and the parsers stay double; they convert when
+// stored into the geometry.
+#ifdef RT_FLOAT
+typedef float real;
+typedef int32_t real_bits; // Same size as real, for stepping by ulps
+#define REAL_NAME "float"
+#define REAL_EPSILON 1.1920929e-7f // Spacing of the reals just above 1
+// Ray origins are pushed REAL_OFFSET_ULPS ulps off the surface, or by
+// REAL_OFFSET_NEAR_ZERO when a coordinate is within REAL_OFFSET_ORIGIN of
+// zero, where ulps are too fine (see ray_spawn)
+#define REAL_OFFSET_ULPS 256
+#define REAL_OFFSET_NEAR_ZERO (1.0f / 65536)
+#else
+typedef double real;
+typedef int64_t real_bits;
+#define REAL_NAME "double"
+#define REAL_EPSILON 2.220446049250313e-16
+#define REAL_OFFSET_ULPS (1 << 20)
+#define REAL_OFFSET_NEAR_ZERO (1.0 / 4294967296.0)
+#endif
+#define REAL_OFFSET_ORIGIN ((real)1 / 32)
+
+// Binary formats that store reals as they are in memory tag their version
+// with sizeof(real), so a float build never maps a double build's file.
+#define REAL_FORMAT_VERSION(version)                                          \
+  ((uint32_t)(version) | (uint32_t)sizeof(real) << 16)
+
+// `x` moved `ulps` representable values up, or down for negative `ulps`.
+// Not for zero, whose neighbours are denormals.
+static inline real real_step_ulps(real x, real_bits ulps) {
+  real_bits bits;
+  memcpy(&bits, &x, sizeof(bits));
+  bits += x < 0 ? -ulps : ulps;
+  memcpy(&x, &bits, sizeof(x));
+  return x;
+}
+
+#endif // REAL_H
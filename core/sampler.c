@@ -0,0 +1,300 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "sampler.h"
+#include "util.h"
+
+#define BLUE_NOISE_SIZE 64 // Power of two, the mask tiles the image
+#define BLUE_NOISE_PIXELS (BLUE_NOISE_SIZE * BLUE_NOISE_SIZE)
+#define BLUE_NOISE_SIGMA 1.5
+
+// Maps 32 random bits to [0, 1)
+#define U32_TO_UNIT (1.0 / 4294967296.0)
+
+// Rank of every mask pixel in the void-and-cluster ordering. Thresholding
+// at any rank leaves a blue-noise point set.
+static uint16_t blue_noise_rank[BLUE_NOISE_PIXELS];
+static bool blue_noise_ready = false;
+
+// Integer finaliser with good avalanche (Wellons' "lowbias32").
+static uint32_t hash_u32(uint32_t x) {
+  x ^= x >> 16;
+  x *= 0x7feb352du;
+  x ^= x >> 15;
+  x *= 0x846ca68bu;
+  x ^= x >> 16;
+  return x;
+}
+
+static uint32_t hash_combine(uint32_t seed, uint32_t v) {
+  return hash_u32(seed ^ (v + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+static uint32_t reverse_bits(uint32_t x) {
+  x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+  x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+  x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+  x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+  return (x >> 16) | (x << 16);
+}
+
+// Hash that only lets each bit affect higher bits (Burley, "Practical
+// Hash-based Owen Scrambling", with Vegdahl's constants). Applied to a
+// bit-reversed value it flips every digit depending only on the digits
+// above it, which is exactly a nested uniform (Owen) scramble.
+static uint32_t laine_karras_permutation(uint32_t x, uint32_t seed) {
+  x ^= x * 0x3d20adeau;
+  x += seed;
+  x *= (seed >> 16) | 1;
+  x ^= x * 0x05526c56u;
+  x ^= x * 0x53a22864u;
+  return x;
+}
+
+static uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed) {
+  return reverse_bits(laine_karras_permutation(reverse_bits(x), seed));
+}
+
+// The first two Sobol dimensions form a (0,2)-sequence: every power-of-two
+// prefix is stratified in all elementary intervals of the unit square.
+static uint32_t sobol_dim0(uint32_t index) { return reverse_bits(index); }
+
+static uint32_t sobol_dim1(uint32_t index) {
+  uint32_t x = 0;
+  for (uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1) {
+    if (index & 1)
+      x ^= v;
+  }
+  return x;
+}
+
+// Point `index` of the Owen-scrambled (0,2)-sequence selected by `seed`.
+// The index is shuffled by the same kind of scramble first, so that
+// requests with different seeds pad into independent higher dimensions
+// while every power-of-two prefix stays a (0,m,2)-net.
+static void sobol_owen_2d(uint32_t index, uint32_t seed, uint32_t *x,
+                          uint32_t *y) {
+  index = nested_uniform_scramble(index, seed);
+  *x = nested_uniform_scramble(sobol_dim0(index), hash_combine(seed, 1));
+  if (y)
+    *y = nested_uniform_scramble(sobol_dim1(index), hash_combine(seed, 2));
+}
+
+// Adds `sign` times the toroidal Gaussian around `p` to every pixel energy.
+static void void_cluster_splat(double *energy, const double *kernel, int p,
+                               double sign) {
+  int px = p % BLUE_NOISE_SIZE;
+  int py = p / BLUE_NOISE_SIZE;
+  for (int y = 0; y < BLUE_NOISE_SIZE; y++) {
+    const double *row =
+        kernel + ((y - py) & (BLUE_NOISE_SIZE - 1)) * BLUE_NOISE_SIZE;
+    double *out = energy + y * BLUE_NOISE_SIZE;
+    for (int x = 0; x < BLUE_NOISE_SIZE; x++)
+      out[x] += sign * row[(x - px) & (BLUE_NOISE_SIZE - 1)];
+  }
+}
+
+// Pixel with the highest (`tightest`) or lowest energy among those whose
+// bit equals `bit`.
+static int void_cluster_find(const double *energy, const uint8_t *bits,
+                             uint8_t bit, bool tightest) {
+  int best = -1;
+  for (int i = 0; i < BLUE_NOISE_PIXELS; i++) {
+    if (bits[i] != bit)
+      continue;
+    if (best < 0 || (tightest ? energy[i] > energy[best]
+                              : energy[i] < energy[best]))
+      best = i;
+  }
+  assert(best >= 0);
+  return best;
+}
+
+// Ulichney's void-and-cluster method. Runs once, about 30M multiply-adds.
+static void blue_noise_generate(void) {
+  static double kernel[BLUE_NOISE_PIXELS];
+  static double energy[BLUE_NOISE_PIXELS];
+  static double saved_energy[BLUE_NOISE_PIXELS];
+  static uint8_t bits[BLUE_NOISE_PIXELS];
+  static uint8_t saved_bits[BLUE_NOISE_PIXELS];
+
+  for (int y = 0; y < BLUE_NOISE_SIZE; y++) {
+    int dy = MIN(y, BLUE_NOISE_SIZE - y);
+    for (int x = 0; x < BLUE_NOISE_SIZE; x++) {
+      int dx = MIN(x, BLUE_NOISE_SIZE - x);
+      kernel[y * BLUE_NOISE_SIZE + x] =
+          exp(-(dx * dx + dy * dy) / (2.0 * BLUE_NOISE_SIGMA * BLUE_NOISE_SIGMA));
+    }
+  }
+
+  // Random initial pattern with a tenth of the pixels set
+  memset(bits, 0, sizeof(bits));
+  memset(energy, 0, sizeof(energy));
+  int ones = 0;
+  for (uint32_t i = 0; ones < BLUE_NOISE_PIXELS / 10; i++) {
+    int p = hash_u32(i) % BLUE_NOISE_PIXELS;
+    if (!bits[p]) {
+      bits[p] = 1;
+      void_cluster_splat(energy, kernel, p, 1.0);
+      ones++;
+    }
+  }
+
+  // Move the tightest cluster into the largest void until that is a no-op
+  for (int iter = 0; iter < BLUE_NOISE_PIXELS; iter++) {
+    int cluster = void_cluster_find(energy, bits, 1, true);
+    bits[cluster] = 0;
+    void_cluster_splat(energy, kernel, cluster, -1.0);
+    int hole = void_cluster_find(energy, bits, 0, false);
+    bits[hole] = 1;
+    void_cluster_splat(energy, kernel, hole, 1.0);
+    if (hole == cluster)
+      break;
+  }
+  memcpy(saved_bits, bits, sizeof(bits));
+  memcpy(saved_energy, energy, sizeof(energy));
+
+  // Phase 1: rank the initial points by removing tightest clusters
+  for (int rank = ones - 1; rank >= 0; rank--) {
+    int cluster = void_cluster_find(energy, bits, 1, true);
+    bits[cluster] = 0;
+    void_cluster_splat(energy, kernel, cluster, -1.0);
+    blue_noise_rank[cluster] = (uint16_t)rank;
+  }
+  memcpy(bits, saved_bits, sizeof(bits));
+  memcpy(energy, saved_energy, sizeof(energy));
+
+  // Phase 2: fill the largest voids up to half the pixels
+  int rank = ones;
+  for (; rank < BLUE_NOISE_PIXELS / 2; rank++) {
+    int hole = void_cluster_find(energy, bits, 0, false);
+    bits[hole] = 1;
+    void_cluster_splat(energy, kernel, hole, 1.0);
+    blue_noise_rank[hole] = (uint16_t)rank;
+  }
+
+  // Phase 3: the unset pixels are now the minority, so switch to their
+  // energy and set the tightest cluster of them each step
+  memset(energy, 0, sizeof(energy));
+  for (int i = 0; i < BLUE_NOISE_PIXELS; i++) {
+    if (!bits[i])
+      void_cluster_splat(energy, kernel, i, 1.0);
+  }
+  for (; rank < BLUE_NOISE_PIXELS; rank++) {
+    int cluster = void_cluster_find(energy, bits, 0, true);
+    bits[cluster] = 1;
+    void_cluster_splat(energy, kernel, cluster, -1.0);
+    blue_noise_rank[cluster] = (uint16_t)rank;
+  }
+
+  blue_noise_ready = true;
+}
+
+// Blue-noise value in [0, 1) at pixel (px, py) of the mask moved by an
+// offset taken from `seed`, so that different requests see decorrelated
+// shifts.
+static double blue_noise_shift(int px, int py, uint32_t seed) {
+  uint32_t h = hash_u32(seed);
+  int x = (px + (int)(h & 0xffff)) & (BLUE_NOISE_SIZE - 1);
+  int y = (py + (int)(h >> 16)) & (BLUE_NOISE_SIZE - 1);
+  return (blue_noise_rank[y * BLUE_NOISE_SIZE + x] + 0.5) / BLUE_NOISE_PIXELS;
+}
+
+static double wrap_unit(double u) {
+  u -= (int)u;
+  return u < 1.0 ? u : 0.0;
+}
+
+Sampler sampler_make(SamplerType type, uint32_t seed) {
+  if (type == SAMPLER_BLUE_NOISE && !blue_noise_ready)
+    blue_noise_generate();
+  return (Sampler){.type = type, .seed = hash_u32(seed)};
+}
+
+bool sampler_type_parse(const char *name, SamplerType *type) {
+  if (strcmp(name, "independent") == 0)
+    *type = SAMPLER_INDEPENDENT;
+  else if (strcmp(name, "sobol") == 0)
+    *type = SAMPLER_SOBOL;
+  else if (strcmp(name, "bluenoise") == 0)
+    *type = SAMPLER_BLUE_NOISE;
+  else
+    return false;
+  return true;
+}
+
+const char *sampler_type_name(SamplerType type) {
+  switch (type) {
+  case SAMPLER_INDEPENDENT:
+    return "independent";
+  case SAMPLER_SOBOL:
+    return "sobol";
+  case SAMPLER_BLUE_NOISE:
+    return "bluenoise";
+  }
+  return "unknown";
+}
+
+void sampler_start_pixel_sample(Sampler *self, int px, int py,
+                                uint32_t index) {
+  assert(self != NULL);
+  self->px = px;
+  self->py = py;
+  self->pixel_seed =
+      hash_combine(hash_combine(self->seed, (uint32_t)px), (uint32_t)py);
+  self->index = index;
+  self->dimension = 0;
+}
+
+double sampler_get_1d(Sampler *self) {
+  assert(self != NULL);
+  uint32_t dimension = self->dimension++;
+  uint32_t x;
+  switch (self->type) {
+  case SAMPLER_SOBOL:
+    sobol_owen_2d(self->index, hash_combine(self->pixel_seed, dimension), &x,
+                  NULL);
+    return x * U32_TO_UNIT;
+  case SAMPLER_BLUE_NOISE: {
+    uint32_t seed = hash_combine(self->seed, dimension);
+    sobol_owen_2d(self->index, seed, &x, NULL);
+    return wrap_unit(x * U32_TO_UNIT +
+                     blue_noise_shift(self->px, self->py, seed));
+  }
+  case SAMPLER_INDEPENDENT:
+    break;
+  }
+  return random_double();
+}
+
+void sampler_get_2d(Sampler *self, double *u1, double *u2) {
+  assert(self != NULL);
+  uint32_t dimension = self->dimension++;
+  uint32_t x, y;
+  switch (self->type) {
+  case SAMPLER_SOBOL:
+    sobol_owen_2d(self->index, hash_combine(self->pixel_seed, dimension), &x,
+                  &y);
+    *u1 = x * U32_TO_UNIT;
+    *u2 = y * U32_TO_UNIT;
+    return;
+  case SAMPLER_BLUE_NOISE: {
+    // Both coordinates share the point set but take their shifts from
+    // different places in the mask
+    uint32_t seed = hash_combine(self->seed, dimension);
+    sobol_owen_2d(self->index, seed, &x, &y);
+    *u1 = wrap_unit(x * U32_TO_UNIT +
+                    blue_noise_shift(self->px, self->py, seed));
+    *u2 = wrap_unit(y * U32_TO_UNIT +
+                    blue_noise_shift(self->px, self->py, ~seed));
+    return;
+  }
+  case SAMPLER_INDEPENDENT:
+    break;
+  }
+  *u1 = random_double();
+  *u2 = random_double();
+}
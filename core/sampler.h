@@ -0,0 +1,49 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Source of the uniform variates a path consumes. Every camera sample starts
+// with sampler_start_pixel_sample, after which the path asks for its
+// variates one request at a time, 1D or 2D. Requests are numbered in the
+// order they are made, and request k of every sample in a pixel is drawn
+// from the same well-distributed point set, so consumers that always make
+// their requests in the same order get stratification across samples.
+typedef enum {
+  SAMPLER_INDEPENDENT, // rand(), no correlation between samples
+  SAMPLER_SOBOL,       // Owen-scrambled Sobol, scrambled per pixel
+  SAMPLER_BLUE_NOISE,  // One Owen-scrambled Sobol set, shifted per pixel by
+                       // blue noise
+} SamplerType;
+
+typedef struct Sampler {
+  SamplerType type;
+  uint32_t seed;       // Scramble seed of the whole image
+  uint32_t pixel_seed; // `seed` hashed with the pixel coordinates
+  int px, py;
+  uint32_t index;     // Sample index within the pixel
+  uint32_t dimension; // Number of the next request
+} Sampler;
+
+extern Sampler sampler_make(SamplerType type, uint32_t seed);
+
+// Parses "independent", "sobol" or "bluenoise".
+extern bool sampler_type_parse(const char *name, SamplerType *type);
+extern const char *sampler_type_name(SamplerType type);
+
+extern void sampler_start_pixel_sample(Sampler *self, int px, int py,
+                                       uint32_t index);
+extern double sampler_get_1d(Sampler *self);
+extern void sampler_get_2d(Sampler *self, double *u1, double *u2);
+
+// Moves to request `dimension`. Integrators whose bounces make a varying
+// number of requests use it to start every bounce on a fixed request number.
+static inline uint32_t sampler_dimension(const Sampler *self) {
+  return self->dimension;
+}
+static inline void sampler_set_dimension(Sampler *self, uint32_t dimension) {
+  self->dimension = dimension;
+}
+
+#endif // SAMPLER_H
@@ -0,0 +1,69 @@
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "fast_math.h"
+#include "vec3.h"
+
+// Closed-form warps from uniform variates (u1, u2) in [0, 1)^2 to common
+// domains. Each one consumes exactly the variates it is given, so it keeps
+// the stratification of low-discrepancy samples and has no data-dependent
+// loop. Directions are in a local frame around +z; map them with onb_local.
+
+// Uniform point in the unit disk in the xy plane by Shirley and Chiu's
+// concentric map, which keeps neighbouring samples neighbours and only
+// needs sin and cos within one octant.
+static inline Vec3 sample_uniform_disk_concentric(double u1, double u2) {
+  double ox = 2 * u1 - 1;
+  double oy = 2 * u2 - 1;
+  // Which axis is major is a coin flip per sample, so select, don't branch
+  bool x_major = fabs(ox) > fabs(oy);
+  double r = x_major ? ox : oy;
+  double minor = x_major ? oy : ox;
+  if (r == 0)
+    return vec3_zero();
+
+  double s, c;
+  fast_sincos_octant(PI / 4 * (minor / r), &s, &c);
+  return (Vec3){r * (x_major ? c : s), r * (x_major ? s : c), 0};
+}
+
+// Cosine-weighted direction about +z (Malley's method), pdf cos(theta) / pi.
+static inline Vec3 sample_cosine_hemisphere(double u1, double u2) {
+  Vec3 d = sample_uniform_disk_concentric(u1, u2);
+  d.z = sqrt(fmax(0.0, 1 - d.x * d.x - d.y * d.y));
+  return d;
+}
+
+// Uniform direction on the unit sphere, pdf 1 / (4 pi).
+static inline Vec3 sample_uniform_sphere(double u1, double u2) {
+  double z = 1 - 2 * u1;
+  double r = sqrt(fmax(0.0, 1 - z * z));
+  double s, c;
+  fast_sincos_turns(u2, &s, &c);
+  return (Vec3){r * c, r * s, z};
+}
+
+// Uniform direction in the cone about +z with half-angle theta_max, given as
+// 1 - cos(theta_max) so that narrow cones keep their precision. Pdf
+// 1 / (2 pi (1 - cos(theta_max))).
+static inline Vec3 sample_uniform_cone(double u1, double u2,
+                                       double one_minus_cos_max) {
+  double one_minus_cos = u1 * one_minus_cos_max;
+  double sin_theta = sqrt(fmax(0.0, one_minus_cos * (2 - one_minus_cos)));
+  double s, c;
+  fast_sincos_turns(u2, &s, &c);
+  return (Vec3){c * sin_theta, s * sin_theta, 1 - one_minus_cos};
+}
+
+// Power heuristic (beta = 2) weight for a sample drawn with density `pdf_a`
+// that another strategy could have produced with density `pdf_b`.
+static inline double power_heuristic(double pdf_a, double pdf_b) {
+  double a = pdf_a * pdf_a;
+  double b = pdf_b * pdf_b;
+  return a / (a + b);
+}
+
+#endif // SAMPLING_H
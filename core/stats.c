@@ -0,0 +1,30 @@
+#include <stdio.h>
+
+#include "stats.h"
+
+#ifdef RT_STATS
+RenderStats render_stats = {0};
+
+void stats_print(FILE *out) {
+  double rays = render_stats.rays > 0 ? (double)render_stats.rays : 1.0;
+  fprintf(out, "=== TRAVERSAL STATS ===\n");
+  fprintf(out, "Rays:              %llu\n", render_stats.rays);
+  fprintf(out, "BVH nodes visited: %llu (%.2f per ray)\n",
+          render_stats.bvh_nodes_visited,
+          render_stats.bvh_nodes_visited / rays);
+  fprintf(out, "BVH nodes culled:  %llu (%.2f per ray)\n",
+          render_stats.bvh_nodes_culled, render_stats.bvh_nodes_culled / rays);
+  fprintf(out, "Primitive tests:   %llu (%.2f per ray)\n",
+          render_stats.primitive_tests, render_stats.primitive_tests / rays);
+  if (render_stats.packet_nodes_visited > 0) {
+    fprintf(out, "Packet nodes:      %llu visited, %llu culled\n",
+            render_stats.packet_nodes_visited,
+            render_stats.packet_nodes_culled);
+    fprintf(out, "Packet fallbacks:  %llu rays traced alone\n",
+            render_stats.packet_single_rays);
+  }
+  fprintf(out, "=======================\n");
+}
+#else
+void stats_print(FILE *out) { (void)out; }
+#endif
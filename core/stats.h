@@ -0,0 +1,26 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+// Traversal counters, compiled in with -DRAYTRACER_STATS=ON.
+typedef struct RenderStats {
+  unsigned long long rays;
+  unsigned long long bvh_nodes_visited;
+  unsigned long long bvh_nodes_culled;
+  unsigned long long primitive_tests;
+  unsigned long long packet_nodes_visited; // BVH nodes tested by ray packets
+  unsigned long long packet_nodes_culled;  // ... and missed by every lane
+  unsigned long long packet_single_rays;   // Lanes left to trace alone
+} RenderStats;
+
+#ifdef RT_STATS
+extern RenderStats render_stats;
+#define STATS_INC(field) (render_stats.field++)
+#else
+#define STATS_INC(field) ((void)0)
+#endif
+
+extern void stats_print(FILE *out);
+
+#endif // STATS_H
@@ -0,0 +1,123 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+#define THREAD_POOL_MAX_THREADS 64
+
+typedef struct ThreadPoolJob {
+  ThreadPoolJobFn fn;
+  void *ctx;
+  struct ThreadPoolJob *next;
+} ThreadPoolJob;
+
+struct ThreadPool {
+  pthread_t threads[THREAD_POOL_MAX_THREADS];
+  int thread_count;
+
+  pthread_mutex_t lock;
+  pthread_cond_t job_ready; // Signalled when a job is queued or on shutdown
+  pthread_cond_t idle;      // Signalled when the last pending job finishes
+  ThreadPoolJob *first, *last;
+  int pending; // Queued or running
+  bool stopping;
+};
+
+static void *thread_pool_worker(void *arg) {
+  ThreadPool *self = arg;
+  pthread_mutex_lock(&self->lock);
+  while (true) {
+    while (!self->first && !self->stopping)
+      pthread_cond_wait(&self->job_ready, &self->lock);
+    if (!self->first)
+      break;
+    ThreadPoolJob *job = self->first;
+    self->first = job->next;
+    if (!self->first)
+      self->last = NULL;
+    pthread_mutex_unlock(&self->lock);
+
+    job->fn(job->ctx);
+    free(job);
+
+    pthread_mutex_lock(&self->lock);
+    if (--self->pending == 0)
+      pthread_cond_broadcast(&self->idle);
+  }
+  pthread_mutex_unlock(&self->lock);
+  return NULL;
+}
+
+ThreadPool *thread_pool_create(int threads) {
+  if (threads <= 0) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cpus > 0 ? (int)cpus : 1;
+  }
+  if (threads > THREAD_POOL_MAX_THREADS)
+    threads = THREAD_POOL_MAX_THREADS;
+
+  ThreadPool *self = calloc(1, sizeof(ThreadPool));
+  assert(self != NULL);
+  pthread_mutex_init(&self->lock, NULL);
+  pthread_cond_init(&self->job_ready, NULL);
+  pthread_cond_init(&self->idle, NULL);
+  for (int k = 0; k < threads; k++) {
+    if (pthread_create(&self->threads[self->thread_count], NULL,
+                       thread_pool_worker, self) != 0)
+      break;
+    self->thread_count++;
+  }
+  return self;
+}
+
+void thread_pool_submit(ThreadPool *self, ThreadPoolJobFn fn, void *ctx) {
+  assert(self != NULL && fn != NULL);
+  if (self->thread_count == 0) {
+    fn(ctx);
+    return;
+  }
+  ThreadPoolJob *job = malloc(sizeof(ThreadPoolJob));
+  assert(job != NULL);
+  job->fn = fn;
+  job->ctx = ctx;
+  job->next = NULL;
+
+  pthread_mutex_lock(&self->lock);
+  if (self->last)
+    self->last->next = job;
+  else
+    self->first = job;
+  self->last = job;
+  self->pending++;
+  pthread_cond_signal(&self->job_ready);
+  pthread_mutex_unlock(&self->lock);
+}
+
+void thread_pool_wait(ThreadPool *self) {
+  assert(self != NULL);
+  pthread_mutex_lock(&self->lock);
+  while (self->pending > 0)
+    pthread_cond_wait(&self->idle, &self->lock);
+  pthread_mutex_unlock(&self->lock);
+}
+
+void thread_pool_destroy(ThreadPool *self) {
+  if (!self)
+    return;
+  thread_pool_wait(self);
+  pthread_mutex_lock(&self->lock);
+  self->stopping = true;
+  pthread_cond_broadcast(&self->job_ready);
+  pthread_mutex_unlock(&self->lock);
+  for (int k = 0; k < self->thread_count; k++)
+    pthread_join(self->threads[k], NULL);
+  pthread_cond_destroy(&self->idle);
+  pthread_cond_destroy(&self->job_ready);
+  pthread_mutex_destroy(&self->lock);
+  free(self);
+}
+
+int thread_pool_size(const ThreadPool *self) { return self->thread_count; }
@@ -0,0 +1,24 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Fixed set of worker threads running submitted jobs in submission order.
+// Used to load scene assets in the background while parsing goes on.
+typedef struct ThreadPool ThreadPool;
+typedef void (*ThreadPoolJobFn)(void *ctx);
+
+// Starts `threads` workers, or one per CPU if `threads` is 0 or less. If no
+// worker can be started, jobs run inside thread_pool_submit instead.
+extern ThreadPool *thread_pool_create(int threads);
+
+extern void thread_pool_submit(ThreadPool *self, ThreadPoolJobFn fn,
+                               void *ctx);
+
+// Returns once every job submitted so far has finished.
+extern void thread_pool_wait(ThreadPool *self);
+
+// Waits for the remaining jobs and stops the workers.
+extern void thread_pool_destroy(ThreadPool *self);
+
+extern int thread_pool_size(const ThreadPool *self);
+
+#endif // THREAD_POOL_H
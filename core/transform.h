@@ -0,0 +1,99 @@
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <math.h>
+#include <stdbool.h>
+
+#include "util.h"
+#include "vec3.h"
+
+// Tolerance for comparing the entries of a transform, which are computed and
+// composed in `real` precision.
+#define TRANSFORM_EPSILON (16 * REAL_EPSILON)
+
+// Affine transform: p' = m * p + offset
+typedef struct Transform {
+  real m[3][3];
+  Vec3 offset;
+} Transform;
+
+static inline Transform transform_identity(void) {
+  return (Transform){.m = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+                     .offset = {0, 0, 0}};
+}
+
+static inline Transform transform_translation(Vec3 offset) {
+  Transform xf = transform_identity();
+  xf.offset = offset;
+  return xf;
+}
+
+// Rotation about the Y axis, matching the convention of rotate_y_create.
+static inline Transform transform_rotation_y(real angle_degrees) {
+  real radians = degrees_to_radians(angle_degrees);
+  real c = cos(radians);
+  real s = sin(radians);
+  return (Transform){.m = {{c, 0, s}, {0, 1, 0}, {-s, 0, c}},
+                     .offset = {0, 0, 0}};
+}
+
+// Rotation about the X axis: y toward z for positive angles.
+static inline Transform transform_rotation_x(real angle_degrees) {
+  real radians = degrees_to_radians(angle_degrees);
+  real c = cos(radians);
+  real s = sin(radians);
+  return (Transform){.m = {{1, 0, 0}, {0, c, -s}, {0, s, c}},
+                     .offset = {0, 0, 0}};
+}
+
+// Rotation about the Z axis: x toward y for positive angles.
+static inline Transform transform_rotation_z(real angle_degrees) {
+  real radians = degrees_to_radians(angle_degrees);
+  real c = cos(radians);
+  real s = sin(radians);
+  return (Transform){.m = {{c, -s, 0}, {s, c, 0}, {0, 0, 1}},
+                     .offset = {0, 0, 0}};
+}
+
+static inline Transform transform_scale(Vec3 scale) {
+  return (Transform){.m = {{scale.x, 0, 0}, {0, scale.y, 0}, {0, 0, scale.z}},
+                     .offset = {0, 0, 0}};
+}
+
+static inline Vec3 transform_vector(const Transform *xf, Vec3 v) {
+  return (Vec3){xf->m[0][0] * v.x + xf->m[0][1] * v.y + xf->m[0][2] * v.z,
+                xf->m[1][0] * v.x + xf->m[1][1] * v.y + xf->m[1][2] * v.z,
+                xf->m[2][0] * v.x + xf->m[2][1] * v.y + xf->m[2][2] * v.z};
+}
+
+static inline Vec3 transform_point(const Transform *xf, Vec3 p) {
+  return vec3_add(transform_vector(xf, p), xf->offset);
+}
+
+// Returns the transform that applies `inner` first and then `outer`.
+static inline Transform transform_compose(const Transform *outer,
+                                          const Transform *inner) {
+  Transform res;
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      res.m[i][j] = outer->m[i][0] * inner->m[0][j] +
+                    outer->m[i][1] * inner->m[1][j] +
+                    outer->m[i][2] * inner->m[2][j];
+    }
+  }
+  res.offset = transform_point(outer, inner->offset);
+  return res;
+}
+
+// Returns true if the linear part has no rotation or scale.
+static inline bool transform_is_translation(const Transform *xf) {
+  for (int i = 0; i < 3; i++) {
+    for (int j = 0; j < 3; j++) {
+      if (fabs(xf->m[i][j] - (i == j ? 1.0 : 0.0)) > TRANSFORM_EPSILON)
+        return false;
+    }
+  }
+  return true;
+}
+
+#endif // TRANSFORM_H
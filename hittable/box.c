@@ -0,0 +1,213 @@
+#include <assert.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "box.h"
+#include "core/aabb.h"
+#include "core/arena.h"
+#include "core/interval.h"
+#include "core/transform.h"
+#include "core/vec3.h"
+#include "hit_record.h"
+#include "hittable.h"
+#include "material/material.h"
+
+typedef struct Box {
+  Vec3 min;
+  Vec3 max;
+} Box;
+
+// Maps the hit point on the face perpendicular to `axis` to [0,1]^2.
+static void get_box_uv(const Box *box, Vec3 p, int axis, real *u,
+                       real *v) {
+  int a = (axis + 1) % 3;
+  int b = (axis + 2) % 3;
+  *u = (vec3_axis(p, a) - vec3_axis(box->min, a)) /
+       (vec3_axis(box->max, a) - vec3_axis(box->min, a));
+  *v = (vec3_axis(p, b) - vec3_axis(box->min, b)) /
+       (vec3_axis(box->max, b) - vec3_axis(box->min, b));
+}
+
+// Single slab test against all three axes. The face normal comes from the
+// axis that produced the accepted entry (or, from inside, exit) distance;
+// `face` is that axis, plus 3 for the +axis side.
+static inline bool box_intersect(const Box *box, Ray ray, Interval t_bounds,
+                                 real *t_hit, int *face) {
+  real t_near = -INFINITY;
+  real t_far = INFINITY;
+  int near_axis = 0;
+  int far_axis = 0;
+
+  for (int axis = 0; axis < 3; axis++) {
+    real adinv = 1 / vec3_axis(ray.direction, axis);
+    real origin = vec3_axis(ray.origin, axis);
+    real t0 = (vec3_axis(box->min, axis) - origin) * adinv;
+    real t1 = (vec3_axis(box->max, axis) - origin) * adinv;
+    if (t0 > t1) {
+      real tmp = t0;
+      t0 = t1;
+      t1 = tmp;
+    }
+    if (t0 > t_near) {
+      t_near = t0;
+      near_axis = axis;
+    }
+    if (t1 < t_far) {
+      t_far = t1;
+      far_axis = axis;
+    }
+    if (t_far <= t_near)
+      return false;
+  }
+
+  real t;
+  int axis;
+  bool positive_face;
+  if (interval_surrounds(t_bounds, t_near)) {
+    // Entering: the outward normal faces against the ray
+    t = t_near;
+    axis = near_axis;
+    positive_face = vec3_axis(ray.direction, axis) < 0;
+  } else if (interval_surrounds(t_bounds, t_far)) {
+    // Leaving from inside: the outward normal faces along the ray
+    t = t_far;
+    axis = far_axis;
+    positive_face = vec3_axis(ray.direction, axis) > 0;
+  } else {
+    return false;
+  }
+
+  *t_hit = t;
+  *face = axis + (positive_face ? 3 : 0);
+  return true;
+}
+
+bool box_hit(const Hittable *self, Ray ray, Interval t_bounds,
+             HitRecord *rec) {
+  assert(self != NULL);
+  assert(rec != NULL);
+
+  real t;
+  int face;
+  if (!box_intersect((const Box *)self->data, ray, t_bounds, &t, &face))
+    return false;
+
+  // The face is the box's sub-primitive
+  rec->t = t;
+  rec->obj = self;
+  rec->prim_index = face;
+  return true;
+}
+
+bool box_occluded(const Hittable *self, Ray ray, Interval t_bounds) {
+  real t;
+  int face;
+  return box_intersect((const Box *)self->data, ray, t_bounds, &t, &face);
+}
+
+static void box_finalize(const Hittable *self, Ray ray, HitRecord *rec) {
+  const Box *box = (const Box *)self->data;
+  int axis = rec->prim_index % 3;
+  real sign = rec->prim_index >= 3 ? 1.0 : -1.0;
+
+  // The hit point is snapped onto the face, see ray_spawn
+  Vec3 outward_normal = vec3_zero();
+  rec->p = ray_at(ray, rec->t);
+  if (axis == 0) {
+    outward_normal.x = sign;
+    rec->p.x = sign > 0 ? box->max.x : box->min.x;
+  } else if (axis == 1) {
+    outward_normal.y = sign;
+    rec->p.y = sign > 0 ? box->max.y : box->min.y;
+  } else {
+    outward_normal.z = sign;
+    rec->p.z = sign > 0 ? box->max.z : box->min.z;
+  }
+
+  rec->mat = self->mat;
+  hitrec_set_face_normal(rec, ray, outward_normal);
+  get_box_uv(box, rec->p, axis, &rec->u, &rec->v);
+}
+
+static void box_destroy(void *self) {
+  assert(self != NULL);
+  Hittable *hittable = (Hittable *)self;
+  assert(hittable->data);
+  rt_free(hittable->data);
+  rt_free(self);
+}
+
+static AABB box_bbox(const Box *box) {
+  // Pad flat boxes so the BVH never sees a zero-width slab
+  const real padding = 0.0001;
+  AABB bbox = aabb_from_points(box->min, box->max);
+  if (interval_size(bbox.x) < padding)
+    bbox.x = interval_expand(bbox.x, padding);
+  if (interval_size(bbox.y) < padding)
+    bbox.y = interval_expand(bbox.y, padding);
+  if (interval_size(bbox.z) < padding)
+    bbox.z = interval_expand(bbox.z, padding);
+  return bbox;
+}
+
+Hittable *box_create(Vec3 a, Vec3 b, Material *mat) {
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
+  assert(hittable != NULL);
+
+  Box *box_data = rt_alloc(sizeof(struct Box));
+  assert(box_data != NULL);
+
+  box_data->min = (Vec3){fmin(a.x, b.x), fmin(a.y, b.y), fmin(a.z, b.z)};
+  box_data->max = (Vec3){fmax(a.x, b.x), fmax(a.y, b.y), fmax(a.z, b.z)};
+
+  hittable->type = HITTABLE_BOX;
+  hittable->hit = box_hit;
+  hittable->occluded = box_occluded;
+  hittable->finalize = box_finalize;
+  hittable->destroy = (HittableDestroyFn)box_destroy;
+  hittable->mat = mat;
+  hittable->data = box_data;
+  hittable->bbox = box_bbox(box_data);
+
+  return hittable;
+}
+
+bool box_apply_transform(Hittable *self, const Transform *xf) {
+  assert(self != NULL && self->type == HITTABLE_BOX);
+  Box *box = (Box *)self->data;
+
+  // Only transforms that keep the box axis-aligned can be baked: every row of
+  // the linear part must be a single +-1 (translations and quarter turns).
+  for (int i = 0; i < 3; i++) {
+    int unit_entries = 0;
+    for (int j = 0; j < 3; j++) {
+      real m = fabs(xf->m[i][j]);
+      if (fabs(m - 1.0) < TRANSFORM_EPSILON)
+        unit_entries++;
+      else if (m > TRANSFORM_EPSILON)
+        return false;
+    }
+    if (unit_entries != 1)
+      return false;
+  }
+
+  Vec3 a = transform_point(xf, box->min);
+  Vec3 b = transform_point(xf, box->max);
+  box->min = (Vec3){fmin(a.x, b.x), fmin(a.y, b.y), fmin(a.z, b.z)};
+  box->max = (Vec3){fmax(a.x, b.x), fmax(a.y, b.y), fmax(a.z, b.z)};
+  self->bbox = box_bbox(box);
+  return true;
+}
+
+void box_print(const Hittable *hittable) {
+  if (hittable == NULL || hittable->type != HITTABLE_BOX) {
+    printf("Box: Invalid or NULL\n");
+    return;
+  }
+  const Box *box = (const Box *)hittable->data;
+  printf("Box { min: (%.3f, %.3f, %.3f), max: (%.3f, %.3f, %.3f) }\n",
+         box->min.x, box->min.y, box->min.z, box->max.x, box->max.y,
+         box->max.z);
+}
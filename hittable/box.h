@@ -0,0 +1,17 @@
+#ifndef BOX_H
+#define BOX_H
+
+#include "core/transform.h"
+#include "hittable.h"
+#include "material/material.h"
+
+// Axis-aligned box spanning the corners `a` and `b`. Rotated boxes are made
+// by wrapping it in a rotate_y node.
+extern Hittable *box_create(Vec3 a, Vec3 b, Material *mat);
+extern bool box_hit(const Hittable *self, Ray ray, Interval t_bounds,
+                    HitRecord *rec);
+extern bool box_occluded(const Hittable *self, Ray ray, Interval t_bounds);
+extern void box_print(const Hittable *hittable);
+extern bool box_apply_transform(Hittable *self, const Transform *xf);
+
+#endif // BOX_H
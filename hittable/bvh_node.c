@@ -2,14 +2,20 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "bvh_node.h"
 #include "core/aabb.h"
+#include "core/arena.h"
 #include "core/dyn_array.h"
 #include "core/interval.h"
 #include "core/ray.h"
+#include "core/ray_packet.h"
+#include "core/stats.h"
 #include "hit_record.h"
 #include "hittable.h"
+#include "hittable_dispatch.h"
+#include "paged_mesh.h"
 
 #include "material/material.h"
 
@@ -22,18 +28,104 @@ bool bvhnode_hit(Hittable *self, Ray ray, Interval t_bounds, HitRecord *rec) {
   assert(self != NULL);
   assert(rec != NULL);
 
+  STATS_INC(bvh_nodes_visited);
   if (!aabb_hit(&self->bbox, ray, &t_bounds)) {
+    STATS_INC(bvh_nodes_culled);
     return false;
   }
 
   BVHNode *node = self->data;
-  bool hit_left = node->left->hit(node->left, ray, t_bounds, rec);
+#ifdef RT_STATS
+  if (node->left->type != HITTABLE_BVHNODE)
+    STATS_INC(primitive_tests);
+  if (node->right != node->left && node->right->type != HITTABLE_BVHNODE)
+    STATS_INC(primitive_tests);
+#endif
+  bool hit_left = hittable_hit(node->left, ray, t_bounds, rec);
+  // Single-object leaves store the object on both sides; test it once
+  if (node->right == node->left)
+    return hit_left;
   Interval new_interval =
       interval_make(t_bounds.min, hit_left ? rec->t : t_bounds.max);
-  bool hit_right = node->right->hit(node->right, ray, new_interval, rec);
+  bool hit_right = hittable_hit(node->right, ray, new_interval, rec);
   return hit_left | hit_right;
 }
 
+bool bvhnode_occluded(Hittable *self, Ray ray, Interval t_bounds) {
+  assert(self != NULL);
+
+  STATS_INC(bvh_nodes_visited);
+  if (!aabb_hit(&self->bbox, ray, &t_bounds)) {
+    STATS_INC(bvh_nodes_culled);
+    return false;
+  }
+
+  BVHNode *node = self->data;
+#ifdef RT_STATS
+  if (node->left->type != HITTABLE_BVHNODE)
+    STATS_INC(primitive_tests);
+#endif
+  if (hittable_occluded(node->left, ray, t_bounds))
+    return true;
+  if (node->right == node->left)
+    return false;
+#ifdef RT_STATS
+  if (node->right->type != HITTABLE_BVHNODE)
+    STATS_INC(primitive_tests);
+#endif
+  return hittable_occluded(node->right, ray, t_bounds);
+}
+
+static void bvhnode_child_hit_packet(const Hittable *child, RayPacket *packet,
+                                    const uint8_t *mask, HitRecord *recs) {
+  if (child->type == HITTABLE_BVHNODE)
+    bvhnode_hit_packet(child, packet, mask, recs);
+  else if (child->type == HITTABLE_PAGED_MESH)
+    paged_mesh_hit_packet(child, packet, mask, recs);
+  else
+    hittable_hit_lanes(child, packet, mask, recs);
+}
+
+void bvhnode_hit_packet(const Hittable *self, RayPacket *packet,
+                        const uint8_t *mask, HitRecord *recs) {
+  assert(self != NULL);
+  assert(recs != NULL);
+
+  STATS_INC(packet_nodes_visited);
+  if (ray_packet_misses_box(packet, &self->bbox)) {
+    STATS_INC(packet_nodes_culled);
+    return;
+  }
+  uint8_t lanes[PACKET_RAYS];
+  memcpy(lanes, mask, sizeof(lanes));
+  int count = ray_packet_hit_box(packet, &self->bbox, lanes);
+  if (count == 0) {
+    STATS_INC(packet_nodes_culled);
+    return;
+  }
+
+  // Too few rays left to be worth testing the whole packet at every node
+  if (count < BVH_PACKET_MIN_LANES) {
+    for (int k = 0; k < PACKET_RAYS; k++) {
+      if (!lanes[k])
+        continue;
+      STATS_INC(packet_single_rays);
+      if (bvhnode_hit((Hittable *)self, packet->rays[k],
+                      interval_make(packet->t_min, packet->t_max[k]),
+                      &recs[k])) {
+        packet->t_max[k] = recs[k].t;
+        packet->hit[k] = 1;
+      }
+    }
+    return;
+  }
+
+  BVHNode *node = self->data;
+  bvhnode_child_hit_packet(node->left, packet, lanes, recs);
+  if (node->right != node->left)
+    bvhnode_child_hit_packet(node->right, packet, lanes, recs);
+}
+
 static void bvhnode_destroy(void *self) {
   assert(self != NULL);
   Hittable *hittable = (Hittable *)self;
@@ -51,8 +143,8 @@ static void bvhnode_destroy(void *self) {
     node->right->destroy(node->right);
   }
 
-  free(node);
-  free(self);
+  rt_free(node);
+  rt_free(self);
 }
 
 // Fixed comparison functions - need to return int, not bool
@@ -91,10 +183,10 @@ static int box_z_compare(const void *a, const void *b) {
 
 static Hittable *bvhnode_create_helper(DynArray *objects, size_t start,
                                        size_t end) {
-  Hittable *hittable = malloc(sizeof(struct Hittable));
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
   assert(hittable != NULL);
 
-  BVHNode *node = malloc(sizeof(struct BVHNode));
+  BVHNode *node = rt_alloc(sizeof(struct BVHNode));
   assert(node != NULL);
 
   // Calculate bounding box for this node
@@ -144,6 +236,8 @@ static Hittable *bvhnode_create_helper(DynArray *objects, size_t start,
 
   hittable->type = HITTABLE_BVHNODE;
   hittable->hit = (HitFn)bvhnode_hit;
+  hittable->occluded = (OccludedFn)bvhnode_occluded;
+  hittable->finalize = NULL;
   hittable->destroy = (HittableDestroyFn)bvhnode_destroy;
   hittable->mat = NULL;
   hittable->data = node;
@@ -179,4 +273,10 @@ void bvhnode_print(const Hittable *hittable) {
   BVHNode *node = hittable->data;
   printf("BVH Node: { left: %p, right: %p }\n", (void *)node->left,
          (void *)node->right);
-}
\ No newline at end of file
+}
+void bvhnode_child_slots(Hittable *self, Hittable **slots[2]) {
+  assert(self != NULL && self->type == HITTABLE_BVHNODE);
+  BVHNode *node = self->data;
+  slots[0] = &node->left;
+  slots[1] = &node->right;
+}
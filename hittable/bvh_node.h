@@ -1,11 +1,23 @@
 #ifndef BVH_H
 #define BVH_H
 
+#include "core/ray_packet.h"
 #include "hittable/hittable.h"
 
+#define BVH_PACKET_MIN_LANES 4
+
 extern Hittable *bvhnode_create(Hittable *hittable_list);
 extern bool bvhnode_hit(Hittable *self, Ray ray, Interval t_bounds,
                         HitRecord *rec);
+extern bool bvhnode_occluded(Hittable *self, Ray ray, Interval t_bounds);
+// Traces the lanes of `packet` set in `mask` through the tree together (see
+// hittable_hit_packet). A node is skipped for the whole packet when the
+// packet's bounds miss its box; once fewer than BVH_PACKET_MIN_LANES lanes
+// reach a node, its subtree is traced one ray at a time.
+extern void bvhnode_hit_packet(const Hittable *self, RayPacket *packet,
+                               const uint8_t *mask, HitRecord *recs);
 extern void bvhnode_print(const Hittable *hittable);
+// Addresses of the node's left and right child pointers.
+extern void bvhnode_child_slots(Hittable *self, Hittable **slots[2]);
 
 #endif // BVH_H
\ No newline at end of file
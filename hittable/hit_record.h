@@ -8,19 +8,30 @@
 #include "core/vec3.h"
 
 typedef struct Material Material;
+typedef struct Hittable Hittable;
 
+// Traversal only records `t`, the primitive (`obj`, `prim_index`) and its
+// barycentrics in `u`/`v`. The remaining attributes are filled in once for
+// the closest hit by hittable_finalize().
 typedef struct HitRecord {
   Vec3 p;
   Vec3 normal;
   Material *mat;
-  double t;
-  double u;
-  double v;
+  const Hittable *obj;
+  int prim_index;
+  real t;
+  real u;
+  real v;
   bool front_face;
 } HitRecord;
 
 static inline HitRecord hitrecord_zero(void) {
-  return (HitRecord){.p = vec3_zero(), .normal = vec3_zero(), .t = 0.0, .front_face = false};
+  return (HitRecord){.p = vec3_zero(),
+                     .normal = vec3_zero(),
+                     .obj = NULL,
+                     .prim_index = 0,
+                     .t = 0.0,
+                     .front_face = false};
 }
 
 // Sets the hit record normal vector.
@@ -2,12 +2,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "box.h"
 #include "bvh_node.h"
 #include "core/generic_types.h"
+#include "core/ray_packet.h"
+#include "core/stats.h"
 #include "core/vec3.h"
 #include "hit_record.h"
 #include "hittable.h"
+#include "hittable_dispatch.h"
 #include "hittable_list.h"
+#include "lazy_hittable.h"
+#include "paged_mesh.h"
 #include "plane.h"
 #include "quad.h"
 #include "rotate_y.h"
@@ -18,6 +24,42 @@
 
 extern void hittable_destroy(Hittable *self) { self->destroy(self); }
 
+void hittable_hit_packet(const Hittable *self, RayPacket *packet,
+                         const uint8_t *mask, HitRecord *recs) {
+  switch (self->type) {
+  case HITTABLE_BVHNODE:
+    bvhnode_hit_packet(self, packet, mask, recs);
+    break;
+  case HITTABLE_LIST:
+    hittablelist_hit_packet(self, packet, mask, recs);
+    break;
+  case HITTABLE_LAZY:
+    lazy_hittable_hit_packet(self, packet, mask, recs);
+    break;
+  case HITTABLE_PAGED_MESH:
+    paged_mesh_hit_packet(self, packet, mask, recs);
+    break;
+  default:
+    hittable_hit_lanes(self, packet, mask, recs);
+    break;
+  }
+}
+
+void hittable_hit_lanes(const Hittable *self, RayPacket *packet,
+                        const uint8_t *mask, HitRecord *recs) {
+  for (int k = 0; k < PACKET_RAYS; k++) {
+    if (!mask[k])
+      continue;
+    STATS_INC(primitive_tests);
+    if (hittable_hit(self, packet->rays[k],
+                     interval_make(packet->t_min, packet->t_max[k]),
+                     &recs[k])) {
+      packet->t_max[k] = recs[k].t;
+      packet->hit[k] = 1;
+    }
+  }
+}
+
 void hittable_print(const Hittable *self) {
   switch (self->type) {
   case HITTABLE_SPHERE:
@@ -32,6 +74,9 @@ void hittable_print(const Hittable *self) {
   case HITTABLE_QUAD:
     quad_print(self);
     break;
+  case HITTABLE_BOX:
+    box_print(self);
+    break;
   case HITTABLE_LIST:
     hittablelist_print(self);
     break;
@@ -44,8 +89,175 @@ void hittable_print(const Hittable *self) {
   case HITTABLE_ROTATE_Y:
     rotate_y_print(self);
     break;
+  case HITTABLE_LAZY:
+    lazy_hittable_print(self);
+    break;
+  case HITTABLE_PAGED_MESH:
+    paged_mesh_print(self);
+    break;
   default:
     printf("Unknown hittable type: %d\n", self->type);
     break;
   }
 }
+
+bool hittable_apply_transform(Hittable *self, const Transform *xf) {
+  switch (self->type) {
+  case HITTABLE_SPHERE:
+    return sphere_apply_transform(self, xf);
+  case HITTABLE_PLANE:
+    return plane_apply_transform(self, xf);
+  case HITTABLE_TRIANGLE:
+    return triangle_hittable_apply_transform(self, xf);
+  case HITTABLE_QUAD:
+    return quad_apply_transform(self, xf);
+  case HITTABLE_BOX:
+    return box_apply_transform(self, xf);
+  default:
+    return false;
+  }
+}
+
+bool hittable_is_sampleable(const Hittable *self) {
+  switch (self->type) {
+  case HITTABLE_SPHERE:
+  case HITTABLE_QUAD:
+  case HITTABLE_TRIANGLE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+bool hittable_sample_light(const Hittable *self, Vec3 origin, real time,
+                           double u1, double u2, LightSample *ls) {
+  switch (self->type) {
+  case HITTABLE_SPHERE:
+    return sphere_sample_light(self, origin, time, u1, u2, ls);
+  case HITTABLE_QUAD:
+    return quad_sample_light(self, origin, u1, u2, ls);
+  case HITTABLE_TRIANGLE:
+    return triangle_sample_light(self, origin, u1, u2, ls);
+  default:
+    return false;
+  }
+}
+
+real hittable_light_pdf(const Hittable *self, Ray r, const HitRecord *rec) {
+  switch (self->type) {
+  case HITTABLE_SPHERE:
+    return sphere_light_pdf(self, r, rec);
+  case HITTABLE_QUAD:
+    return quad_light_pdf(self, r, rec);
+  case HITTABLE_TRIANGLE:
+    return triangle_light_pdf(self, r, rec);
+  default:
+    return 0.0;
+  }
+}
+
+bool hittable_light_shape(const Hittable *self, real *area, Vec3 *normal) {
+  switch (self->type) {
+  case HITTABLE_SPHERE:
+    return sphere_light_shape(self, area, normal);
+  case HITTABLE_QUAD:
+    return quad_light_shape(self, area, normal);
+  case HITTABLE_TRIANGLE:
+    return triangle_light_shape(self, area, normal);
+  default:
+    *area = 0.0;
+    *normal = vec3_zero();
+    return false;
+  }
+}
+
+int hittable_child_slots(Hittable *self, Hittable **slots[2]) {
+  switch (self->type) {
+  case HITTABLE_BVHNODE:
+    bvhnode_child_slots(self, slots);
+    return 2;
+  case HITTABLE_TRANSLATE:
+    slots[0] = translate_object_slot(self);
+    return 1;
+  case HITTABLE_ROTATE_Y:
+    slots[0] = rotate_y_object_slot(self);
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+// Returns the object wrapped by a transform node, or NULL if `self` is not one.
+static Hittable *hittable_unwrap(const Hittable *self, Transform *xf) {
+  switch (self->type) {
+  case HITTABLE_TRANSLATE:
+    return translate_inner(self, xf);
+  case HITTABLE_ROTATE_Y:
+    return rotate_y_inner(self, xf);
+  default:
+    return NULL;
+  }
+}
+
+// Frees the wrapper nodes from `node` down to `prim`, except `keep`.
+static void hittable_release_chain(Hittable *node, const Hittable *prim,
+                                   const Hittable *keep) {
+  Transform local;
+  while (node != prim) {
+    Hittable *next = hittable_unwrap(node, &local);
+    if (node != keep) {
+      if (node->type == HITTABLE_TRANSLATE)
+        translate_release(node);
+      else
+        rotate_y_release(node);
+    }
+    node = next;
+  }
+}
+
+Hittable *hittable_bake_transforms(Hittable *self, int *removed) {
+  assert(self != NULL);
+
+  // Compose the chain from the outermost wrapper inwards
+  Transform xf = transform_identity();
+  Transform local;
+  Hittable *prim = self;
+  Hittable *rotation = NULL;
+  Hittable *inner;
+  int depth = 0;
+  while ((inner = hittable_unwrap(prim, &local)) != NULL) {
+    xf = transform_compose(&xf, &local);
+    if (prim->type == HITTABLE_ROTATE_Y)
+      rotation = prim;
+    prim = inner;
+    depth++;
+  }
+
+  if (depth == 0)
+    return self;
+
+  if (hittable_apply_transform(prim, &xf)) {
+    hittable_release_chain(self, prim, NULL);
+    *removed += depth;
+    return prim;
+  }
+
+  // The primitive cannot take the rotation, like a box turned by other than a
+  // quarter turn. The chain is still one y rotation R and an offset o, and
+  // R p + o = R (p + R^T o), so the offset goes into the primitive and a
+  // single rotate_y node is kept for R.
+  if (rotation == NULL || depth == 1)
+    return self;
+  Vec3 o = xf.offset;
+  Transform shift = transform_translation(
+      (Vec3){xf.m[0][0] * o.x + xf.m[1][0] * o.y + xf.m[2][0] * o.z,
+             xf.m[0][1] * o.x + xf.m[1][1] * o.y + xf.m[2][1] * o.z,
+             xf.m[0][2] * o.x + xf.m[1][2] * o.y + xf.m[2][2] * o.z});
+  if (!hittable_apply_transform(prim, &shift))
+    return self;
+
+  hittable_release_chain(self, prim, rotation);
+  rotate_y_rewrap(rotation, prim, &xf);
+  *removed += depth - 1;
+  return rotation;
+}
@@ -6,6 +6,8 @@
 #include "core/aabb.h"
 #include "core/interval.h"
 #include "core/ray.h"
+#include "core/ray_packet.h"
+#include "core/transform.h"
 #include "core/vec3.h"
 #include "hit_record.h"
 #include "material/material.h"
@@ -14,6 +16,12 @@ typedef struct Hittable Hittable;
 typedef bool (*HitFn)(const Hittable *self, Ray r, Interval t_bounds,
                       HitRecord *rec);
 
+typedef void (*HitFinalizeFn)(const Hittable *self, Ray r, HitRecord *rec);
+
+// Any-hit query: returns true as soon as some intersection within t_bounds is
+// found, without looking for the closest one or computing hit attributes.
+typedef bool (*OccludedFn)(const Hittable *self, Ray r, Interval t_bounds);
+
 typedef void (*HittableDestroyFn)(Hittable *self);
 typedef void (*HittablePrintFn)(Hittable *self);
 
@@ -22,23 +30,95 @@ typedef enum {
   HITTABLE_PLANE,
   HITTABLE_TRIANGLE,
   HITTABLE_QUAD,
+  HITTABLE_BOX,
   HITTABLE_TRANSLATE,
   HITTABLE_ROTATE_Y,
   HITTABLE_LIST,
   HITTABLE_BVHNODE,
   HITTABLE_TRIANGLE_MESH,
+  HITTABLE_LAZY,       // Proxy loaded on first use, see lazy_hittable.h
+  HITTABLE_PAGED_MESH, // Triangles read from disk on use, see paged_mesh.h
 } HittableType;
 
 typedef struct Hittable {
   HittableType type;
   HitFn hit;
+  HitFinalizeFn finalize; // NULL if `hit` already fills the whole record
+  OccludedFn occluded;
   HittableDestroyFn destroy;
   Material *mat;
   AABB bbox;
   void *data;
 } Hittable;
 
+// A point sampled on an emitter, as seen from the shading point `origin`
+// passed to hittable_sample_light.
+typedef struct LightSample {
+  Vec3 p;    // Point on the emitter
+  Vec3 wi;   // Unit direction from origin to p
+  real dist; // Distance from origin to p
+  real pdf;  // Solid-angle density of wi
+} LightSample;
+
+// Computes position, normal, UV and material for the closest hit recorded
+// by a `hit` query on ray `r`.
+static inline void hittable_finalize(HitRecord *rec, Ray r) {
+  if (rec->obj->finalize) {
+    rec->obj->finalize(rec->obj, r, rec);
+  }
+}
+
+// Closest hit of every lane of `packet` set in `mask`. A lane that hits
+// gets its record in recs[k], its t_max lowered to the hit and hit[k] set;
+// other lanes are left as they were. BVH nodes, lists, lazy proxies and
+// paged meshes trace the lanes together, anything else one lane at a time.
+extern void hittable_hit_packet(const Hittable *self, RayPacket *packet,
+                                const uint8_t *mask, HitRecord *recs);
+
+// hittable_hit_packet for a single primitive or wrapper: intersects `self`
+// with each lane in `mask` separately.
+extern void hittable_hit_lanes(const Hittable *self, RayPacket *packet,
+                               const uint8_t *mask, HitRecord *recs);
+
 extern void hittable_destroy(Hittable *self);
 extern void hittable_print(const Hittable *self);
 
+// Applies `xf` directly to the primitive's geometry. Returns false if the
+// primitive cannot represent the transformed shape.
+extern bool hittable_apply_transform(Hittable *self, const Transform *xf);
+
+// Bakes a chain of translate/rotate_y wrappers into the primitive they wrap.
+// Returns the primitive with the wrapper nodes freed and adds their count to
+// `removed`. A primitive that cannot be rotated takes the translations and
+// is returned under one rotate_y node; `self` is returned unchanged if the
+// primitive cannot be moved at all.
+extern Hittable *hittable_bake_transforms(Hittable *self, int *removed);
+
+// Stores the addresses of the pointers through which `self` refers to other
+// hittables (BVH children, the object inside a transform wrapper) in
+// `slots` and returns how many there are. Lists keep their children in a
+// DynArray instead and report none.
+extern int hittable_child_slots(Hittable *self, Hittable **slots[2]);
+
+// Returns true if `self` can be sampled directly as a light source (spheres,
+// quads and triangles).
+extern bool hittable_is_sampleable(const Hittable *self);
+
+// Samples a direction from `origin` toward the surface of `self` using the
+// uniform variates u1, u2 in [0,1). Returns false if the sample carries no
+// density (degenerate shape or grazing angle).
+extern bool hittable_sample_light(const Hittable *self, Vec3 origin,
+                                  real time, double u1, double u2,
+                                  LightSample *ls);
+
+// Density with which hittable_sample_light from `r.origin` would have picked
+// the direction of `r`, given the hit `rec` of that ray on `self`.
+extern real hittable_light_pdf(const Hittable *self, Ray r,
+                               const HitRecord *rec);
+
+// Surface area of a sampleable light and, for flat ones, its unit normal.
+// Returns false for curved shapes, which emit toward every direction.
+extern bool hittable_light_shape(const Hittable *self, real *area,
+                                 Vec3 *normal);
+
 #endif // HITTABLE_H
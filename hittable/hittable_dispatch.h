@@ -0,0 +1,53 @@
+#ifndef HITTABLE_DISPATCH_H
+#define HITTABLE_DISPATCH_H
+
+#include "box.h"
+#include "hittable.h"
+#include "plane.h"
+#include "quad.h"
+#include "sphere.h"
+#include "triangle_raw.h"
+
+// Intersects `self`, calling the built-in primitives directly by type instead
+// of through `self->hit`, so the compiler is free to inline them into BVH and
+// list traversal. BVH nodes, wrappers, lists and any other type still go
+// through the function pointer.
+static inline bool hittable_hit(const Hittable *self, Ray ray,
+                                Interval t_bounds, HitRecord *rec) {
+  switch (self->type) {
+  case HITTABLE_SPHERE:
+    return sphere_hit(self, ray, t_bounds, rec);
+  case HITTABLE_QUAD:
+    return quad_hit(self, ray, t_bounds, rec);
+  case HITTABLE_TRIANGLE:
+    return triangle_hit((Hittable *)self, ray, t_bounds, rec);
+  case HITTABLE_BOX:
+    return box_hit(self, ray, t_bounds, rec);
+  case HITTABLE_PLANE:
+    return plane_hit(self, ray, t_bounds, rec);
+  default:
+    return self->hit(self, ray, t_bounds, rec);
+  }
+}
+
+// Any-hit counterpart of hittable_hit, with the same direct dispatch. This
+// is the entry point for shadow and other visibility rays.
+static inline bool hittable_occluded(const Hittable *self, Ray ray,
+                                     Interval t_bounds) {
+  switch (self->type) {
+  case HITTABLE_SPHERE:
+    return sphere_occluded(self, ray, t_bounds);
+  case HITTABLE_QUAD:
+    return quad_occluded(self, ray, t_bounds);
+  case HITTABLE_TRIANGLE:
+    return triangle_occluded(self, ray, t_bounds);
+  case HITTABLE_BOX:
+    return box_occluded(self, ray, t_bounds);
+  case HITTABLE_PLANE:
+    return plane_occluded(self, ray, t_bounds);
+  default:
+    return self->occluded(self, ray, t_bounds);
+  }
+}
+
+#endif // HITTABLE_DISPATCH_H
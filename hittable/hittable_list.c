@@ -1,36 +1,62 @@
+#include "core/arena.h"
 #include "core/dyn_array.h"
 #include "core/generic_types.h"
 #include "core/interval.h"
 #include "core/ray.h"
+#include "core/ray_packet.h"
+#include "core/stats.h"
 #include "hit_record.h"
 #include "hittable.h"
+#include "hittable_dispatch.h"
 
+// Children only write to `rec` when they find a hit closer than the current
+// bound, so no temporary record is needed.
 bool hittablelist_hit(Hittable *self, Ray ray, Interval t_bounds,
                       HitRecord *rec) {
-  HitRecord temp_rec;
   bool hit_anything = false;
-  double closest_so_far = t_bounds.max;
+  real closest_so_far = t_bounds.max;
 
   DynArray *hittables = self->data;
   for (int i = 0; i < dynarray_size(hittables); i++) {
     Hittable *h = (Hittable *)dynarray_get(hittables, i);
-    if (h->hit(h, ray, interval_make(t_bounds.min, closest_so_far),
-               &temp_rec)) {
+    if (h->type != HITTABLE_BVHNODE)
+      STATS_INC(primitive_tests);
+    if (hittable_hit(h, ray, interval_make(t_bounds.min, closest_so_far),
+                     rec)) {
       hit_anything = true;
-      closest_so_far = temp_rec.t;
-      *rec = temp_rec;
+      closest_so_far = rec->t;
     }
   }
 
   return hit_anything;
 }
 
+bool hittablelist_occluded(Hittable *self, Ray ray, Interval t_bounds) {
+  DynArray *hittables = self->data;
+  for (int i = 0; i < dynarray_size(hittables); i++) {
+    Hittable *h = (Hittable *)dynarray_get(hittables, i);
+    if (h->type != HITTABLE_BVHNODE)
+      STATS_INC(primitive_tests);
+    if (hittable_occluded(h, ray, t_bounds))
+      return true;
+  }
+  return false;
+}
+
+void hittablelist_hit_packet(const Hittable *self, RayPacket *packet,
+                             const uint8_t *mask, HitRecord *recs) {
+  DynArray *hittables = self->data;
+  for (int i = 0; i < dynarray_size(hittables); i++)
+    hittable_hit_packet(dynarray_get(hittables, i), packet, mask, recs);
+}
+
 void hittablelist_destroy(Hittable *self) {
   assert(self);
   assert(self->data);
 
-  free(self->data);
-  free(self);
+  // Lists do not own their elements
+  dynarray_release(self->data);
+  rt_free(self);
 }
 
 void hittablelist_add(Hittable *self, Hittable *new_hittable) {
@@ -40,11 +66,13 @@ void hittablelist_add(Hittable *self, Hittable *new_hittable) {
 }
 
 Hittable *hittablelist_empty(void) {
-  Hittable *hittable = malloc(sizeof(struct Hittable));
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
   assert(hittable != NULL);
 
   hittable->type = HITTABLE_LIST;
   hittable->hit = (HitFn)hittablelist_hit;
+  hittable->occluded = (OccludedFn)hittablelist_occluded;
+  hittable->finalize = NULL;
   hittable->destroy = (HittableDestroyFn)hittablelist_destroy;
   hittable->mat = NULL;
   hittable->bbox = aabb_empty();
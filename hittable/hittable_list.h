@@ -9,6 +9,10 @@
 
 extern Hittable *hittablelist_empty(void);
 extern void hittablelist_add(Hittable *self, Hittable *new_hittable);
+// Packet counterpart of the list's hit: runs the packet past each element in
+// turn, so later elements only see the rays' remaining intervals.
+extern void hittablelist_hit_packet(const Hittable *self, RayPacket *packet,
+                                    const uint8_t *mask, HitRecord *recs);
 extern void hittablelist_print(const Hittable *hittable);
 
 #endif
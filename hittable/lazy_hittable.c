@@ -0,0 +1,120 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lazy_hittable.h"
+#include "core/arena.h"
+#include "core/interval.h"
+#include "core/ray.h"
+#include "core/ray_packet.h"
+#include "hittable.h"
+#include "hittable_dispatch.h"
+
+typedef struct LazyHittable {
+  LazyLoadFn load;
+  void *ctx;
+  atomic_bool ready; // Set once `inner` is final
+  Hittable *inner;   // NULL until ready, or if the load produced nothing
+} LazyHittable;
+
+// Loads are serialized on one lock rather than one per proxy: the arena
+// copes with concurrent loads, but two render threads reaching different
+// unloaded models would only compete for the same disk.
+static pthread_mutex_t load_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_int created_count = 0;
+static atomic_int loaded_count = 0;
+
+static Hittable *lazy_inner(const Hittable *self) {
+  LazyHittable *lazy = self->data;
+  if (atomic_load_explicit(&lazy->ready, memory_order_acquire))
+    return lazy->inner;
+
+  pthread_mutex_lock(&load_lock);
+  if (!atomic_load_explicit(&lazy->ready, memory_order_relaxed)) {
+    lazy->inner = lazy->load(lazy->ctx);
+    atomic_fetch_add(&loaded_count, 1);
+    atomic_store_explicit(&lazy->ready, true, memory_order_release);
+  }
+  pthread_mutex_unlock(&load_lock);
+  return lazy->inner;
+}
+
+static bool lazy_hit(const Hittable *self, Ray ray, Interval t_bounds,
+                     HitRecord *rec) {
+  Interval box_t = t_bounds;
+  if (!aabb_hit((AABB *)&self->bbox, ray, &box_t))
+    return false;
+  const Hittable *inner = lazy_inner(self);
+  return inner && hittable_hit(inner, ray, t_bounds, rec);
+}
+
+static bool lazy_occluded(const Hittable *self, Ray ray, Interval t_bounds) {
+  Interval box_t = t_bounds;
+  if (!aabb_hit((AABB *)&self->bbox, ray, &box_t))
+    return false;
+  const Hittable *inner = lazy_inner(self);
+  return inner && hittable_occluded(inner, ray, t_bounds);
+}
+
+static void lazy_destroy(Hittable *self) {
+  LazyHittable *lazy = self->data;
+  if (lazy->inner)
+    hittable_destroy(lazy->inner);
+  rt_free(lazy);
+  rt_free(self);
+}
+
+void lazy_hittable_hit_packet(const Hittable *self, RayPacket *packet,
+                              const uint8_t *mask, HitRecord *recs) {
+  assert(self != NULL && self->type == HITTABLE_LAZY);
+  uint8_t lanes[PACKET_RAYS];
+  memcpy(lanes, mask, sizeof(lanes));
+  if (ray_packet_hit_box(packet, &self->bbox, lanes) == 0)
+    return;
+  const Hittable *inner = lazy_inner(self);
+  if (inner)
+    hittable_hit_packet(inner, packet, lanes, recs);
+}
+
+Hittable *lazy_hittable_create(AABB bbox, LazyLoadFn load, void *ctx) {
+  assert(load != NULL);
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
+  assert(hittable != NULL);
+  LazyHittable *lazy = rt_alloc(sizeof(struct LazyHittable));
+  assert(lazy != NULL);
+
+  lazy->load = load;
+  lazy->ctx = ctx;
+  atomic_init(&lazy->ready, false);
+  lazy->inner = NULL;
+  atomic_fetch_add(&created_count, 1);
+
+  hittable->type = HITTABLE_LAZY;
+  hittable->hit = lazy_hit;
+  hittable->finalize = NULL; // Records name the primitive that was hit
+  hittable->occluded = lazy_occluded;
+  hittable->destroy = lazy_destroy;
+  hittable->mat = NULL;
+  hittable->bbox = bbox;
+  hittable->data = lazy;
+  return hittable;
+}
+
+Hittable *lazy_hittable_resolve(Hittable *self) {
+  assert(self != NULL && self->type == HITTABLE_LAZY);
+  return lazy_inner(self);
+}
+
+void lazy_hittable_print(const Hittable *self) {
+  const LazyHittable *lazy = self->data;
+  printf("Lazy(%s)",
+         atomic_load(&lazy->ready) ? (lazy->inner ? "loaded" : "empty")
+                                   : "pending");
+}
+
+int lazy_hittable_created_count(void) { return atomic_load(&created_count); }
+
+int lazy_hittable_loaded_count(void) { return atomic_load(&loaded_count); }
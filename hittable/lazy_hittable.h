@@ -0,0 +1,30 @@
+#ifndef LAZY_HITTABLE_H
+#define LAZY_HITTABLE_H
+
+#include "core/aabb.h"
+#include "hittable.h"
+
+// Builds the geometry behind a lazy proxy. Returns NULL if there is none
+// (the source failed to load or had no primitives).
+typedef Hittable *(*LazyLoadFn)(void *ctx);
+
+// Proxy for geometry that is only loaded once a ray enters `bbox`, which
+// must enclose everything `load` will produce. Until then the proxy costs a
+// box test; the first hit or occlusion query that gets through the box calls
+// `load(ctx)` and every later query goes to its result. Loads are safe from
+// several threads at once: one caller loads and the others wait for it.
+// `ctx` is owned by the caller and must outlive the proxy.
+extern Hittable *lazy_hittable_create(AABB bbox, LazyLoadFn load, void *ctx);
+
+// Loads the proxied geometry now if no ray has yet, and returns it.
+extern Hittable *lazy_hittable_resolve(Hittable *self);
+
+extern void lazy_hittable_hit_packet(const Hittable *self, RayPacket *packet,
+                                     const uint8_t *mask, HitRecord *recs);
+extern void lazy_hittable_print(const Hittable *self);
+
+// Number of proxies created and of those loaded so far, for the render log.
+extern int lazy_hittable_created_count(void);
+extern int lazy_hittable_loaded_count(void);
+
+#endif // LAZY_HITTABLE_H
@@ -0,0 +1,658 @@
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "paged_mesh.h"
+#include "core/aabb.h"
+#include "core/arena.h"
+#include "core/interval.h"
+#include "core/page_cache.h"
+#include "core/ray.h"
+#include "core/ray_packet.h"
+#include "hit_record.h"
+#include "hittable.h"
+#include "triangle_raw.h"
+
+// Triangles per leaf of a page's BVH, and the deepest either BVH may get
+#define PAGED_LEAF_TRIANGLES 2
+#define PAGED_STACK_DEPTH 64
+// Pages a packet can have queued at once; lanes reaching further pages are
+// traced as soon as they are found
+#define PAGED_PACKET_MAX_PAGES 256
+
+_Static_assert(PACKET_RAYS <= 64, "lane masks are 64-bit");
+
+// Padding of triangle bounds, as in triangle_hittable.c
+#define PAGED_TRIANGLE_PADDING 0.001
+
+// ===== FILE FORMAT =====
+
+// Data is in the writing machine's byte order, like the mesh cache. Pages
+// are written in the order of the top BVH, so rays through neighbouring
+// parts of the mesh read neighbouring parts of the file.
+typedef struct PagedMeshHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t page_count;
+  uint32_t top_node_count;
+  uint32_t triangle_count;
+  PagedMeshKey key;
+  AABB bounds;
+  uint64_t top_offset;        // top_node_count PagedTopNodes
+  uint64_t page_table_offset; // page_count PagedPageEntries
+} PagedMeshHeader;
+
+// Node of the top BVH, in depth-first order: an inner node's left child
+// follows it and `right` indexes the other one. Leaves have page >= 0.
+typedef struct PagedTopNode {
+  AABB bbox;
+  int32_t right;
+  int32_t page;
+} PagedTopNode;
+
+typedef struct PagedPageEntry {
+  uint64_t offset;
+  uint32_t node_count;
+  uint32_t triangle_count;
+  uint32_t first_triangle; // Index of the page's first triangle in the mesh
+  uint32_t reserved;
+} PagedPageEntry;
+
+// Node of a page's BVH, laid out like the top BVH. Leaves (count > 0) hold
+// triangles offset .. offset + count - 1 of the page; inner nodes keep
+// their right child in `offset`. A page is its nodes followed by its
+// triangles.
+typedef struct PagedNode {
+  AABB bbox;
+  int32_t offset;
+  int32_t count;
+} PagedNode;
+
+typedef struct PagedMesh {
+  int fd;
+  int page_count;
+  int top_node_count;
+  int triangle_count;
+  PagedTopNode *top;
+  PagedPageEntry *pages;
+  CachedPage *slots; // One per page
+} PagedMesh;
+
+static size_t page_bytes(const PagedPageEntry *entry) {
+  return entry->node_count * sizeof(PagedNode) +
+         entry->triangle_count * sizeof(TriangleRaw);
+}
+
+// ===== BUILDING =====
+
+typedef struct PagedRef {
+  AABB bbox;
+  int index; // Into the builder's triangles
+} PagedRef;
+
+static int ref_x_compare(const void *a, const void *b) {
+  real x = ((const PagedRef *)a)->bbox.x.min;
+  real y = ((const PagedRef *)b)->bbox.x.min;
+  return (x > y) - (x < y);
+}
+
+static int ref_y_compare(const void *a, const void *b) {
+  real x = ((const PagedRef *)a)->bbox.y.min;
+  real y = ((const PagedRef *)b)->bbox.y.min;
+  return (x > y) - (x < y);
+}
+
+static int ref_z_compare(const void *a, const void *b) {
+  real x = ((const PagedRef *)a)->bbox.z.min;
+  real y = ((const PagedRef *)b)->bbox.z.min;
+  return (x > y) - (x < y);
+}
+
+// Bounds of `refs`, which are then sorted along its longest axis, the split
+// bvh_node.c makes.
+static AABB refs_sort(PagedRef *refs, int count) {
+  AABB bbox = aabb_empty();
+  for (int k = 0; k < count; k++)
+    bbox = aabb_surrounding_box(&bbox, &refs[k].bbox);
+  int axis = aabb_longest_axis(&bbox);
+  qsort(refs, (size_t)count, sizeof(PagedRef),
+        axis == 0 ? ref_x_compare
+                  : (axis == 1 ? ref_y_compare : ref_z_compare));
+  return bbox;
+}
+
+typedef struct PagedBuilder {
+  FILE *file;
+  uint64_t offset; // Where the next page goes
+  const TriangleRaw *triangles;
+  int triangles_written;
+  bool ok;
+
+  PagedTopNode *top;
+  int top_count, top_capacity;
+  PagedPageEntry *pages;
+  int page_count, page_capacity;
+
+  // The page being built
+  PagedNode *nodes;
+  int node_count, node_capacity;
+  TriangleRaw *page_triangles; // At most PAGED_MESH_PAGE_TRIANGLES
+  int page_triangle_count;
+} PagedBuilder;
+
+#define BUILDER_PUSH(array, count, capacity)                                   \
+  do {                                                                         \
+    if ((count) == (capacity)) {                                               \
+      (capacity) = (capacity) ? (capacity) * 2 : 64;                           \
+      (array) = realloc((array), (size_t)(capacity) * sizeof(*(array)));       \
+      assert((array) != NULL);                                                 \
+    }                                                                          \
+    (count)++;                                                                 \
+  } while (0)
+
+static int build_page_nodes(PagedBuilder *b, PagedRef *refs, int count) {
+  int index = b->node_count;
+  BUILDER_PUSH(b->nodes, b->node_count, b->node_capacity);
+  AABB bbox = refs_sort(refs, count);
+
+  if (count <= PAGED_LEAF_TRIANGLES) {
+    b->nodes[index] = (PagedNode){bbox, b->page_triangle_count, count};
+    for (int k = 0; k < count; k++)
+      b->page_triangles[b->page_triangle_count++] =
+          b->triangles[refs[k].index];
+    return index;
+  }
+  int half = count / 2;
+  build_page_nodes(b, refs, half);
+  int right = build_page_nodes(b, refs + half, count - half);
+  b->nodes[index] = (PagedNode){bbox, right, 0};
+  return index;
+}
+
+static int build_page(PagedBuilder *b, PagedRef *refs, int count) {
+  b->node_count = 0;
+  b->page_triangle_count = 0;
+  build_page_nodes(b, refs, count);
+
+  PagedPageEntry entry = {0};
+  entry.offset = b->offset;
+  entry.node_count = (uint32_t)b->node_count;
+  entry.triangle_count = (uint32_t)count;
+  entry.first_triangle = (uint32_t)b->triangles_written;
+  b->ok = b->ok &&
+          fwrite(b->nodes, sizeof(PagedNode), (size_t)b->node_count,
+                 b->file) == (size_t)b->node_count &&
+          fwrite(b->page_triangles, sizeof(TriangleRaw), (size_t)count,
+                 b->file) == (size_t)count;
+  b->offset += page_bytes(&entry);
+  b->triangles_written += count;
+
+  int page = b->page_count;
+  BUILDER_PUSH(b->pages, b->page_count, b->page_capacity);
+  b->pages[page] = entry;
+  return page;
+}
+
+static int build_top(PagedBuilder *b, PagedRef *refs, int count) {
+  int index = b->top_count;
+  BUILDER_PUSH(b->top, b->top_count, b->top_capacity);
+  AABB bbox = refs_sort(refs, count);
+
+  if (count <= PAGED_MESH_PAGE_TRIANGLES) {
+    int page = build_page(b, refs, count);
+    b->top[index] = (PagedTopNode){bbox, -1, page};
+    return index;
+  }
+  int half = count / 2;
+  build_top(b, refs, half);
+  int right = build_top(b, refs + half, count - half);
+  b->top[index] = (PagedTopNode){bbox, right, -1};
+  return index;
+}
+
+static AABB triangle_bbox(const TriangleRaw *tri) {
+  Vec3 lo = {fmin(fmin(tri->v0.x, tri->v1.x), tri->v2.x),
+             fmin(fmin(tri->v0.y, tri->v1.y), tri->v2.y),
+             fmin(fmin(tri->v0.z, tri->v1.z), tri->v2.z)};
+  Vec3 hi = {fmax(fmax(tri->v0.x, tri->v1.x), tri->v2.x),
+             fmax(fmax(tri->v0.y, tri->v1.y), tri->v2.y),
+             fmax(fmax(tri->v0.z, tri->v1.z), tri->v2.z)};
+  Vec3 padding = {PAGED_TRIANGLE_PADDING, PAGED_TRIANGLE_PADDING,
+                  PAGED_TRIANGLE_PADDING};
+  return aabb_from_points(vec3_sub(lo, padding), vec3_add(hi, padding));
+}
+
+// Numbers the temporary files of this process, one per page file written
+static atomic_uint temp_serial;
+
+// The key is stored and compared field by field: its padding (tail padding
+// in the float build) is neither copied by assignment nor meaningful.
+static void paged_key_store(PagedMeshKey *dst, const PagedMeshKey *key) {
+  dst->source_size = key->source_size;
+  dst->source_mtime_sec = key->source_mtime_sec;
+  dst->source_mtime_nsec = key->source_mtime_nsec;
+  dst->scale = key->scale;
+  dst->position = key->position;
+  dst->rotation = key->rotation;
+}
+
+static bool paged_vec3_same(Vec3 a, Vec3 b) {
+  return a.x == b.x && a.y == b.y && a.z == b.z;
+}
+
+static bool paged_key_equal(const PagedMeshKey *a, const PagedMeshKey *b) {
+  return a->source_size == b->source_size &&
+         a->source_mtime_sec == b->source_mtime_sec &&
+         a->source_mtime_nsec == b->source_mtime_nsec &&
+         paged_vec3_same(a->scale, b->scale) &&
+         paged_vec3_same(a->position, b->position) &&
+         paged_vec3_same(a->rotation, b->rotation);
+}
+
+bool paged_mesh_write(const char *path, const PagedMeshKey *key,
+                      const TriangleRaw *triangles, int count) {
+  assert(path != NULL && key != NULL);
+  if (count <= 0)
+    return false;
+
+  char temp_path[4096];
+  if (snprintf(temp_path, sizeof(temp_path), "%s.tmp.%d.%u", path,
+               (int)getpid(), atomic_fetch_add(&temp_serial, 1)) >=
+      (int)sizeof(temp_path))
+    return false;
+  FILE *file = fopen(temp_path, "wb");
+  if (!file)
+    return false;
+
+  PagedRef *refs = malloc((size_t)count * sizeof(PagedRef));
+  assert(refs != NULL);
+  for (int k = 0; k < count; k++)
+    refs[k] = (PagedRef){triangle_bbox(&triangles[k]), k};
+
+  PagedBuilder b = {0};
+  b.file = file;
+  b.triangles = triangles;
+  b.page_triangles = malloc(PAGED_MESH_PAGE_TRIANGLES * sizeof(TriangleRaw));
+  assert(b.page_triangles != NULL);
+  b.ok = true;
+
+  // The header is written last, once the offsets are known
+  PagedMeshHeader header;
+  memset(&header, 0, sizeof(header));
+  b.ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  b.offset = sizeof(header);
+  build_top(&b, refs, count);
+
+  memcpy(header.magic, PAGED_MESH_MAGIC, sizeof(header.magic));
+  header.version = PAGED_MESH_VERSION;
+  header.page_count = (uint32_t)b.page_count;
+  header.top_node_count = (uint32_t)b.top_count;
+  header.triangle_count = (uint32_t)count;
+  paged_key_store(&header.key, key);
+  header.bounds = b.top[0].bbox;
+  header.top_offset = b.offset;
+  header.page_table_offset =
+      b.offset + (uint64_t)b.top_count * sizeof(PagedTopNode);
+  bool ok = b.ok &&
+            fwrite(b.top, sizeof(PagedTopNode), (size_t)b.top_count, file) ==
+                (size_t)b.top_count &&
+            fwrite(b.pages, sizeof(PagedPageEntry), (size_t)b.page_count,
+                   file) == (size_t)b.page_count &&
+            fseek(file, 0, SEEK_SET) == 0 &&
+            fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = fclose(file) == 0 && ok;
+
+  free(refs);
+  free(b.top);
+  free(b.pages);
+  free(b.nodes);
+  free(b.page_triangles);
+  if (!ok || rename(temp_path, path) != 0) {
+    remove(temp_path);
+    return false;
+  }
+  return true;
+}
+
+// ===== TRAVERSAL =====
+
+// Closest hit of `r` among the triangles of one resident page. Records the
+// triangle's normal and the hit point with the hit, so finalize never needs
+// the page again.
+static bool page_hit(const PagedPageEntry *entry, const void *data, Ray r,
+                     Interval t_bounds, HitRecord *rec) {
+  const PagedNode *nodes = data;
+  const TriangleRaw *triangles =
+      (const TriangleRaw *)(nodes + entry->node_count);
+  int stack[PAGED_STACK_DEPTH];
+  int depth = 0;
+  stack[depth++] = 0;
+  const TriangleRaw *closest = NULL;
+  while (depth > 0) {
+    const PagedNode *node = &nodes[stack[--depth]];
+    Interval box_t = t_bounds;
+    if (!aabb_hit((AABB *)&node->bbox, r, &box_t))
+      continue;
+    if (node->count == 0) {
+      assert(depth + 2 <= PAGED_STACK_DEPTH);
+      stack[depth++] = node->offset;
+      stack[depth++] = (int)(node - nodes) + 1;
+      continue;
+    }
+    for (int k = node->offset; k < node->offset + node->count; k++) {
+      const TriangleRaw *tri = &triangles[k];
+      if (triangle_raw_hit(tri, r, t_bounds, rec)) {
+        t_bounds.max = rec->t;
+        rec->prim_index = (int)entry->first_triangle + k;
+        closest = tri;
+      }
+    }
+  }
+  if (closest == NULL)
+    return false;
+  rec->normal = closest->normal;
+  rec->p = triangle_raw_point(closest, rec->u, rec->v);
+  return true;
+}
+
+static bool page_occluded(const PagedPageEntry *entry, const void *data,
+                          Ray r, Interval t_bounds) {
+  const PagedNode *nodes = data;
+  const TriangleRaw *triangles =
+      (const TriangleRaw *)(nodes + entry->node_count);
+  int stack[PAGED_STACK_DEPTH];
+  int depth = 0;
+  stack[depth++] = 0;
+  while (depth > 0) {
+    const PagedNode *node = &nodes[stack[--depth]];
+    Interval box_t = t_bounds;
+    if (!aabb_hit((AABB *)&node->bbox, r, &box_t))
+      continue;
+    if (node->count == 0) {
+      assert(depth + 2 <= PAGED_STACK_DEPTH);
+      stack[depth++] = node->offset;
+      stack[depth++] = (int)(node - nodes) + 1;
+      continue;
+    }
+    for (int k = node->offset; k < node->offset + node->count; k++) {
+      if (triangle_raw_occluded(&triangles[k], r, t_bounds))
+        return true;
+    }
+  }
+  return false;
+}
+
+static bool paged_mesh_hit(const Hittable *self, Ray r, Interval t_bounds,
+                           HitRecord *rec) {
+  PagedMesh *mesh = self->data;
+  int stack[PAGED_STACK_DEPTH];
+  int depth = 0;
+  stack[depth++] = 0;
+  bool hit = false;
+  while (depth > 0) {
+    int index = stack[--depth];
+    const PagedTopNode *node = &mesh->top[index];
+    Interval box_t = t_bounds;
+    if (!aabb_hit((AABB *)&node->bbox, r, &box_t))
+      continue;
+    if (node->page < 0) {
+      assert(depth + 2 <= PAGED_STACK_DEPTH);
+      stack[depth++] = node->right;
+      stack[depth++] = index + 1;
+      continue;
+    }
+    const void *data = page_cache_acquire(&mesh->slots[node->page]);
+    if (page_hit(&mesh->pages[node->page], data, r, t_bounds, rec)) {
+      t_bounds.max = rec->t;
+      hit = true;
+    }
+  }
+  if (hit)
+    rec->obj = self;
+  return hit;
+}
+
+static bool paged_mesh_occluded(const Hittable *self, Ray r,
+                                Interval t_bounds) {
+  PagedMesh *mesh = self->data;
+  int stack[PAGED_STACK_DEPTH];
+  int depth = 0;
+  stack[depth++] = 0;
+  while (depth > 0) {
+    int index = stack[--depth];
+    const PagedTopNode *node = &mesh->top[index];
+    Interval box_t = t_bounds;
+    if (!aabb_hit((AABB *)&node->bbox, r, &box_t))
+      continue;
+    if (node->page < 0) {
+      assert(depth + 2 <= PAGED_STACK_DEPTH);
+      stack[depth++] = node->right;
+      stack[depth++] = index + 1;
+      continue;
+    }
+    const void *data = page_cache_acquire(&mesh->slots[node->page]);
+    if (page_occluded(&mesh->pages[node->page], data, r, t_bounds))
+      return true;
+  }
+  return false;
+}
+
+// The hit stored the point and the triangle's unit normal
+static void paged_mesh_finalize(const Hittable *self, Ray r, HitRecord *rec) {
+  hitrec_set_face_normal(rec, r, rec->normal);
+  rec->mat = self->mat;
+}
+
+// Lanes of a packet waiting for one page
+typedef struct PagedQueue {
+  int page[PAGED_PACKET_MAX_PAGES];
+  uint64_t lanes[PAGED_PACKET_MAX_PAGES];
+  int count;
+} PagedQueue;
+
+static void page_trace_lanes(const Hittable *self, int page,
+                             RayPacket *packet, uint64_t lanes,
+                             HitRecord *recs) {
+  PagedMesh *mesh = self->data;
+  const PagedPageEntry *entry = &mesh->pages[page];
+  const void *data = page_cache_acquire(&mesh->slots[page]);
+  for (int k = 0; k < PACKET_RAYS; k++) {
+    if (!(lanes >> k & 1))
+      continue;
+    if (page_hit(entry, data, packet->rays[k],
+                 interval_make(packet->t_min, packet->t_max[k]), &recs[k])) {
+      recs[k].obj = self;
+      packet->t_max[k] = recs[k].t;
+      packet->hit[k] = 1;
+    }
+  }
+}
+
+static void paged_queue_lanes(const Hittable *self, int index,
+                              RayPacket *packet, const uint8_t *mask,
+                              PagedQueue *queue, HitRecord *recs) {
+  const PagedMesh *mesh = self->data;
+  const PagedTopNode *node = &mesh->top[index];
+  uint8_t lanes[PACKET_RAYS];
+  memcpy(lanes, mask, sizeof(lanes));
+  if (ray_packet_hit_box(packet, &node->bbox, lanes) == 0)
+    return;
+  if (node->page < 0) {
+    paged_queue_lanes(self, index + 1, packet, lanes, queue, recs);
+    paged_queue_lanes(self, node->right, packet, lanes, queue, recs);
+    return;
+  }
+
+  uint64_t bits = 0;
+  for (int k = 0; k < PACKET_RAYS; k++)
+    bits |= (uint64_t)(lanes[k] != 0) << k;
+  if (queue->count == PAGED_PACKET_MAX_PAGES) {
+    page_trace_lanes(self, node->page, packet, bits, recs);
+    return;
+  }
+  queue->page[queue->count] = node->page;
+  queue->lanes[queue->count] = bits;
+  queue->count++;
+}
+
+void paged_mesh_hit_packet(const Hittable *self, RayPacket *packet,
+                           const uint8_t *mask, HitRecord *recs) {
+  assert(self != NULL && self->type == HITTABLE_PAGED_MESH);
+  const PagedMesh *mesh = self->data;
+  PagedQueue queue;
+  queue.count = 0;
+  paged_queue_lanes(self, 0, packet, mask, &queue, recs);
+
+  for (int q = 0; q < queue.count; q++)
+    page_cache_prefetch(&mesh->slots[queue.page[q]]);
+  // Resident pages first, while the kernel reads the others
+  for (int q = 0; q < queue.count; q++) {
+    if (mesh->slots[queue.page[q]].data) {
+      page_trace_lanes(self, queue.page[q], packet, queue.lanes[q], recs);
+      queue.lanes[q] = 0;
+    }
+  }
+  for (int q = 0; q < queue.count; q++) {
+    if (queue.lanes[q])
+      page_trace_lanes(self, queue.page[q], packet, queue.lanes[q], recs);
+  }
+}
+
+// ===== LIFETIME =====
+
+static bool read_at(int fd, void *buffer, size_t size, uint64_t offset) {
+  size_t done = 0;
+  while (done < size) {
+    ssize_t n = pread(fd, (char *)buffer + done, size - done,
+                      (off_t)(offset + done));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += (size_t)n;
+  }
+  return true;
+}
+
+// Checks the tables read from a file of `file_size` bytes. Page contents
+// are only read on use and are trusted: the key ties the file to its
+// source, and it was written by paged_mesh_write.
+static bool paged_mesh_valid(const PagedMesh *mesh, uint64_t file_size) {
+  uint64_t triangles = 0;
+  for (int k = 0; k < mesh->page_count; k++) {
+    const PagedPageEntry *entry = &mesh->pages[k];
+    if (entry->node_count == 0 || entry->triangle_count == 0 ||
+        entry->first_triangle != triangles || entry->offset > file_size ||
+        page_bytes(entry) > file_size - entry->offset)
+      return false;
+    triangles += entry->triangle_count;
+  }
+  if (triangles != (uint64_t)mesh->triangle_count)
+    return false;
+  for (int k = 0; k < mesh->top_node_count; k++) {
+    const PagedTopNode *node = &mesh->top[k];
+    if (node->page >= mesh->page_count ||
+        (node->page < 0 &&
+         (node->right <= k + 1 || node->right >= mesh->top_node_count)))
+      return false;
+  }
+  return true;
+}
+
+static void paged_mesh_free(PagedMesh *mesh) {
+  for (int k = 0; mesh->slots && k < mesh->page_count; k++)
+    page_cache_drop(&mesh->slots[k]);
+  free(mesh->top);
+  free(mesh->pages);
+  free(mesh->slots);
+  close(mesh->fd);
+  free(mesh);
+}
+
+// Arena cleanup for a paged mesh allocated in a scene arena, unless it was
+// destroyed already
+static void paged_mesh_release(void *ctx) {
+  Hittable *self = ctx;
+  if (self->data)
+    paged_mesh_free(self->data);
+}
+
+static void paged_mesh_destroy(Hittable *self) {
+  paged_mesh_free(self->data);
+  self->data = NULL;
+  rt_free(self);
+}
+
+Hittable *paged_mesh_open(const char *path, const PagedMeshKey *key,
+                          Material *mat) {
+  assert(path != NULL && key != NULL);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return NULL;
+  struct stat st;
+  PagedMeshHeader header;
+  if (fstat(fd, &st) != 0 || !read_at(fd, &header, sizeof(header), 0) ||
+      memcmp(header.magic, PAGED_MESH_MAGIC, sizeof(header.magic)) != 0 ||
+      header.version != PAGED_MESH_VERSION ||
+      !paged_key_equal(&header.key, key) ||
+      header.page_count == 0 || header.top_node_count == 0 ||
+      header.top_node_count > (uint64_t)st.st_size / sizeof(PagedTopNode) ||
+      header.page_count > (uint64_t)st.st_size / sizeof(PagedPageEntry) ||
+      header.triangle_count > INT32_MAX) {
+    close(fd);
+    return NULL;
+  }
+
+  PagedMesh *mesh = calloc(1, sizeof(PagedMesh));
+  assert(mesh != NULL);
+  mesh->fd = fd;
+  mesh->page_count = (int)header.page_count;
+  mesh->top_node_count = (int)header.top_node_count;
+  mesh->triangle_count = (int)header.triangle_count;
+  mesh->top = malloc(mesh->top_node_count * sizeof(PagedTopNode));
+  mesh->pages = malloc(mesh->page_count * sizeof(PagedPageEntry));
+  assert(mesh->top != NULL && mesh->pages != NULL);
+  if (!read_at(fd, mesh->top, mesh->top_node_count * sizeof(PagedTopNode),
+               header.top_offset) ||
+      !read_at(fd, mesh->pages, mesh->page_count * sizeof(PagedPageEntry),
+               header.page_table_offset) ||
+      !paged_mesh_valid(mesh, (uint64_t)st.st_size)) {
+    paged_mesh_free(mesh);
+    return NULL;
+  }
+
+  mesh->slots = calloc((size_t)mesh->page_count, sizeof(CachedPage));
+  assert(mesh->slots != NULL);
+  for (int k = 0; k < mesh->page_count; k++) {
+    mesh->slots[k].fd = fd;
+    mesh->slots[k].offset = mesh->pages[k].offset;
+    mesh->slots[k].size = page_bytes(&mesh->pages[k]);
+  }
+
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
+  assert(hittable != NULL);
+  hittable->type = HITTABLE_PAGED_MESH;
+  hittable->hit = paged_mesh_hit;
+  hittable->finalize = paged_mesh_finalize;
+  hittable->occluded = paged_mesh_occluded;
+  hittable->destroy = paged_mesh_destroy;
+  hittable->mat = mat;
+  hittable->bbox = header.bounds;
+  hittable->data = mesh;
+  // The file and resident pages are not arena memory
+  if (rt_get_arena())
+    arena_add_cleanup(rt_get_arena(), paged_mesh_release, hittable);
+  return hittable;
+}
+
+void paged_mesh_print(const Hittable *self) {
+  const PagedMesh *mesh = self->data;
+  printf("PagedMesh(%d triangles in %d pages)", mesh->triangle_count,
+         mesh->page_count);
+}
@@ -0,0 +1,52 @@
+#ifndef PAGED_MESH_H
+#define PAGED_MESH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "core/ray_packet.h"
+#include "core/vec3.h"
+#include "hittable.h"
+#include "triangle_raw.h"
+
+// Out-of-core triangle mesh. The mesh is stored in a page file: a small top
+// BVH whose leaves are pages, and per page a BVH of its own over a block of
+// at most PAGED_MESH_PAGE_TRIANGLES triangles. Only the top BVH stays in
+// memory. Pages are read through the page cache (core/page_cache.h) when a
+// ray reaches them and are dropped again under its byte budget, so the
+// mesh can hold more triangle data than is resident at any time.
+#define PAGED_MESH_EXTENSION ".rtpages"
+#define PAGED_MESH_MAGIC "RTPAGES\n"
+#define PAGED_MESH_VERSION REAL_FORMAT_VERSION(1)
+#define PAGED_MESH_PAGE_TRIANGLES 1024
+
+// What a page file was built from. A file is only opened while its key
+// matches the caller's, compared field by field.
+typedef struct PagedMeshKey {
+  uint64_t source_size;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+  Vec3 scale, position, rotation; // Transform baked into the triangles
+} PagedMeshKey;
+
+// Builds the page file for `triangles` at `path`, through a temporary file
+// renamed into place. Returns false, leaving no file behind, if it cannot
+// be written.
+extern bool paged_mesh_write(const char *path, const PagedMeshKey *key,
+                             const TriangleRaw *triangles, int count);
+
+// Opens the page file at `path` as a hittable with material `mat`. Returns
+// NULL if there is no such file, it does not match `key` or it is
+// malformed.
+extern Hittable *paged_mesh_open(const char *path, const PagedMeshKey *key,
+                                 Material *mat);
+
+// Packet traversal: every lane is first queued on the pages whose boxes it
+// enters. Reads are started for all missing pages together, the lanes on
+// resident pages are traced while they are under way, and only then does
+// tracing wait for the rest.
+extern void paged_mesh_hit_packet(const Hittable *self, RayPacket *packet,
+                                  const uint8_t *mask, HitRecord *recs);
+extern void paged_mesh_print(const Hittable *self);
+
+#endif // PAGED_MESH_H
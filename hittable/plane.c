@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "core/arena.h"
+#include "core/transform.h"
 #include "hit_record.h"
 #include "hittable.h"
 #include "material/material.h"
@@ -14,46 +16,70 @@ typedef struct Plane {
   Vec3 normal;
 } Plane;
 
-static bool plane_hit(const Hittable *self, Ray ray, Interval t_bounds,
-                      HitRecord *rec) {
-  assert(self != NULL);
-  assert(rec != NULL);
-
-  const Plane *plane = (const Plane *)self->data;
-
-  double denom = vec3_dot(ray.direction, plane->normal);
+static inline bool plane_intersect(const Plane *plane, Ray ray,
+                                   Interval t_bounds, real *t_hit) {
+  real denom = vec3_dot(ray.direction, plane->normal);
   if (fabs(denom) < DBL_EPSILON) {
     return false;
   }
 
   Vec3 point_minus_origin = vec3_sub(plane->point, ray.origin);
-  double t = vec3_dot(point_minus_origin, plane->normal) / denom;
+  real t = vec3_dot(point_minus_origin, plane->normal) / denom;
 
   if (!interval_surrounds(t_bounds, t)) {
     return false;
   }
+  *t_hit = t;
+  return true;
+}
 
-  rec->mat = self->mat;
-  rec->t = t;
-  rec->p = ray_at(ray, rec->t);
-  hitrec_set_face_normal(rec, ray, plane->normal);
+bool plane_hit(const Hittable *self, Ray ray, Interval t_bounds,
+               HitRecord *rec) {
+  assert(self != NULL);
+  assert(rec != NULL);
+
+  real t;
+  if (!plane_intersect((const Plane *)self->data, ray, t_bounds, &t))
+    return false;
 
+  rec->t = t;
+  rec->obj = self;
+  rec->prim_index = 0;
   return true;
 }
 
+bool plane_occluded(const Hittable *self, Ray ray, Interval t_bounds) {
+  real t;
+  return plane_intersect((const Plane *)self->data, ray, t_bounds, &t);
+}
+
+static void plane_finalize(const Hittable *self, Ray ray, HitRecord *rec) {
+  const Plane *plane = (const Plane *)self->data;
+
+  rec->mat = self->mat;
+  // Projected onto the plane, see ray_spawn
+  Vec3 p = ray_at(ray, rec->t);
+  rec->p = vec3_sub(
+      p, vec3_scale(plane->normal,
+                    vec3_dot(plane->normal, vec3_sub(p, plane->point))));
+  rec->u = 0.0;
+  rec->v = 0.0;
+  hitrec_set_face_normal(rec, ray, plane->normal);
+}
+
 static void plane_destroy(void *self) {
   assert(self != NULL);
   Hittable *hittable = (Hittable *)self;
   assert(hittable->data);
-  free(hittable->data);
-  free(self);
+  rt_free(hittable->data);
+  rt_free(self);
 }
 
 Hittable *plane_create(Vec3 point, Vec3 normal, Material *mat) {
-  Hittable *hittable = malloc(sizeof(struct Hittable));
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
   assert(hittable != NULL);
 
-  Plane *plane_data = malloc(sizeof(struct Plane));
+  Plane *plane_data = rt_alloc(sizeof(struct Plane));
   assert(plane_data != NULL);
 
   plane_data->point = point;
@@ -61,44 +87,28 @@ Hittable *plane_create(Vec3 point, Vec3 normal, Material *mat) {
 
   hittable->type = HITTABLE_PLANE;
   hittable->hit = plane_hit;
+  hittable->occluded = plane_occluded;
+  hittable->finalize = plane_finalize;
   hittable->destroy = (HittableDestroyFn)plane_destroy;
   hittable->mat = mat;
   hittable->data = plane_data;
 
-  const double PLANE_EXTENT = 1000.0; // Large but finite extent
-
-  // Determine which axis the plane is most aligned with
-  Vec3 abs_normal = {fabs(normal.x), fabs(normal.y), fabs(normal.z)};
-
-  if (abs_normal.y > abs_normal.x && abs_normal.y > abs_normal.z) {
-    // Horizontal plane (mostly Y-aligned normal)
-    double y = point.y;
-    hittable->bbox =
-        aabb_make(interval_make(-PLANE_EXTENT, PLANE_EXTENT), // x
-                  interval_make(y - 0.001, y + 0.001),        // y (thin slice)
-                  interval_make(-PLANE_EXTENT, PLANE_EXTENT)  // z
-        );
-  } else if (abs_normal.x > abs_normal.z) {
-    // Vertical plane (mostly X-aligned normal)
-    double x = point.x;
-    hittable->bbox =
-        aabb_make(interval_make(x - 0.001, x + 0.001),        // x (thin slice)
-                  interval_make(-PLANE_EXTENT, PLANE_EXTENT), // y
-                  interval_make(-PLANE_EXTENT, PLANE_EXTENT)  // z
-        );
-  } else {
-    // Vertical plane (mostly Z-aligned normal)
-    double z = point.z;
-    hittable->bbox =
-        aabb_make(interval_make(-PLANE_EXTENT, PLANE_EXTENT), // x
-                  interval_make(-PLANE_EXTENT, PLANE_EXTENT), // y
-                  interval_make(z - 0.001, z + 0.001)         // z (thin slice)
-        );
-  }
+  // Planes are infinite: the scene keeps them out of the BVH and tests them
+  // alongside it instead.
+  hittable->bbox = aabb_universe();
 
   return hittable;
 }
 
+bool plane_apply_transform(Hittable *self, const Transform *xf) {
+  assert(self != NULL && self->type == HITTABLE_PLANE);
+  Plane *plane = (Plane *)self->data;
+
+  plane->point = transform_point(xf, plane->point);
+  plane->normal = vec3_normalized(transform_vector(xf, plane->normal));
+  return true;
+}
+
 void plane_print(const Hittable *hittable) {
   if (hittable == NULL || hittable->type != HITTABLE_PLANE) {
     printf("Plane: Invalid or NULL\n");
@@ -1,10 +1,16 @@
 #ifndef PLANE_H
 #define PLANE_H
 
+#include "core/transform.h"
 #include "hittable.h"
 #include "material/material.h"
 
 extern Hittable *plane_create(Vec3 point, Vec3 normal, Material *mat);
+extern bool plane_hit(const Hittable *self, Ray ray, Interval t_bounds,
+                      HitRecord *rec);
+extern bool plane_occluded(const Hittable *self, Ray ray, Interval t_bounds);
 extern void plane_print(const Hittable *hittable);
 
+extern bool plane_apply_transform(Hittable *self, const Transform *xf);
+
 #endif // PLANE_H
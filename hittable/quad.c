@@ -4,8 +4,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "core/arena.h"
 #include "core/dyn_array.h"
 #include "core/interval.h"
+#include "core/transform.h"
 #include "core/vec3.h"
 #include "hit_record.h"
 #include "hittable.h"
@@ -18,22 +20,20 @@ typedef struct Quad {
   Vec3 v;
   Vec3 normal;
   Vec3 w;
-  double D;
+  real D;
 } Quad;
 
-static bool quad_hit(const Hittable *self, Ray ray, Interval t_bounds,
-                     HitRecord *rec) {
-  assert(self != NULL);
-  assert(rec != NULL);
-
-  const Quad *q = (const Quad *)self->data;
-
-  double denom = vec3_dot(q->normal, ray.direction);
+// Plane hit within t_bounds that falls inside the quad, with its planar
+// coordinates alpha, beta along u and v.
+static inline bool quad_intersect(const Quad *q, Ray ray, Interval t_bounds,
+                                  real *t_hit, real *alpha_hit,
+                                  real *beta_hit) {
+  real denom = vec3_dot(q->normal, ray.direction);
   if (fabs(denom) < DBL_EPSILON) {
     return false;
   }
 
-  double t = (q->D - vec3_dot(q->normal, ray.origin)) / denom;
+  real t = (q->D - vec3_dot(q->normal, ray.origin)) / denom;
   if (!interval_surrounds(t_bounds, t)) {
     return false;
   }
@@ -41,17 +41,87 @@ static bool quad_hit(const Hittable *self, Ray ray, Interval t_bounds,
   Vec3 intersection = ray_at(ray, t);
 
   Vec3 p = vec3_sub(intersection, q->Q);
-  double alpha = vec3_dot(q->w, vec3_cross(p, q->v));
-  double beta = vec3_dot(q->w, vec3_cross(q->u, p));
+  real alpha = vec3_dot(q->w, vec3_cross(p, q->v));
+  real beta = vec3_dot(q->w, vec3_cross(q->u, p));
 
-  if (alpha < 0.0 || alpha > 1.0 || beta < 0.0 || beta > 1.0) {
+  if (alpha < 0 || alpha > 1 || beta < 0 || beta > 1) {
     return false;
   }
 
+  *t_hit = t;
+  *alpha_hit = alpha;
+  *beta_hit = beta;
+  return true;
+}
+
+bool quad_hit(const Hittable *self, Ray ray, Interval t_bounds,
+              HitRecord *rec) {
+  assert(self != NULL);
+  assert(rec != NULL);
+
+  real t, alpha, beta;
+  if (!quad_intersect((const Quad *)self->data, ray, t_bounds, &t, &alpha,
+                      &beta))
+    return false;
+
   rec->t = t;
-  rec->p = intersection;
+  rec->obj = self;
+  rec->prim_index = 0;
+  rec->u = alpha;
+  rec->v = beta;
+  return true;
+}
+
+bool quad_occluded(const Hittable *self, Ray ray, Interval t_bounds) {
+  real t, alpha, beta;
+  return quad_intersect((const Quad *)self->data, ray, t_bounds, &t, &alpha,
+                        &beta);
+}
+
+static void quad_finalize(const Hittable *self, Ray ray, HitRecord *rec) {
+  const Quad *q = (const Quad *)self->data;
+
   rec->mat = self->mat;
+  // Projected onto the quad's plane, see ray_spawn
+  Vec3 p = ray_at(ray, rec->t);
+  rec->p = vec3_sub(p, vec3_scale(q->normal, vec3_dot(q->normal, p) - q->D));
   hitrec_set_face_normal(rec, ray, q->normal);
+}
+
+// Uniform point on the quad, converted from area to solid-angle density.
+bool quad_sample_light(const Hittable *self, Vec3 origin, double u1, double u2,
+                       LightSample *ls) {
+  const Quad *q = (const Quad *)self->data;
+
+  ls->p = vec3_add(q->Q, vec3_add(vec3_scale(q->u, u1), vec3_scale(q->v, u2)));
+  Vec3 d = vec3_sub(ls->p, origin);
+  real dist_squared = vec3_length_squared(d);
+  ls->dist = sqrt(dist_squared);
+  ls->wi = vec3_divs(d, ls->dist);
+
+  real area = vec3_length(vec3_cross(q->u, q->v));
+  real cos_light = fabs(vec3_dot(q->normal, ls->wi));
+  if (cos_light < DBL_EPSILON || area <= 0)
+    return false;
+  ls->pdf = dist_squared / (cos_light * area);
+  return true;
+}
+
+real quad_light_pdf(const Hittable *self, Ray r, const HitRecord *rec) {
+  const Quad *q = (const Quad *)self->data;
+  Vec3 d = vec3_sub(rec->p, r.origin);
+  real dist_squared = vec3_length_squared(d);
+  real area = vec3_length(vec3_cross(q->u, q->v));
+  real cos_light = fabs(vec3_dot(q->normal, d)) / sqrt(dist_squared);
+  if (cos_light < DBL_EPSILON || area <= 0)
+    return 0.0;
+  return dist_squared / (cos_light * area);
+}
+
+bool quad_light_shape(const Hittable *self, real *area, Vec3 *normal) {
+  const Quad *q = (const Quad *)self->data;
+  *area = vec3_length(vec3_cross(q->u, q->v));
+  *normal = q->normal;
   return true;
 }
 
@@ -59,33 +129,22 @@ static void quad_destroy(void *self) {
   assert(self != NULL);
   Hittable *hittable = (Hittable *)self;
   assert(hittable->data);
-  free(hittable->data);
-  free(self);
+  rt_free(hittable->data);
+  rt_free(self);
 }
 
-Hittable *quad_create(Vec3 Q, Vec3 u, Vec3 v, Material *mat) {
-
-  Hittable *hittable = malloc(sizeof(struct Hittable));
-  assert(hittable != NULL);
-
-  Quad *quad_data = malloc(sizeof(struct Quad));
-  assert(quad_data != NULL);
-
-  quad_data->Q = Q;
-  quad_data->u = u;
-  quad_data->v = v;
+// Recomputes the plane, barycentric basis and bounds from Q, u and v.
+static void quad_update(Hittable *self) {
+  Quad *quad_data = (Quad *)self->data;
+  Vec3 Q = quad_data->Q;
+  Vec3 u = quad_data->u;
+  Vec3 v = quad_data->v;
 
   Vec3 n = vec3_cross(u, v);
   quad_data->normal = vec3_normalized(n);
   quad_data->D = vec3_dot(quad_data->normal, Q);
   quad_data->w = vec3_divs(n, vec3_dot(n, n));
 
-  hittable->type = HITTABLE_QUAD;
-  hittable->hit = quad_hit;
-  hittable->destroy = (HittableDestroyFn)quad_destroy;
-  hittable->mat = mat;
-  hittable->data = quad_data;
-
   // create AABB for quad:
   // A quad has 4 corners: Q, Q+u, Q+v, Q+u+v
   Vec3 corner1 = Q;                           // Q
@@ -94,25 +153,58 @@ Hittable *quad_create(Vec3 Q, Vec3 u, Vec3 v, Material *mat) {
   Vec3 corner4 = vec3_add(vec3_add(Q, u), v); // Q + u + v
 
   // Find min and max for each axis
-  double min_x = fmin(fmin(corner1.x, corner2.x), fmin(corner3.x, corner4.x));
-  double max_x = fmax(fmax(corner1.x, corner2.x), fmax(corner3.x, corner4.x));
+  real min_x = fmin(fmin(corner1.x, corner2.x), fmin(corner3.x, corner4.x));
+  real max_x = fmax(fmax(corner1.x, corner2.x), fmax(corner3.x, corner4.x));
 
-  double min_y = fmin(fmin(corner1.y, corner2.y), fmin(corner3.y, corner4.y));
-  double max_y = fmax(fmax(corner1.y, corner2.y), fmax(corner3.y, corner4.y));
+  real min_y = fmin(fmin(corner1.y, corner2.y), fmin(corner3.y, corner4.y));
+  real max_y = fmax(fmax(corner1.y, corner2.y), fmax(corner3.y, corner4.y));
 
-  double min_z = fmin(fmin(corner1.z, corner2.z), fmin(corner3.z, corner4.z));
-  double max_z = fmax(fmax(corner1.z, corner2.z), fmax(corner3.z, corner4.z));
+  real min_z = fmin(fmin(corner1.z, corner2.z), fmin(corner3.z, corner4.z));
+  real max_z = fmax(fmax(corner1.z, corner2.z), fmax(corner3.z, corner4.z));
 
   // Add small padding to avoid zero-sized bounding boxes
-  const double padding = 0.0001;
+  const real padding = 0.0001;
   Vec3 min_point = {min_x - padding, min_y - padding, min_z - padding};
   Vec3 max_point = {max_x + padding, max_y + padding, max_z + padding};
 
-  hittable->bbox = aabb_from_points(min_point, max_point);
+  self->bbox = aabb_from_points(min_point, max_point);
+}
+
+Hittable *quad_create(Vec3 Q, Vec3 u, Vec3 v, Material *mat) {
+
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
+  assert(hittable != NULL);
+
+  Quad *quad_data = rt_alloc(sizeof(struct Quad));
+  assert(quad_data != NULL);
+
+  quad_data->Q = Q;
+  quad_data->u = u;
+  quad_data->v = v;
+
+  hittable->type = HITTABLE_QUAD;
+  hittable->hit = quad_hit;
+  hittable->occluded = quad_occluded;
+  hittable->finalize = quad_finalize;
+  hittable->destroy = (HittableDestroyFn)quad_destroy;
+  hittable->mat = mat;
+  hittable->data = quad_data;
+  quad_update(hittable);
 
   return hittable;
 }
 
+bool quad_apply_transform(Hittable *self, const Transform *xf) {
+  assert(self != NULL && self->type == HITTABLE_QUAD);
+  Quad *quad = (Quad *)self->data;
+
+  quad->Q = transform_point(xf, quad->Q);
+  quad->u = transform_vector(xf, quad->u);
+  quad->v = transform_vector(xf, quad->v);
+  quad_update(self);
+  return true;
+}
+
 void quad_print(const Hittable *hittable) {
   if (hittable == NULL || hittable->type != HITTABLE_QUAD) {
     printf("Quad: Invalid or NULL\n");
@@ -124,38 +216,3 @@ void quad_print(const Hittable *hittable) {
          quad->Q.x, quad->Q.y, quad->Q.z, quad->u.x, quad->u.y, quad->u.z,
          quad->v.x, quad->v.y, quad->v.z);
 }
-
-DynArray *box_create(const Vec3 a, const Vec3 b, Material *mat) {
-  DynArray *sides = dynarray_create(6, NULL, (GDestroyFn)hittable_destroy);
-
-  Vec3 min = (Vec3){fmin(a.x, b.x), fmin(a.y, b.y), fmin(a.z, b.z)};
-
-  Vec3 max = (Vec3){fmax(a.x, b.x), fmax(a.y, b.y), fmax(a.z, b.z)};
-
-  Vec3 dx = (Vec3){max.x - min.x, 0, 0};
-  Vec3 dy = (Vec3){0, max.y - min.y, 0};
-  Vec3 dz = (Vec3){0, 0, max.z - min.z};
-
-  Hittable *front = quad_create((Vec3){min.x, min.y, max.z}, dx, dy, mat);
-  dynarray_push(sides, front);
-
-  Hittable *right =
-      quad_create((Vec3){max.x, min.y, max.z}, vec3_negate(dz), dy, mat);
-  dynarray_push(sides, right);
-
-  Hittable *back =
-      quad_create((Vec3){max.x, min.y, min.z}, vec3_negate(dx), dy, mat);
-  dynarray_push(sides, back);
-
-  Hittable *left = quad_create((Vec3){min.x, min.y, min.z}, dz, dy, mat);
-  dynarray_push(sides, left);
-
-  Hittable *top =
-      quad_create((Vec3){min.x, max.y, max.z}, dx, vec3_negate(dz), mat);
-  dynarray_push(sides, top);
-
-  Hittable *bottom = quad_create((Vec3){min.x, min.y, min.z}, dx, dz, mat);
-  dynarray_push(sides, bottom);
-
-  return sides;
-}
@@ -4,9 +4,16 @@
 #include "hittable.h"  
 #include "material/material.h"
 #include "core/dyn_array.h"
+#include "core/transform.h"
 
 Hittable *quad_create(Vec3 Q, Vec3 u, Vec3 v, Material *mat);
+bool quad_hit(const Hittable *self, Ray ray, Interval t_bounds, HitRecord *rec);
+bool quad_occluded(const Hittable *self, Ray ray, Interval t_bounds);
 void quad_print(const Hittable *hittable);
-DynArray *box_create(const Vec3 a, const Vec3 b, Material* mat);
+bool quad_apply_transform(Hittable *self, const Transform *xf);
+bool quad_sample_light(const Hittable *self, Vec3 origin, double u1, double u2,
+                       LightSample *ls);
+real quad_light_pdf(const Hittable *self, Ray r, const HitRecord *rec);
+bool quad_light_shape(const Hittable *self, real *area, Vec3 *normal);
 
 #endif // QUAD_H
\ No newline at end of file
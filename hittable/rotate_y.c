@@ -5,22 +5,19 @@
 #include <math.h>
 
 #include "rotate_y.h"
+#include "core/arena.h"
 #include "core/interval.h"
 #include "hittable.h"
 #include "hit_record.h"
 
 typedef struct RotateY {
     Hittable* object;
-    double sin_theta;
-    double cos_theta;
+    real sin_theta;
+    real cos_theta;
 } RotateY;
 
-static bool rotate_y_hit(const Hittable *self, Ray ray, Interval t_bounds, HitRecord *rec) {
-    assert(self != NULL);
-    assert(rec != NULL);
-
-    const RotateY *r = (const RotateY *)self->data;
-
+// Rotates a world-space ray into the wrapped object's space.
+static Ray rotate_y_to_object(const RotateY *r, Ray ray) {
     Vec3 origin = (Vec3){
         r->cos_theta * ray.origin.x - r->sin_theta * ray.origin.z,
         ray.origin.y,
@@ -37,10 +34,24 @@ static bool rotate_y_hit(const Hittable *self, Ray ray, Interval t_bounds, HitRe
     rotated_ray.origin = origin;
     rotated_ray.direction = direction;
     rotated_ray.time = ray.time;
+    return rotated_ray;
+}
+
+static bool rotate_y_hit(const Hittable *self, Ray ray, Interval t_bounds, HitRecord *rec) {
+    assert(self != NULL);
+    assert(rec != NULL);
+
+    const RotateY *r = (const RotateY *)self->data;
+    Ray rotated_ray = rotate_y_to_object(r, ray);
     
     if (!r->object->hit(r->object, rotated_ray, t_bounds, rec)) {
         return false;
     }
+
+    // Attributes must be computed in object space before rotating them back,
+    // so wrapped hits are finalized eagerly.
+    hittable_finalize(rec, rotated_ray);
+    rec->obj = self;
     
     rec->p = (Vec3){
         r->cos_theta * rec->p.x + r->sin_theta * rec->p.z,
@@ -57,24 +68,84 @@ static bool rotate_y_hit(const Hittable *self, Ray ray, Interval t_bounds, HitRe
     return true;
 }
 
+static bool rotate_y_occluded(const Hittable *self, Ray ray, Interval t_bounds) {
+    const RotateY *r = (const RotateY *)self->data;
+    return r->object->occluded(r->object, rotate_y_to_object(r, ray), t_bounds);
+}
+
+// The wrapper owns the wrapped object.
 static void rotate_y_destroy(void *self) {
     assert(self != NULL);
     Hittable *hittable = (Hittable *)self;
     assert(hittable->data);
-    
-    free(hittable->data);
-    free(self);
+
+    RotateY *r = (RotateY *)hittable->data;
+    if (r->object) {
+        hittable_destroy(r->object);
+    }
+    rt_free(hittable->data);
+    rt_free(self);
+}
+
+void rotate_y_release(Hittable *self) {
+    assert(self != NULL && self->type == HITTABLE_ROTATE_Y);
+    ((RotateY *)self->data)->object = NULL;
+    rotate_y_destroy(self);
+}
+
+Hittable *rotate_y_inner(const Hittable *self, Transform *xf) {
+    assert(self != NULL && self->type == HITTABLE_ROTATE_Y);
+    const RotateY *r = (const RotateY *)self->data;
+    *xf = (Transform){.m = {{r->cos_theta, 0, r->sin_theta},
+                            {0, 1, 0},
+                            {-r->sin_theta, 0, r->cos_theta}},
+                      .offset = {0, 0, 0}};
+    return r->object;
+}
+
+// Bounds the rotated corners of the object's box
+static void rotate_y_update_bbox(Hittable *self) {
+    const RotateY *r = (const RotateY *)self->data;
+    Transform xf;
+    rotate_y_inner(self, &xf);
+    self->bbox = aabb_empty();
+    for (int i = 0; i < 8; i++) {
+        Vec3 corner = {
+            (i & 1) ? r->object->bbox.x.max : r->object->bbox.x.min,
+            (i & 2) ? r->object->bbox.y.max : r->object->bbox.y.min,
+            (i & 4) ? r->object->bbox.z.max : r->object->bbox.z.min
+        };
+        Vec3 p = transform_point(&xf, corner);
+        AABB corner_box = aabb_from_points(p, p);
+        self->bbox = aabb_surrounding_box(&self->bbox, &corner_box);
+    }
+}
+
+void rotate_y_rewrap(Hittable *self, Hittable *object, const Transform *xf) {
+    assert(self != NULL && self->type == HITTABLE_ROTATE_Y);
+    assert(object != NULL);
+    RotateY *r = (RotateY *)self->data;
+    r->object = object;
+    r->cos_theta = xf->m[0][0];
+    r->sin_theta = xf->m[0][2];
+    self->mat = object->mat;
+    rotate_y_update_bbox(self);
+}
+
+Hittable **rotate_y_object_slot(Hittable *self) {
+    assert(self != NULL && self->type == HITTABLE_ROTATE_Y);
+    return &((RotateY *)self->data)->object;
 }
 
-Hittable *rotate_y_create(Hittable* object, double angle_degrees) {
+Hittable *rotate_y_create(Hittable* object, real angle_degrees) {
     assert(object != NULL);
     
-    Hittable *hittable = malloc(sizeof(struct Hittable));
+    Hittable *hittable = rt_alloc(sizeof(struct Hittable));
     assert(hittable != NULL);
-    RotateY *rotate_data = malloc(sizeof(struct RotateY));
+    RotateY *rotate_data = rt_alloc(sizeof(struct RotateY));
     assert(rotate_data != NULL);
     
-    double radians = angle_degrees * M_PI / 180.0;
+    real radians = angle_degrees * M_PI / 180.0;
     
     rotate_data->object = object;
     rotate_data->sin_theta = sin(radians);
@@ -82,9 +153,12 @@ Hittable *rotate_y_create(Hittable* object, double angle_degrees) {
     
     hittable->type = HITTABLE_ROTATE_Y;
     hittable->hit = rotate_y_hit;
+    hittable->occluded = rotate_y_occluded;
+    hittable->finalize = NULL;
     hittable->destroy = (HittableDestroyFn)rotate_y_destroy;
     hittable->mat = object->mat;  
     hittable->data = rotate_data;
+    rotate_y_update_bbox(hittable);
     
     return hittable;
 }
@@ -96,7 +170,7 @@ void rotate_y_print(const Hittable *hittable) {
     }
     const RotateY *rotate = (const RotateY *)hittable->data;
 
-    double angle_radians = atan2(rotate->sin_theta, rotate->cos_theta);
-    double angle_degrees = angle_radians * 180.0 / M_PI;
+    real angle_radians = atan2(rotate->sin_theta, rotate->cos_theta);
+    real angle_degrees = angle_radians * 180.0 / M_PI;
     printf("RotateY { angle: %.1f degrees }\n", angle_degrees);
 }
\ No newline at end of file
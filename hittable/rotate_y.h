@@ -1,10 +1,21 @@
 #ifndef ROTATE_Y_H
 #define ROTATE_Y_H
 
+#include "core/transform.h"
 #include "core/vec3.h"
 #include "hittable.h"
 
-Hittable *rotate_y_create(Hittable* object, double angle_degrees);
+Hittable *rotate_y_create(Hittable* object, real angle_degrees);
 void rotate_y_print(const Hittable *hittable);
 
+// Returns the wrapped object and writes the rotation as a transform to `xf`.
+Hittable *rotate_y_inner(const Hittable *self, Transform *xf);
+// Makes the wrapper rotate `object` by the y rotation in `xf` instead. The
+// offset of `xf` is ignored.
+void rotate_y_rewrap(Hittable *self, Hittable *object, const Transform *xf);
+// Address of the pointer to the wrapped object.
+Hittable **rotate_y_object_slot(Hittable *self);
+// Frees the wrapper without destroying the wrapped object.
+void rotate_y_release(Hittable *self);
+
 #endif // ROTATE_Y_H
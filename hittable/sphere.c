@@ -5,7 +5,12 @@
 #include <stdlib.h>
 
 #include "core/aabb.h"
+#include "core/arena.h"
+#include "core/fast_math.h"
 #include "core/interval.h"
+#include "core/onb.h"
+#include "core/sampling.h"
+#include "core/transform.h"
 #include "hit_record.h"
 #include "hittable.h"
 #include "material/material.h"
@@ -14,19 +19,19 @@
 typedef struct Sphere {
   Vec3 center_start;
   Vec3 center_end;
-  double radius;
+  real radius;
   bool is_moving;
 } Sphere;
 
-static void get_sphere_uv(const Vec3 *p, double *u, double *v) {
-  double theta = acos(-p->y);
-  double phi = atan2(-p->z, p->x) + M_PI;
+static void get_sphere_uv(const Vec3 *p, real *u, real *v) {
+  real theta = fast_acos(-p->y);
+  real phi = fast_atan2(-p->z, p->x) + M_PI;
 
   *u = phi / (2 * M_PI);
   *v = theta / M_PI;
 }
 
-static Vec3 sphere_center_at_time(const Sphere *sphere, double time) {
+static Vec3 sphere_center_at_time(const Sphere *sphere, real time) {
   if (!sphere->is_moving) {
     return sphere->center_start;
   }
@@ -35,60 +40,186 @@ static Vec3 sphere_center_at_time(const Sphere *sphere, double time) {
   return vec3_add(sphere->center_start, vec3_scale(motion, time));
 }
 
-static bool sphere_hit(const Hittable *self, Ray ray, Interval t_bounds,
-                       HitRecord *rec) {
-  assert(self != NULL);
-  assert(rec != NULL);
-
-  const Sphere *sphere = (const Sphere *)self->data;
-
+// Nearest root of the ray-sphere equation within t_bounds. The discriminant
+// comes from the distance between the centre and the ray's line instead of
+// h^2 - a c, and one root from c / q instead of (h - sqrt) / a, which
+// avoids the cancellations that make large or distant spheres lose hits or
+// hit themselves at float precision (Haines et al., "Precision
+// Improvements for Ray/Sphere Intersection", 2019).
+static inline bool sphere_intersect(const Sphere *sphere, Ray ray,
+                                    Interval t_bounds, real *t) {
   Vec3 current_center = sphere_center_at_time(sphere, ray.time);
 
   Vec3 oc = vec3_sub(current_center, ray.origin);
-  double a = vec3_length_squared(ray.direction);
-  double h = vec3_dot(ray.direction, oc);
-  double c = vec3_length_squared(oc) - sphere->radius * sphere->radius;
+  real a = vec3_length_squared(ray.direction);
+  real h = vec3_dot(ray.direction, oc);
+  real r2 = sphere->radius * sphere->radius;
+  real c = vec3_length_squared(oc) - r2;
 
-  double discriminant = h * h - a * c;
+  Vec3 to_line = vec3_sub(oc, vec3_scale(ray.direction, h / a));
+  real discriminant = a * (r2 - vec3_length_squared(to_line));
 
   if (discriminant < 0) {
     return false;
   }
-  double disc_sqrtd = sqrt(discriminant);
+  real q = h + copysign(sqrt(discriminant), h);
+  if (q == 0) {
+    return false; // Grazes the sphere at the origin of the ray
+  }
 
-  // Find the nearest root that lies in the acceptable range
-  double root = (h - disc_sqrtd) / a;
+  // A ray leaving the sphere starts within rounding error of it, so c, and
+  // with it the root c / q, is nothing but that error. That root is the
+  // surface being left, which ray_spawn's offset cannot clear on a large
+  // sphere at float precision; it is moved onto t_bounds.min to be skipped.
+  real c_error = 8 * REAL_EPSILON * (vec3_length_squared(oc) + r2);
+  real near = fabs(c) > c_error ? c / q : t_bounds.min;
+  real far = q / a;
+  if (near > far) {
+    real swap = near;
+    near = far;
+    far = swap;
+  }
+  real root = near;
   if (!interval_surrounds(t_bounds, root)) {
-    root = (h + disc_sqrtd) / a;
+    root = far;
     if (!interval_surrounds(t_bounds, root))
       return false;
   }
+  *t = root;
+  return true;
+}
+
+bool sphere_hit(const Hittable *self, Ray ray, Interval t_bounds,
+                HitRecord *rec) {
+  assert(self != NULL);
+  assert(rec != NULL);
+
+  const Sphere *sphere = (const Sphere *)self->data;
+  real root;
+  if (!sphere_intersect(sphere, ray, t_bounds, &root))
+    return false;
 
-  rec->mat = self->mat;
   rec->t = root;
-  rec->p = ray_at(ray, rec->t);
-  Vec3 outward_normal =
-      vec3_divs(vec3_sub(rec->p, current_center), sphere->radius);
+  rec->obj = self;
+  rec->prim_index = 0;
+  return true;
+}
+
+bool sphere_occluded(const Hittable *self, Ray ray, Interval t_bounds) {
+  real root;
+  return sphere_intersect((const Sphere *)self->data, ray, t_bounds, &root);
+}
+
+static void sphere_finalize(const Hittable *self, Ray ray, HitRecord *rec) {
+  const Sphere *sphere = (const Sphere *)self->data;
+  Vec3 current_center = sphere_center_at_time(sphere, ray.time);
+
+  rec->mat = self->mat;
+  // Reprojected onto the sphere, see ray_spawn
+  Vec3 from_center = vec3_sub(ray_at(ray, rec->t), current_center);
+  Vec3 outward_normal = vec3_normalized(from_center);
+  rec->p = vec3_add(current_center, vec3_scale(outward_normal, sphere->radius));
   hitrec_set_face_normal(rec, ray, outward_normal);
 
   get_sphere_uv(&outward_normal, &rec->u, &rec->v);
+}
+
+// Samples the cone of directions the sphere subtends from `origin`, which
+// wastes no samples on the far side. From inside the sphere every direction
+// sees it, so the surface is sampled uniformly by area instead.
+bool sphere_sample_light(const Hittable *self, Vec3 origin, real time,
+                         double u1, double u2, LightSample *ls) {
+  const Sphere *sphere = (const Sphere *)self->data;
+  Vec3 center = sphere_center_at_time(sphere, time);
+  Vec3 to_center = vec3_sub(center, origin);
+  real dist_squared = vec3_length_squared(to_center);
+  real radius_squared = sphere->radius * sphere->radius;
+
+  if (dist_squared <= radius_squared) {
+    Vec3 normal = sample_uniform_sphere(u1, u2);
+    ls->p = vec3_add(center, vec3_scale(normal, sphere->radius));
+    Vec3 d = vec3_sub(ls->p, origin);
+    ls->dist = vec3_length(d);
+    if (ls->dist < DBL_EPSILON)
+      return false;
+    ls->wi = vec3_divs(d, ls->dist);
+    real cos_light = fabs(vec3_dot(normal, ls->wi));
+    if (cos_light < DBL_EPSILON)
+      return false;
+    ls->pdf = ls->dist * ls->dist / (cos_light * 4 * M_PI * radius_squared);
+    return true;
+  }
 
+  // 1 - cos(theta_max), written to stay accurate for small, distant spheres
+  real sin2_max = radius_squared / dist_squared;
+  real one_minus_cos_max = sin2_max / (1 + sqrt(1 - sin2_max));
+  Onb onb = onb_from_w(vec3_divs(to_center, sqrt(dist_squared)));
+  ls->wi = onb_local(&onb, sample_uniform_cone(u1, u2, one_minus_cos_max));
+
+  // Near intersection along wi, in the stable form of sphere_intersect: a
+  // shadow ray must stop short of the light however close to its silhouette
+  // the sample is. Clamp the discriminant for silhouette samples.
+  real h = vec3_dot(ls->wi, to_center);
+  Vec3 to_line = vec3_sub(to_center, vec3_scale(ls->wi, h));
+  real discriminant = radius_squared - vec3_length_squared(to_line);
+  ls->dist =
+      (dist_squared - radius_squared) / (h + sqrt(fmax(0, discriminant)));
+  ls->p = vec3_add(origin, vec3_scale(ls->wi, ls->dist));
+  ls->pdf = 1.0 / (2 * M_PI * one_minus_cos_max);
   return true;
 }
 
+real sphere_light_pdf(const Hittable *self, Ray r, const HitRecord *rec) {
+  const Sphere *sphere = (const Sphere *)self->data;
+  Vec3 center = sphere_center_at_time(sphere, r.time);
+  real dist_squared = vec3_length_squared(vec3_sub(center, r.origin));
+  real radius_squared = sphere->radius * sphere->radius;
+
+  if (dist_squared <= radius_squared) {
+    Vec3 d = vec3_sub(rec->p, r.origin);
+    real cos_light =
+        fabs(vec3_dot(rec->normal, vec3_normalized(d)));
+    if (cos_light < DBL_EPSILON)
+      return 0.0;
+    return vec3_length_squared(d) /
+           (cos_light * 4 * M_PI * radius_squared);
+  }
+
+  real sin2_max = radius_squared / dist_squared;
+  real one_minus_cos_max = sin2_max / (1 + sqrt(1 - sin2_max));
+  return 1.0 / (2 * M_PI * one_minus_cos_max);
+}
+
+bool sphere_light_shape(const Hittable *self, real *area, Vec3 *normal) {
+  const Sphere *sphere = (const Sphere *)self->data;
+  *area = 4 * M_PI * sphere->radius * sphere->radius;
+  *normal = vec3_zero();
+  return false;
+}
+
+// Bounds of the sphere swept from its start to its end center.
+static AABB sphere_bbox(const Sphere *sphere) {
+  Vec3 rvec = (Vec3){sphere->radius, sphere->radius, sphere->radius};
+  AABB box1 = aabb_from_points(vec3_sub(sphere->center_start, rvec),
+                               vec3_add(sphere->center_start, rvec));
+  AABB box2 = aabb_from_points(vec3_sub(sphere->center_end, rvec),
+                               vec3_add(sphere->center_end, rvec));
+  return aabb_surrounding_box(&box1, &box2);
+}
+
 static void sphere_destroy(void *self) {
   assert(self != NULL);
   Hittable *hittable = (Hittable *)self;
   assert(hittable->data);
-  free(hittable->data);
-  free(self);
+  rt_free(hittable->data);
+  rt_free(self);
 }
 
-Hittable *sphere_create(Vec3 center, double radius, Material *mat) {
+Hittable *sphere_create(Vec3 center, real radius, Material *mat) {
   assert(radius > 0);
-  Hittable *hittable = malloc(sizeof(struct Hittable));
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
   assert(hittable != NULL);
-  Sphere *sphere_data = malloc(sizeof(struct Sphere));
+  Sphere *sphere_data = rt_alloc(sizeof(struct Sphere));
   assert(sphere_data != NULL);
 
   sphere_data->center_start = center;
@@ -96,11 +227,11 @@ Hittable *sphere_create(Vec3 center, double radius, Material *mat) {
   sphere_data->radius = radius;
   sphere_data->is_moving = false;
 
-  Vec3 rvec = (Vec3){radius, radius, radius};
-  hittable->bbox =
-      aabb_from_points(vec3_sub(center, rvec), vec3_add(center, rvec));
+  hittable->bbox = sphere_bbox(sphere_data);
   hittable->type = HITTABLE_SPHERE;
   hittable->hit = sphere_hit;
+  hittable->finalize = sphere_finalize;
+  hittable->occluded = sphere_occluded;
   hittable->destroy = (HittableDestroyFn)sphere_destroy;
   hittable->mat = mat;
   hittable->data = sphere_data;
@@ -108,11 +239,11 @@ Hittable *sphere_create(Vec3 center, double radius, Material *mat) {
 }
 
 Hittable *sphere_create_moving(Vec3 center_start, Vec3 center_end,
-                               double radius, Material *mat) {
+                               real radius, Material *mat) {
   assert(radius > 0);
-  Hittable *hittable = malloc(sizeof(struct Hittable));
+  Hittable *hittable = rt_alloc(sizeof(struct Hittable));
   assert(hittable != NULL);
-  Sphere *sphere_data = malloc(sizeof(struct Sphere));
+  Sphere *sphere_data = rt_alloc(sizeof(struct Sphere));
   assert(sphere_data != NULL);
 
   sphere_data->center_start = center_start;
@@ -121,22 +252,33 @@ Hittable *sphere_create_moving(Vec3 center_start, Vec3 center_end,
   sphere_data->radius = radius;
   sphere_data->is_moving = true;
 
-  Vec3 center2 = vec3_sub(center_end, center_start);
-  Vec3 rvec = (Vec3){radius, radius, radius};
-  AABB box1 = aabb_from_points(vec3_sub(center_start, rvec),
-                               vec3_sub(center_start, rvec));
-  AABB box2 =
-      aabb_from_points(vec3_sub(center2, rvec), vec3_sub(center2, rvec));
-  hittable->bbox = aabb_surrounding_box(&box1, &box2);
+  hittable->bbox = sphere_bbox(sphere_data);
 
   hittable->type = HITTABLE_SPHERE;
   hittable->hit = sphere_hit;
+  hittable->finalize = sphere_finalize;
+  hittable->occluded = sphere_occluded;
   hittable->destroy = (HittableDestroyFn)sphere_destroy;
   hittable->mat = mat;
   hittable->data = sphere_data;
   return hittable;
 }
 
+bool sphere_apply_transform(Hittable *self, const Transform *xf) {
+  assert(self != NULL && self->type == HITTABLE_SPHERE);
+  Sphere *sphere = (Sphere *)self->data;
+
+  // The radius is only preserved by rigid transforms
+  Vec3 x_axis = transform_vector(xf, (Vec3){1, 0, 0});
+  if (fabs(vec3_length(x_axis) - 1.0) > TRANSFORM_EPSILON)
+    return false;
+
+  sphere->center_start = transform_point(xf, sphere->center_start);
+  sphere->center_end = transform_point(xf, sphere->center_end);
+  self->bbox = sphere_bbox(sphere);
+  return true;
+}
+
 void sphere_print(const Hittable *hittable) {
   if (hittable == NULL || hittable->type != HITTABLE_SPHERE) {
     printf("Sphere: Invalid or NULL\n");
@@ -1,11 +1,23 @@
 #ifndef SPHERE_H
 #define SPHERE_H
 
+#include "core/transform.h"
 #include "hittable.h"
 #include "material/material.h"
 
-extern Hittable *sphere_create(Vec3 center, double radius, Material *mat);
+extern Hittable *sphere_create(Vec3 center, real radius, Material *mat);
+extern bool sphere_hit(const Hittable *self, Ray ray, Interval t_bounds,
+                       HitRecord *rec);
+extern bool sphere_occluded(const Hittable *self, Ray ray, Interval t_bounds);
 extern void sphere_print(const Hittable *hittable);
-extern Hittable *sphere_create_moving(Vec3 center_start, Vec3 center_end, double radius, Material *mat);
+extern Hittable *sphere_create_moving(Vec3 center_start, Vec3 center_end, real radius, Material *mat);
+
+extern bool sphere_apply_transform(Hittable *self, const Transform *xf);
+extern bool sphere_sample_light(const Hittable *self, Vec3 origin, real time,
+                                double u1, double u2, LightSample *ls);
+extern real sphere_light_pdf(const Hittable *self, Ray r,
+                             const HitRecord *rec);
+extern bool sphere_light_shape(const Hittable *self, real *area,
+                               Vec3 *normal);
 
 #endif // SPHERE_H
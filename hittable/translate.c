@@ -5,6 +5,7 @@
 #include <math.h>
 
 #include "translate.h"
+#include "core/arena.h"
 #include "core/interval.h"
 #include "hittable.h"
 #include "hit_record.h"
@@ -29,26 +30,61 @@ static bool translate_hit(const Hittable *self, Ray ray, Interval t_bounds, HitR
         return false;
     }
 
+    // Attributes must be computed in object space before moving them back,
+    // so wrapped hits are finalized eagerly.
+    hittable_finalize(rec, offset_ray);
     rec->p = vec3_add(rec->p, t->offset);
+    rec->obj = self;
     
     return true;
 }
 
+static bool translate_occluded(const Hittable *self, Ray ray, Interval t_bounds) {
+    const Translate *t = (const Translate *)self->data;
+
+    Ray offset_ray = ray;
+    offset_ray.origin = vec3_sub(ray.origin, t->offset);
+    return t->object->occluded(t->object, offset_ray, t_bounds);
+}
+
+// The wrapper owns the wrapped object.
 static void translate_destroy(void *self) {
     assert(self != NULL);
     Hittable *hittable = (Hittable *)self;
     assert(hittable->data);
-    
-    free(hittable->data);
-    free(self);
+
+    Translate *t = (Translate *)hittable->data;
+    if (t->object) {
+        hittable_destroy(t->object);
+    }
+    rt_free(hittable->data);
+    rt_free(self);
+}
+
+void translate_release(Hittable *self) {
+    assert(self != NULL && self->type == HITTABLE_TRANSLATE);
+    ((Translate *)self->data)->object = NULL;
+    translate_destroy(self);
+}
+
+Hittable *translate_inner(const Hittable *self, Transform *xf) {
+    assert(self != NULL && self->type == HITTABLE_TRANSLATE);
+    const Translate *t = (const Translate *)self->data;
+    *xf = transform_translation(t->offset);
+    return t->object;
+}
+
+Hittable **translate_object_slot(Hittable *self) {
+    assert(self != NULL && self->type == HITTABLE_TRANSLATE);
+    return &((Translate *)self->data)->object;
 }
 
 Hittable *translate_create(Hittable* object, Vec3 offset) {
     assert(object != NULL);
     
-    Hittable *hittable = malloc(sizeof(struct Hittable));
+    Hittable *hittable = rt_alloc(sizeof(struct Hittable));
     assert(hittable != NULL);
-    Translate *translate_data = malloc(sizeof(struct Translate));
+    Translate *translate_data = rt_alloc(sizeof(struct Translate));
     assert(translate_data != NULL);
     
     translate_data->object = object;
@@ -56,9 +92,15 @@ Hittable *translate_create(Hittable* object, Vec3 offset) {
     
     hittable->type = HITTABLE_TRANSLATE;
     hittable->hit = translate_hit;
+    hittable->occluded = translate_occluded;
+    hittable->finalize = NULL;
     hittable->destroy = (HittableDestroyFn)translate_destroy;
     hittable->mat = object->mat; 
     hittable->data = translate_data;
+    hittable->bbox = aabb_make(
+        interval_make(object->bbox.x.min + offset.x, object->bbox.x.max + offset.x),
+        interval_make(object->bbox.y.min + offset.y, object->bbox.y.max + offset.y),
+        interval_make(object->bbox.z.min + offset.z, object->bbox.z.max + offset.z));
     
     return hittable;
 }
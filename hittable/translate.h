@@ -1,10 +1,18 @@
 #ifndef TRANSLATE_H
 #define TRANSLATE_H
 
+#include "core/transform.h"
 #include "core/vec3.h"
 #include "hittable.h"
 
 Hittable *translate_create(Hittable* object, Vec3 offset);
 void translate_print(const Hittable *hittable);
 
+// Returns the wrapped object and writes the offset as a transform to `xf`.
+Hittable *translate_inner(const Hittable *self, Transform *xf);
+// Address of the pointer to the wrapped object.
+Hittable **translate_object_slot(Hittable *self);
+// Frees the wrapper without destroying the wrapped object.
+void translate_release(Hittable *self);
+
 #endif // TRANSLATE_H
\ No newline at end of file
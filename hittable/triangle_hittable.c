@@ -2,8 +2,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "core/arena.h"
 #include "core/interval.h"
 #include "core/ray.h"
+#include "core/transform.h"
 #include "core/vec3.h"
 #include "hit_record.h"
 #include "hittable.h"
@@ -21,19 +23,55 @@ void triangle_hittable_print(const Hittable *hittable) {
   triangle_raw_print(&tri_hit->triangle);
 }
 
+static AABB triangle_hittable_bbox(const TriangleRaw *tri) {
+  Vec3 v0 = tri->v0;
+  Vec3 v1 = tri->v1;
+  Vec3 v2 = tri->v2;
+
+  // Calculate bounding box with explicit temporary variables
+  // (prevents potential compiler optimization issues)
+  real min_x = fmin(fmin(v0.x, v1.x), v2.x);
+  real min_y = fmin(fmin(v0.y, v1.y), v2.y);
+  real min_z = fmin(fmin(v0.z, v1.z), v2.z);
+
+  real max_x = fmax(fmax(v0.x, v1.x), v2.x);
+  real max_y = fmax(fmax(v0.y, v1.y), v2.y);
+  real max_z = fmax(fmax(v0.z, v1.z), v2.z);
+
+  // Create points with explicit assignment
+  Vec3 min_point;
+  min_point.x = min_x;
+  min_point.y = min_y;
+  min_point.z = min_z;
+
+  Vec3 max_point;
+  max_point.x = max_x;
+  max_point.y = max_y;
+  max_point.z = max_z;
+
+  // Add padding so BVH doesnt break (div by zero)
+  const real padding_amount = 0.001; // 1mm
+  Vec3 padding = {padding_amount, padding_amount, padding_amount};
+
+  min_point = vec3_sub(min_point, padding);
+  max_point = vec3_add(max_point, padding);
+
+  return aabb_from_points(min_point, max_point);
+}
+
 Hittable *triangle_hittable_create(Vec3 v0, Vec3 v1, Vec3 v2, Material *mat) {
   // Validate inputs first
   assert(mat != NULL);
 
   // Create the triangle data
-  TriangleHittable *tri_hit_data = malloc(sizeof(TriangleHittable));
+  TriangleHittable *tri_hit_data = rt_alloc(sizeof(TriangleHittable));
   assert(tri_hit_data != NULL);
 
   // Initialize the triangle data
   tri_hit_data->triangle = triangle_raw_create(v0, v1, v2);
 
   // Create the hittable wrapper
-  Hittable *hittable = malloc(sizeof(Hittable));
+  Hittable *hittable = rt_alloc(sizeof(Hittable));
   assert(hittable != NULL);
 
   // Initialize ALL fields explicitly (this might have been the issue)
@@ -42,40 +80,68 @@ Hittable *triangle_hittable_create(Vec3 v0, Vec3 v1, Vec3 v2, Material *mat) {
   hittable->mat = mat;
   hittable->destroy = (HittableDestroyFn)triangle_destroy;
   hittable->hit = (HitFn)triangle_hit;
+  hittable->finalize = triangle_finalize;
+  hittable->occluded = triangle_occluded;
 
-  // Initialize bbox to empty first (defensive programming)
-  hittable->bbox = aabb_empty();
+  hittable->bbox = triangle_hittable_bbox(&tri_hit_data->triangle);
 
-  // Calculate bounding box with explicit temporary variables
-  // (prevents potential compiler optimization issues)
-  double min_x = fmin(fmin(v0.x, v1.x), v2.x);
-  double min_y = fmin(fmin(v0.y, v1.y), v2.y);
-  double min_z = fmin(fmin(v0.z, v1.z), v2.z);
-
-  double max_x = fmax(fmax(v0.x, v1.x), v2.x);
-  double max_y = fmax(fmax(v0.y, v1.y), v2.y);
-  double max_z = fmax(fmax(v0.z, v1.z), v2.z);
+  return hittable;
+}
 
-  // Create points with explicit assignment
-  Vec3 min_point;
-  min_point.x = min_x;
-  min_point.y = min_y;
-  min_point.z = min_z;
+bool triangle_hittable_apply_transform(Hittable *self, const Transform *xf) {
+  assert(self != NULL && self->type == HITTABLE_TRIANGLE);
+  TriangleHittable *tri_hit = (TriangleHittable *)self->data;
+  const TriangleRaw *tri = &tri_hit->triangle;
 
-  Vec3 max_point;
-  max_point.x = max_x;
-  max_point.y = max_y;
-  max_point.z = max_z;
+  tri_hit->triangle = triangle_raw_create(transform_point(xf, tri->v0),
+                                          transform_point(xf, tri->v1),
+                                          transform_point(xf, tri->v2));
+  self->bbox = triangle_hittable_bbox(&tri_hit->triangle);
+  return true;
+}
 
-  // Add padding so BVH doesnt break (div by zero)
-  const double padding_amount = 0.001; // 1mm
-  Vec3 padding = {padding_amount, padding_amount, padding_amount};
+// Uniform point on the triangle: fold the unit square onto it, then convert
+// from area to solid-angle density.
+bool triangle_sample_light(const Hittable *self, Vec3 origin, double u1,
+                           double u2, LightSample *ls) {
+  const TriangleHittable *tri_hit = (const TriangleHittable *)self->data;
+  const TriangleRaw *tri = &tri_hit->triangle;
 
-  min_point = vec3_sub(min_point, padding);
-  max_point = vec3_add(max_point, padding);
+  if (u1 + u2 > 1.0) {
+    u1 = 1.0 - u1;
+    u2 = 1.0 - u2;
+  }
+  ls->p = vec3_add(tri->v0, vec3_add(vec3_scale(tri->edge1, u1),
+                                     vec3_scale(tri->edge2, u2)));
+  Vec3 d = vec3_sub(ls->p, origin);
+  real dist_squared = vec3_length_squared(d);
+  ls->dist = sqrt(dist_squared);
+  ls->wi = vec3_divs(d, ls->dist);
+
+  real area = 0.5 * vec3_length(vec3_cross(tri->edge1, tri->edge2));
+  real cos_light = fabs(vec3_dot(tri->normal, ls->wi));
+  if (cos_light < DBL_EPSILON || area <= 0)
+    return false;
+  ls->pdf = dist_squared / (cos_light * area);
+  return true;
+}
 
-  // Create AABB
-  hittable->bbox = aabb_from_points(min_point, max_point);
+real triangle_light_pdf(const Hittable *self, Ray r, const HitRecord *rec) {
+  const TriangleHittable *tri_hit = (const TriangleHittable *)self->data;
+  const TriangleRaw *tri = &tri_hit->triangle;
+  Vec3 d = vec3_sub(rec->p, r.origin);
+  real dist_squared = vec3_length_squared(d);
+  real area = 0.5 * vec3_length(vec3_cross(tri->edge1, tri->edge2));
+  real cos_light = fabs(vec3_dot(tri->normal, d)) / sqrt(dist_squared);
+  if (cos_light < DBL_EPSILON || area <= 0)
+    return 0.0;
+  return dist_squared / (cos_light * area);
+}
 
-  return hittable;
+bool triangle_light_shape(const Hittable *self, real *area, Vec3 *normal) {
+  const TriangleHittable *tri_hit = (const TriangleHittable *)self->data;
+  const TriangleRaw *tri = &tri_hit->triangle;
+  *area = 0.5 * vec3_length(vec3_cross(tri->edge1, tri->edge2));
+  *normal = tri->normal;
+  return true;
 }
@@ -1,6 +1,7 @@
 #ifndef TRIANGLE_HITTABLE_H
 #define TRIANGLE_HITTABLE_H
 
+#include "core/transform.h"
 #include "hittable.h"
 #include "material/material.h"
 #include "triangle_raw.h"
@@ -14,5 +15,13 @@ extern bool triangle_hit(Hittable *hittable, Ray r, Interval t_bounds,
 extern void triangle_hittable_print(const Hittable *hittable);
 extern Hittable *triangle_hittable_create(Vec3 v0, Vec3 v1, Vec3 v2,
                                           Material *mat);
+extern bool triangle_hittable_apply_transform(Hittable *self,
+                                              const Transform *xf);
+extern bool triangle_sample_light(const Hittable *self, Vec3 origin, double u1,
+                                  double u2, LightSample *ls);
+extern real triangle_light_pdf(const Hittable *self, Ray r,
+                               const HitRecord *rec);
+extern bool triangle_light_shape(const Hittable *self, real *area,
+                                 Vec3 *normal);
 
 #endif // TRIANGLE_HITTABLE_H
\ No newline at end of file
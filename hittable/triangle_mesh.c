@@ -93,37 +93,37 @@ bool triangle_raw_intersect(const TriangleRaw *tri, Ray r, Interval t_bounds,
                             HitRecord *rec, Material *mat) {
 
   Vec3 h = vec3_cross(r.direction, tri->edge2);
-  double det = vec3_dot(tri->edge1, h);
+  real det = vec3_dot(tri->edge1, h);
 
   if (fabs(det) < EPSILON) {
     return false; // Ray is parallel to triangle
   }
 
   // Calculate barycentric coordinate u
-  double inv = 1.0 / det;
+  real inv = 1 / det;
   Vec3 s = vec3_sub(r.origin, tri->v0);
-  double u = inv * vec3_dot(s, h);
+  real u = inv * vec3_dot(s, h);
 
-  if (u < 0.0 || u > 1.0) {
+  if (u < 0 || u > 1) {
     return false;
   }
 
   // Calculate barycentric coordinate v
   Vec3 q = vec3_cross(s, tri->edge1);
-  double v = inv * vec3_dot(r.direction, q);
+  real v = inv * vec3_dot(r.direction, q);
 
-  if (v < 0.0 || u + v > 1.0) {
+  if (v < 0 || u + v > 1) {
     return false;
   }
 
   // Calculate t parameter
-  double t = inv * vec3_dot(tri->edge2, q);
+  real t = inv * vec3_dot(tri->edge2, q);
 
   if (interval_surrounds(t_bounds, t)) {
     rec->t = t;
-    rec->p = ray_at(r, t);
+    rec->p = triangle_raw_point(tri, u, v);
     Vec3 normal = tri->normal;
-    if (det < 0.0) {
+    if (det < 0) {
       normal = vec3_negate(normal); // Flip normal for back-facing triangles
     }
 
@@ -2,61 +2,78 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "core/arena.h"
 #include "core/interval.h"
 #include "core/ray.h"
 #include "core/vec3.h"
 #include "hittable/hittable.h"
 #include "triangle_raw.h"
 
-// Möller-Trumbore ray-triangle intersection algorithm
-bool triangle_raw_hit(const TriangleRaw *tri, Ray r, Interval t_bounds,
-                      HitRecord *rec, Material *mat) {
-  const double EPSILON = 1e-13;
+// Möller-Trumbore ray-triangle intersection algorithm, yielding t and the
+// barycentrics (u, v) of the hit.
+static inline bool triangle_raw_intersect_t(const TriangleRaw *tri, Ray r,
+                                            Interval t_bounds, real *t_hit,
+                                            real *u_hit, real *v_hit) {
+  const real EPSILON = 1e-13;
   // Calculate determinant
   Vec3 h = vec3_cross(r.direction, tri->edge2);
-  double det = vec3_dot(tri->edge1, h);
+  real det = vec3_dot(tri->edge1, h);
 
   if (fabs(det) < EPSILON) {
     return false; // Ray is parallel to triangle
   }
 
   // Calculate barycentric coordinate u
-  double inv = 1.0 / det;
+  real inv = 1 / det;
   Vec3 s = vec3_sub(r.origin, tri->v0);
-  double u = inv * vec3_dot(s, h);
+  real u = inv * vec3_dot(s, h);
 
-  if (u < 0.0 || u > 1.0) {
+  if (u < 0 || u > 1) {
     return false;
   }
 
   // Calculate barycentric coordinate v
   Vec3 q = vec3_cross(s, tri->edge1);
-  double v = inv * vec3_dot(r.direction, q);
+  real v = inv * vec3_dot(r.direction, q);
 
-  if (v < 0.0 || u + v > 1.0) {
+  if (v < 0 || u + v > 1) {
     return false;
   }
   // Calculate t parameter
-  double t = inv * vec3_dot(tri->edge2, q);
+  real t = inv * vec3_dot(tri->edge2, q);
 
   if (interval_surrounds(t_bounds, t)) {
-    rec->t = t;
-    rec->p = ray_at(r, t);
-
-    // Ensure normal faces outward from ray
-    hitrec_set_face_normal(rec, r, tri->normal);
-    // printf("Triangle hit at t=%.2f, p=(%.2f, %.2f, %.2f)\n", t,
-    //        rec->p.x, rec->p.y, rec->p.z);
-    rec->mat = mat;
+    *t_hit = t;
+    *u_hit = u;
+    *v_hit = v;
     return true;
   }
 
   return false;
 }
 
+// Records only t and the barycentrics (u, v) of the hit.
+bool triangle_raw_hit(const TriangleRaw *tri, Ray r, Interval t_bounds,
+                      HitRecord *rec) {
+  return triangle_raw_intersect_t(tri, r, t_bounds, &rec->t, &rec->u,
+                                  &rec->v);
+}
+
+// From the barycentrics rather than ray_at, so the point is as accurate as
+// the vertices (see ray_spawn).
+Vec3 triangle_raw_point(const TriangleRaw *tri, real u, real v) {
+  return vec3_add(tri->v0, vec3_add(vec3_scale(tri->edge1, u),
+                                    vec3_scale(tri->edge2, v)));
+}
+
+bool triangle_raw_occluded(const TriangleRaw *tri, Ray r, Interval t_bounds) {
+  real t, u, v;
+  return triangle_raw_intersect_t(tri, r, t_bounds, &t, &u, &v);
+}
+
 void triangle_destroy(void *self) {
   assert(self != NULL);
-  free(self);
+  rt_free(self);
 }
 
 void triangle_raw_print(void *self) {
@@ -92,5 +109,23 @@ TriangleRaw triangle_raw_create(Vec3 v0, Vec3 v1, Vec3 v2) {
 bool triangle_hit(Hittable *hittable, Ray r, Interval t_bounds,
                   HitRecord *rec) {
   TriangleRaw *tri = (TriangleRaw *)hittable->data;
-  return triangle_raw_hit(tri, r, t_bounds, rec, hittable->mat);
+  if (!triangle_raw_hit(tri, r, t_bounds, rec)) {
+    return false;
+  }
+  rec->obj = hittable;
+  rec->prim_index = 0;
+  return true;
+}
+
+bool triangle_occluded(const Hittable *hittable, Ray r, Interval t_bounds) {
+  return triangle_raw_occluded((const TriangleRaw *)hittable->data, r,
+                               t_bounds);
+}
+
+void triangle_finalize(const Hittable *hittable, Ray r, HitRecord *rec) {
+  const TriangleRaw *tri = (const TriangleRaw *)hittable->data;
+  rec->p = triangle_raw_point(tri, rec->u, rec->v);
+  // Ensure normal faces outward from ray
+  hitrec_set_face_normal(rec, r, tri->normal);
+  rec->mat = hittable->mat;
 }
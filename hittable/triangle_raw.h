@@ -17,9 +17,17 @@ extern TriangleRaw triangle_raw_create(Vec3 v0, Vec3 v1, Vec3 v2);
 extern void triangle_destroy(void *self);   // For dynarray
 extern void triangle_raw_print(void *self); // For dynarray
 extern bool triangle_raw_hit(const TriangleRaw *tri, Ray r, Interval t_bounds,
-                             HitRecord *rec, Material *mat);
+                             HitRecord *rec);
+extern bool triangle_raw_occluded(const TriangleRaw *tri, Ray r,
+                                  Interval t_bounds);
+// Point of the triangle at the barycentrics (u, v) recorded by a hit.
+extern Vec3 triangle_raw_point(const TriangleRaw *tri, real u, real v);
 
 extern bool triangle_hit(Hittable *hittable, Ray r, Interval t_bounds,
                          HitRecord *rec);
+extern bool triangle_occluded(const Hittable *hittable, Ray r,
+                              Interval t_bounds);
+extern void triangle_finalize(const Hittable *hittable, Ray r,
+                              HitRecord *rec);
 
 #endif // TRIANGLE_RAW_H
\ No newline at end of file
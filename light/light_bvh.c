@@ -0,0 +1,437 @@
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core/aabb.h"
+#include "core/dyn_array.h"
+#include "core/util.h"
+#include "hittable/hittable.h"
+#include "light_bvh.h"
+#include "material/material.h"
+
+// Spatial, directional and power bounds of one or more lights. Emission is
+// two-sided, so the normal cone is a double cone: it bounds every normal up
+// to sign.
+typedef struct LightBounds {
+  AABB bounds;
+  Vec3 axis;
+  double cos_theta_o; // -1 if the lights emit toward every direction
+  double power;
+} LightBounds;
+
+typedef struct LightBVHNode {
+  LightBounds lb;
+  int parent;            // -1 for the root
+  int child[2];          // Unused in leaves
+  const Hittable *light; // Set in leaves only
+} LightBVHNode;
+
+typedef struct LightLeaf {
+  const Hittable *light;
+  int node;
+} LightLeaf;
+
+struct LightBVH {
+  LightBVHNode *nodes;
+  int node_count;
+  LightLeaf *leaves; // Sorted by light pointer for lightbvh_pmf
+  int leaf_count;
+};
+
+typedef struct LightPrim {
+  LightBounds lb;
+  Vec3 centroid;
+  const Hittable *light;
+} LightPrim;
+
+static Vec3 aabb_centroid(const AABB *box) {
+  return (Vec3){0.5 * (box->x.min + box->x.max),
+                0.5 * (box->y.min + box->y.max),
+                0.5 * (box->z.min + box->z.max)};
+}
+
+static LightBounds lightbounds_of(const Hittable *light) {
+  real area;
+  Vec3 normal;
+  bool flat = hittable_light_shape(light, &area, &normal);
+  Vec3 centroid = aabb_centroid(&light->bbox);
+  Color emit = material_emitted(light->mat, 0.0, 0.0, &centroid);
+  double luminance = 0.2126 * emit.x + 0.7152 * emit.y + 0.0722 * emit.z;
+
+  LightBounds lb;
+  lb.bounds = light->bbox;
+  if (flat) {
+    lb.axis = normal;
+    lb.cos_theta_o = 1.0;
+    lb.power = 2 * PI * area * luminance; // Both faces
+  } else {
+    lb.axis = (Vec3){0.0, 0.0, 1.0};
+    lb.cos_theta_o = -1.0;
+    lb.power = PI * area * luminance;
+  }
+  return lb;
+}
+
+// Smallest double cone containing both double cones.
+static void cone_union(Vec3 a, double cos_a, Vec3 b, double cos_b,
+                       Vec3 *axis, double *cos_o) {
+  *axis = a;
+  *cos_o = -1.0;
+  if (cos_a <= -1.0 || cos_b <= -1.0)
+    return;
+  if (vec3_dot(a, b) < 0)
+    b = vec3_negate(b);
+
+  double theta_a = acos(fmin(cos_a, 1.0));
+  double theta_b = acos(fmin(cos_b, 1.0));
+  double theta_d = acos(fmin(vec3_dot(a, b), 1.0));
+  if (theta_d + theta_b <= theta_a) {
+    *cos_o = cos_a;
+    return;
+  }
+  if (theta_d + theta_a <= theta_b) {
+    *axis = b;
+    *cos_o = cos_b;
+    return;
+  }
+
+  // A double cone of half-angle pi/2 already covers the whole sphere
+  double theta_o = 0.5 * (theta_a + theta_d + theta_b);
+  Vec3 wr = vec3_cross(a, b);
+  if (theta_o >= PI / 2 || vec3_length_squared(wr) == 0)
+    return;
+
+  // Rotate a toward b so the new cone just touches both
+  double theta_r = theta_o - theta_a;
+  Vec3 toward_b = vec3_cross(vec3_normalized(wr), a);
+  *axis = vec3_normalized(vec3_add(vec3_scale(a, cos(theta_r)),
+                                   vec3_scale(toward_b, sin(theta_r))));
+  *cos_o = cos(theta_o);
+}
+
+static LightBounds lightbounds_union(const LightBounds *a,
+                                     const LightBounds *b) {
+  LightBounds lb;
+  AABB box_a = a->bounds;
+  AABB box_b = b->bounds;
+  lb.bounds = aabb_surrounding_box(&box_a, &box_b);
+  cone_union(a->axis, a->cos_theta_o, b->axis, b->cos_theta_o, &lb.axis,
+             &lb.cos_theta_o);
+  lb.power = a->power + b->power;
+  return lb;
+}
+
+// cos(max(0, theta_a - theta_b)) from the cosines and sines of both angles.
+static double cos_sub_clamped(double cos_a, double sin_a, double cos_b,
+                              double sin_b) {
+  if (cos_a > cos_b)
+    return 1.0;
+  return cos_a * cos_b + sin_a * sin_b;
+}
+
+// Conservative estimate of the light a point `p` with normal `n` can receive
+// from the lights in `lb`: power over squared distance, times the best-case
+// emitter and receiver cosines over the bounding sphere of the lights.
+static double lightbounds_importance(const LightBounds *lb, Vec3 p, Vec3 n) {
+  if (lb->power <= 0)
+    return 0.0;
+
+  Vec3 pc = aabb_centroid(&lb->bounds);
+  Vec3 d = vec3_sub(p, pc);
+  double dist_squared = vec3_length_squared(d);
+  Vec3 diag = {interval_size(lb->bounds.x), interval_size(lb->bounds.y),
+               interval_size(lb->bounds.z)};
+  double radius_squared = 0.25 * vec3_length_squared(diag);
+  Vec3 wi = dist_squared > 0 ? vec3_divs(d, sqrt(dist_squared)) : lb->axis;
+
+  // Angle subtended by the bounding sphere; everything is possible inside it
+  double cos_b = -1.0;
+  double sin_b = 0.0;
+  if (dist_squared > radius_squared) {
+    double sin2_b = radius_squared / dist_squared;
+    cos_b = sqrt(1 - sin2_b);
+    sin_b = sqrt(sin2_b);
+  }
+
+  double cos_o = lb->cos_theta_o;
+  double sin_o = sqrt(fmax(0.0, 1 - cos_o * cos_o));
+  double cos_w = fabs(vec3_dot(lb->axis, wi));
+  double sin_w = sqrt(fmax(0.0, 1 - cos_w * cos_w));
+  double cos_x = cos_sub_clamped(cos_w, sin_w, cos_o, sin_o);
+  double sin_x = sqrt(fmax(0.0, 1 - cos_x * cos_x));
+  double cos_emit = cos_sub_clamped(cos_x, sin_x, cos_b, sin_b);
+  if (cos_emit <= 0)
+    return 0.0;
+
+  double importance =
+      lb->power * cos_emit / fmax(dist_squared, radius_squared);
+
+  if (vec3_length_squared(n) > 0) {
+    double cos_i = -vec3_dot(n, wi);
+    double sin_i = sqrt(fmax(0.0, 1 - cos_i * cos_i));
+    importance *= fmax(0.0, cos_sub_clamped(cos_i, sin_i, cos_b, sin_b));
+  }
+  return importance;
+}
+
+static int leaf_compare(const void *a, const void *b) {
+  uintptr_t la = (uintptr_t)((const LightLeaf *)a)->light;
+  uintptr_t lb = (uintptr_t)((const LightLeaf *)b)->light;
+  return (la > lb) - (la < lb);
+}
+
+#define LIGHT_BVH_BUCKETS 12
+
+// Surface area orientation heuristic: the cost of a node grows with its
+// power, its surface area and the solid angle its normal cone (widened by
+// the pi/2 emission falloff) can illuminate. `kr` penalises splitting
+// across a thin dimension of the parent bounds.
+static double lightbounds_cost(const LightBounds *lb, double kr) {
+  double cos_o = fmax(-1.0, fmin(lb->cos_theta_o, 1.0));
+  double theta_o = acos(cos_o);
+  double theta_w = fmin(theta_o + PI / 2, PI);
+  double sin_o = sin(theta_o);
+  double m_omega =
+      2 * PI * (1 - cos_o) +
+      PI / 2 *
+          (2 * theta_w * sin_o - cos(theta_o - 2 * theta_w) -
+           2 * theta_o * sin_o + cos_o);
+
+  double dx = interval_size(lb->bounds.x);
+  double dy = interval_size(lb->bounds.y);
+  double dz = interval_size(lb->bounds.z);
+  double area = 2 * (dx * dy + dy * dz + dz * dx);
+  return lb->power * m_omega * area * kr;
+}
+
+typedef struct LightBucket {
+  LightBounds lb;
+  int count;
+} LightBucket;
+
+static void bucket_add(LightBucket *bucket, const LightBounds *lb) {
+  bucket->lb = bucket->count ? lightbounds_union(&bucket->lb, lb) : *lb;
+  bucket->count++;
+}
+
+static void bucket_merge(LightBucket *dst, const LightBucket *src) {
+  if (src->count == 0)
+    return;
+  dst->lb = dst->count ? lightbounds_union(&dst->lb, &src->lb) : src->lb;
+  dst->count += src->count;
+}
+
+// Picks the bucketed split with the lowest SAOH cost over all three axes.
+// Returns false if every centroid coincides.
+static bool lightbvh_find_split(const LightPrim *prims, int start, int end,
+                                const AABB *bounds, const AABB *centroids,
+                                int *best_axis, int *best_bucket) {
+  double extent[3] = {interval_size(bounds->x), interval_size(bounds->y),
+                      interval_size(bounds->z)};
+  double max_extent = fmax(extent[0], fmax(extent[1], extent[2]));
+  double best_cost = INFINITY;
+  bool found = false;
+
+  for (int axis = 0; axis < 3; axis++) {
+    Interval range = axis_interval((AABB *)centroids, axis);
+    double width = interval_size(range);
+    if (width <= 0)
+      continue;
+
+    LightBucket buckets[LIGHT_BVH_BUCKETS] = {0};
+    for (int i = start; i < end; i++) {
+      double c = vec3_axis(prims[i].centroid, axis);
+      int b = (int)(LIGHT_BVH_BUCKETS * (c - range.min) / width);
+      b = b < 0 ? 0 : (b >= LIGHT_BVH_BUCKETS ? LIGHT_BVH_BUCKETS - 1 : b);
+      bucket_add(&buckets[b], &prims[i].lb);
+    }
+
+    double kr = extent[axis] > 0 ? max_extent / extent[axis] : 1.0;
+    for (int split = 0; split < LIGHT_BVH_BUCKETS - 1; split++) {
+      LightBucket below = {0};
+      LightBucket above = {0};
+      for (int b = 0; b <= split; b++)
+        bucket_merge(&below, &buckets[b]);
+      for (int b = split + 1; b < LIGHT_BVH_BUCKETS; b++)
+        bucket_merge(&above, &buckets[b]);
+      if (below.count == 0 || above.count == 0)
+        continue;
+
+      double cost = lightbounds_cost(&below.lb, kr) +
+                    lightbounds_cost(&above.lb, kr);
+      if (cost < best_cost) {
+        best_cost = cost;
+        *best_axis = axis;
+        *best_bucket = split;
+        found = true;
+      }
+    }
+  }
+  return found;
+}
+
+// Top-down build into a flat node array with parent links, so that the
+// selection probability of a light can be recomputed bottom-up. Unlike the
+// geometry BVH's median split, splits are chosen by SAOH cost: a median
+// split readily groups half of a nearby emissive mesh with far away
+// lights, and those triangles are then almost never selected.
+static int lightbvh_build(LightBVH *bvh, LightPrim *prims, int start, int end,
+                          int parent) {
+  int index = bvh->node_count++;
+  LightBVHNode *node = &bvh->nodes[index];
+  node->parent = parent;
+  node->light = NULL;
+
+  if (end - start == 1) {
+    node->lb = prims[start].lb;
+    node->light = prims[start].light;
+    bvh->leaves[bvh->leaf_count++] =
+        (LightLeaf){.light = node->light, .node = index};
+    return index;
+  }
+
+  AABB bounds = aabb_empty();
+  AABB centroids = aabb_empty();
+  for (int i = start; i < end; i++) {
+    AABB point = aabb_from_points(prims[i].centroid, prims[i].centroid);
+    centroids = aabb_surrounding_box(&centroids, &point);
+    bounds = aabb_surrounding_box(&bounds, &prims[i].lb.bounds);
+  }
+
+  int mid = start + (end - start) / 2;
+  int axis, bucket;
+  if (lightbvh_find_split(prims, start, end, &bounds, &centroids, &axis,
+                          &bucket)) {
+    Interval range = axis_interval(&centroids, axis);
+    double width = interval_size(range);
+    int lo = start;
+    int hi = end - 1;
+    while (lo <= hi) {
+      double c = vec3_axis(prims[lo].centroid, axis);
+      int b = (int)(LIGHT_BVH_BUCKETS * (c - range.min) / width);
+      b = b < 0 ? 0 : (b >= LIGHT_BVH_BUCKETS ? LIGHT_BVH_BUCKETS - 1 : b);
+      if (b <= bucket) {
+        lo++;
+      } else {
+        LightPrim tmp = prims[lo];
+        prims[lo] = prims[hi];
+        prims[hi--] = tmp;
+      }
+    }
+    mid = lo;
+  }
+
+  int left = lightbvh_build(bvh, prims, start, mid, index);
+  int right = lightbvh_build(bvh, prims, mid, end, index);
+  node = &bvh->nodes[index];
+  node->child[0] = left;
+  node->child[1] = right;
+  node->lb = lightbounds_union(&bvh->nodes[left].lb, &bvh->nodes[right].lb);
+  return index;
+}
+
+LightBVH *lightbvh_create(const DynArray *lights) {
+  assert(lights != NULL);
+  int count = dynarray_size(lights);
+
+  LightBVH *bvh = malloc(sizeof(struct LightBVH));
+  assert(bvh != NULL);
+  bvh->node_count = 0;
+  bvh->leaf_count = 0;
+  bvh->nodes = NULL;
+  bvh->leaves = NULL;
+  if (count == 0)
+    return bvh;
+
+  LightPrim *prims = malloc(sizeof(LightPrim) * (size_t)count);
+  assert(prims != NULL);
+  for (int i = 0; i < count; i++) {
+    const Hittable *light = dynarray_get(lights, i);
+    prims[i].lb = lightbounds_of(light);
+    prims[i].centroid = aabb_centroid(&light->bbox);
+    prims[i].light = light;
+  }
+
+  bvh->nodes = malloc(sizeof(LightBVHNode) * (size_t)(2 * count - 1));
+  bvh->leaves = malloc(sizeof(LightLeaf) * (size_t)count);
+  assert(bvh->nodes != NULL && bvh->leaves != NULL);
+  lightbvh_build(bvh, prims, 0, count, -1);
+  qsort(bvh->leaves, (size_t)count, sizeof(LightLeaf), leaf_compare);
+
+  free(prims);
+  return bvh;
+}
+
+void lightbvh_destroy(LightBVH *self) {
+  assert(self != NULL);
+  free(self->nodes);
+  free(self->leaves);
+  free(self);
+}
+
+int lightbvh_node_count(const LightBVH *self) {
+  return self ? self->node_count : 0;
+}
+
+const Hittable *lightbvh_sample(const LightBVH *self, Vec3 p, Vec3 n,
+                                double *u_inout, double *pmf) {
+  double u = *u_inout;
+  *pmf = 0.0;
+  if (self->node_count == 0)
+    return NULL;
+
+  double prob = 1.0;
+  const LightBVHNode *node = &self->nodes[0];
+  while (node->light == NULL) {
+    const LightBVHNode *left = &self->nodes[node->child[0]];
+    const LightBVHNode *right = &self->nodes[node->child[1]];
+    double w_left = lightbounds_importance(&left->lb, p, n);
+    double w_right = lightbounds_importance(&right->lb, p, n);
+    if (w_left <= 0 && w_right <= 0)
+      return NULL;
+
+    // Descend and rescale u so it stays uniform for the next level
+    double p_left = w_left / (w_left + w_right);
+    if (u < p_left) {
+      node = left;
+      u /= p_left;
+      prob *= p_left;
+    } else {
+      node = right;
+      u = (u - p_left) / (1 - p_left);
+      prob *= 1 - p_left;
+    }
+    u = fmin(u, 0x1.fffffffffffffp-1);
+  }
+  *pmf = prob;
+  *u_inout = u;
+  return node->light;
+}
+
+double lightbvh_pmf(const LightBVH *self, Vec3 p, Vec3 n,
+                    const Hittable *light) {
+  LightLeaf key = {.light = light, .node = -1};
+  const LightLeaf *leaf = bsearch(&key, self->leaves, (size_t)self->leaf_count,
+                                  sizeof(LightLeaf), leaf_compare);
+  if (leaf == NULL)
+    return 0.0;
+
+  // Same choices as lightbvh_sample, walked from the leaf up to the root
+  double prob = 1.0;
+  int index = leaf->node;
+  while (self->nodes[index].parent >= 0) {
+    const LightBVHNode *parent = &self->nodes[self->nodes[index].parent];
+    double w_left =
+        lightbounds_importance(&self->nodes[parent->child[0]].lb, p, n);
+    double w_right =
+        lightbounds_importance(&self->nodes[parent->child[1]].lb, p, n);
+    if (w_left <= 0 && w_right <= 0)
+      return 0.0;
+    double w = index == parent->child[0] ? w_left : w_right;
+    prob *= w / (w_left + w_right);
+    index = self->nodes[index].parent;
+  }
+  return prob;
+}
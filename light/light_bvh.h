@@ -0,0 +1,34 @@
+#ifndef LIGHT_BVH_H
+#define LIGHT_BVH_H
+
+#include <stdbool.h>
+
+#include "core/dyn_array.h"
+#include "core/vec3.h"
+#include "hittable/hittable.h"
+
+// Hierarchy over the emitters of a scene for importance-based light
+// selection. Every node bounds its lights in space, in emitted power and in
+// the directions their normals point to, so that a shading point can pick a
+// light in proportion to an estimate of how much it could receive from it.
+typedef struct LightBVH LightBVH;
+
+// Builds the hierarchy over `lights` (Hittable* accepted by
+// lightlist_is_light). The array must outlive the tree.
+extern LightBVH *lightbvh_create(const DynArray *lights);
+extern void lightbvh_destroy(LightBVH *self);
+extern int lightbvh_node_count(const LightBVH *self);
+
+// Picks a light for shading point `p` with surface normal `n` (zero for no
+// normal) by walking the tree with the uniform variate `*u`, and returns its
+// selection probability in `pmf`. `*u` is rescaled along the way and left
+// uniform in [0, 1) again, so the caller can reuse it for sampling the
+// light. Returns NULL if no light can reach `p`.
+extern const Hittable *lightbvh_sample(const LightBVH *self, Vec3 p, Vec3 n,
+                                       double *u, double *pmf);
+
+// Probability that lightbvh_sample from `p` and `n` selects `light`.
+extern double lightbvh_pmf(const LightBVH *self, Vec3 p, Vec3 n,
+                           const Hittable *light);
+
+#endif // LIGHT_BVH_H
@@ -0,0 +1,74 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "core/dyn_array.h"
+#include "hittable/hittable.h"
+#include "light_list.h"
+#include "material/material.h"
+
+bool lightlist_is_light(const Hittable *obj) {
+  return obj->mat != NULL && obj->mat->emitted != NULL &&
+         hittable_is_sampleable(obj);
+}
+
+LightList *lightlist_create(const Hittable *objects) {
+  assert(objects != NULL && objects->type == HITTABLE_LIST);
+
+  LightList *list = malloc(sizeof(struct LightList));
+  assert(list != NULL);
+  list->lights = dynarray_create(4, NULL, NULL);
+
+  DynArray *objs = (DynArray *)objects->data;
+  for (int i = 0; i < dynarray_size(objs); i++) {
+    Hittable *obj = dynarray_get(objs, i);
+    if (lightlist_is_light(obj))
+      dynarray_push(list->lights, obj);
+  }
+  list->bvh = lightbvh_create(list->lights);
+  return list;
+}
+
+void lightlist_destroy(LightList *self) {
+  assert(self != NULL);
+  // The lights themselves belong to the scene
+  lightbvh_destroy(self->bvh);
+  dynarray_release(self->lights);
+  free(self);
+}
+
+int lightlist_size(const LightList *self) {
+  return self ? dynarray_size(self->lights) : 0;
+}
+
+bool lightlist_sample(const LightList *self, Vec3 origin, Vec3 normal,
+                      double time, Sampler *sampler, LightSample *ls,
+                      const Hittable **light) {
+  if (lightlist_size(self) == 0)
+    return false;
+
+  // The selection variate, rescaled by the tree walk, becomes the first
+  // coordinate of the point on the light, so that selection and point are
+  // stratified jointly by a single 2D request
+  double pmf;
+  double u1, u2;
+  sampler_get_2d(sampler, &u1, &u2);
+  *light = lightbvh_sample(self->bvh, origin, normal, &u1, &pmf);
+  if (*light == NULL)
+    return false;
+
+  if (!hittable_sample_light(*light, origin, time, u1, u2, ls))
+    return false;
+  ls->pdf *= pmf;
+  return true;
+}
+
+double lightlist_pdf(const LightList *self, Ray r, Vec3 normal,
+                     const HitRecord *rec) {
+  if (lightlist_size(self) == 0)
+    return 0.0;
+  double pmf = lightbvh_pmf(self->bvh, r.origin, normal, rec->obj);
+  if (pmf <= 0)
+    return 0.0;
+  return pmf * hittable_light_pdf(rec->obj, r, rec);
+}
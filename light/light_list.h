@@ -0,0 +1,41 @@
+#ifndef LIGHT_LIST_H
+#define LIGHT_LIST_H
+
+#include <stdbool.h>
+
+#include "core/dyn_array.h"
+#include "core/sampler.h"
+#include "hittable/hittable.h"
+#include "light_bvh.h"
+
+// Emissive primitives gathered from the scene at load time, for explicit
+// light sampling (next-event estimation) by the integrator.
+typedef struct LightList {
+  DynArray *lights; // Hittable* that lightlist_is_light accepts
+  LightBVH *bvh;     // Importance hierarchy over `lights`
+} LightList;
+
+// Collects every directly sampleable emitter from a scene object list.
+extern LightList *lightlist_create(const Hittable *objects);
+extern void lightlist_destroy(LightList *self);
+extern int lightlist_size(const LightList *self);
+
+// Returns true if `obj` is an emitter the light list samples, i.e. one whose
+// emission is already accounted for by lightlist_sample after a diffuse
+// bounce.
+extern bool lightlist_is_light(const Hittable *obj);
+
+// Picks one light through the light BVH by its importance to `origin` with
+// surface normal `normal`, and samples a point on it. Makes one 2D sampler
+// request. The returned pdf includes the selection probability.
+extern bool lightlist_sample(const LightList *self, Vec3 origin, Vec3 normal,
+                             double time, Sampler *sampler, LightSample *ls,
+                             const Hittable **light);
+
+// Density with which lightlist_sample from `r.origin` with surface normal
+// `normal` would have produced the direction of `r`, which hit the listed
+// light `rec->obj`.
+extern double lightlist_pdf(const LightList *self, Ray r, Vec3 normal,
+                            const HitRecord *rec);
+
+#endif // LIGHT_LIST_H
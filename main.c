@@ -1,14 +1,19 @@
 #include "app/camera.h"
+#include "core/arena.h"
 #include "core/color.h"
 #include "core/dyn_array.h"
 #include "core/generic_types.h"
+#include "core/page_cache.h"
 #include "parsers/obj_parser.h"
 #include "core/ray.h"
+#include "core/sampler.h"
+#include "core/stats.h"
 #include "parsers/scene_parser.h"
 #include "core/vec3.h"
 #include "hittable/bvh_node.h"
 #include "hittable/hittable.h"
 #include "hittable/hittable_list.h"
+#include "hittable/lazy_hittable.h"
 #include "hittable/quad.h"
 #include "hittable/rotate_y.h"
 #include "hittable/sphere.h"
@@ -18,6 +23,8 @@
 #include "material/material.h"
 #include "material/metal.h"
 #include "app/scene.h"
+#include "app/scene_snapshot.h"
+#include "app/wavefront.h"
 #include "texture/checkered.h"
 #include "texture/solid_color.h"
 #include "texture/texture.h"
@@ -28,19 +35,119 @@
 #include <stdlib.h>
 #include <string.h>
 
+// Parses the scene file and builds the world to render. With `load_lazy`
+// lazy models are loaded up front too.
+static Hittable *prepare_scene(const char *path, Scene *scene, Camera *cam,
+                               bool use_bvh, bool load_lazy) {
+  printf("Parsing scene file: %s\n", path);
+  parse_scene(path, scene, cam);
+  printf("Scene parsed successfully\n");
+  if (load_lazy) {
+    int lazy = scene_load_lazy(scene);
+    if (lazy > 0)
+      printf("Loaded %d lazy models\n", lazy);
+  }
+
+  int baked = scene_bake_transforms(scene);
+  printf("Baked static transforms: removed %d wrapper nodes\n", baked);
+
+  // Check if we have objects to render
+  DynArray *objects_array = (DynArray *)scene->objects->data;
+  int object_count = dynarray_size(objects_array);
+  printf("Scene contains %d objects\n", object_count);
+
+  if (object_count == 0) {
+    printf("Warning: No objects in scene to render\n");
+  } else if (!use_bvh) {
+    printf("Rendering %d objects without BVH acceleration...\n", object_count);
+  } else {
+    printf("Building BVH for %d objects...\n", object_count);
+  }
+
+  Hittable *world = scene_build_world(scene, use_bvh);
+  printf("Scene arena: %zu KiB used of %zu KiB reserved\n",
+         arena_bytes_used(scene->arena) / 1024,
+         arena_bytes_reserved(scene->arena) / 1024);
+  return world;
+}
+
 int main(int argc, char **argv) {
   printf("=== RAYTRACER STARTING ===\n");
 
-  if (argc < 3 || argc > 4) {
-    fprintf(stderr, "Usage: %s <scene_file> <output_file> [--no-bvh]\n",
-            argv[0]);
+  bool use_bvh = true;
+  bool use_wavefront = false;
+  bool use_packets = true;
+  bool sort_rays = false;
+  int wavefront_paths = WAVEFRONT_DEFAULT_PATHS;
+  bool sampler_given = false;
+  SamplerType sampler = SAMPLER_SOBOL;
+  bool args_ok = argc >= 3;
+  // `<scene_file> --compile-scene <out>` saves the prepared scene instead of
+  // rendering it
+  const char *compile_path = NULL;
+  int first_option = 3;
+  if (args_ok && strcmp(argv[2], "--compile-scene") == 0) {
+    args_ok = argc >= 4;
+    compile_path = args_ok ? argv[3] : NULL;
+    first_option = 4;
+  }
+  for (int i = first_option; args_ok && i < argc; i++) {
+    if (strcmp(argv[i], "--no-bvh") == 0) {
+      use_bvh = false;
+      printf("BVH acceleration disabled\n");
+    } else if (strcmp(argv[i], "--no-packets") == 0) {
+      use_packets = false;
+      printf("Primary ray packets disabled\n");
+    } else if (strcmp(argv[i], "--ray-sort") == 0) {
+      sort_rays = true;
+    } else if (strcmp(argv[i], "--wavefront-paths") == 0 && i + 1 < argc) {
+      wavefront_paths = atoi(argv[++i]);
+      args_ok = wavefront_paths > 0;
+    } else if (strcmp(argv[i], "--sampler") == 0 && i + 1 < argc) {
+      args_ok = sampler_type_parse(argv[++i], &sampler);
+      sampler_given = true;
+    } else if (strcmp(argv[i], "--page-budget") == 0 && i + 1 < argc) {
+      int budget_mib = atoi(argv[++i]);
+      args_ok = budget_mib > 0;
+      page_cache_set_budget((size_t)budget_mib << 20);
+    } else if (strcmp(argv[i], "--integrator") == 0 && i + 1 < argc) {
+      const char *name = argv[++i];
+      use_wavefront = strcmp(name, "wavefront") == 0;
+      args_ok = use_wavefront || strcmp(name, "megakernel") == 0;
+    } else {
+      args_ok = false;
+    }
+  }
+  if (!args_ok) {
+    fprintf(stderr,
+            "Usage: %s <scene_file> <output_file> [--no-bvh] [--no-packets] "
+            "[--sampler independent|sobol|bluenoise] "
+            "[--integrator megakernel|wavefront] [--wavefront-paths N] "
+            "[--ray-sort] [--page-budget MiB]\n"
+            "       %s <scene_file> --compile-scene <out%s> [--no-bvh]\n",
+            argv[0], argv[0], SCENE_SNAPSHOT_EXTENSION);
     return EXIT_FAILURE;
   }
 
-  bool use_bvh = true;
-  if (argc == 4 && strcmp(argv[3], "--no-bvh") == 0) {
-    use_bvh = false;
-    printf("BVH acceleration disabled\n");
+  bool is_snapshot = scene_snapshot_is_snapshot(argv[1]);
+  if (compile_path) {
+    if (is_snapshot) {
+      fprintf(stderr, "%s is already a compiled scene\n", argv[1]);
+      return EXIT_FAILURE;
+    }
+    Scene scene = scene_create();
+    Camera cam;
+    prepare_scene(argv[1], &scene, &cam, use_bvh, true);
+    char error[256];
+    bool ok = scene_snapshot_write(compile_path, &scene, &cam, error,
+                                   sizeof(error));
+    scene_destroy(&scene);
+    if (!ok) {
+      fprintf(stderr, "Failed to compile scene: %s\n", error);
+      return EXIT_FAILURE;
+    }
+    printf("Compiled scene written to %s\n", compile_path);
+    return 0;
   }
 
   printf("Opening output file: %s\n", argv[2]);
@@ -56,40 +163,57 @@ int main(int argc, char **argv) {
   printf("Scene created\n");
 
   Camera cam;
-  printf("Parsing scene file: %s\n", argv[1]);
-  parse_scene(argv[1], &scene, &cam);
-  printf("Scene parsed successfully\n");
-
-  // Check if we have objects to render
-  DynArray *objects_array = (DynArray *)scene.objects->data;
-  int object_count = dynarray_size(objects_array);
-  printf("Scene contains %d objects\n", object_count);
-
-  if (object_count == 0) {
-    printf("Warning: No objects in scene to render\n");
-    camera_render(&cam, scene.objects, out_file);
-  } else if (!use_bvh) {
-    printf("Rendering %d objects without BVH acceleration...\n", object_count);
-    camera_render(&cam, scene.objects, out_file);
+  Hittable *world;
+  if (is_snapshot) {
+    printf("Loading compiled scene: %s\n", argv[1]);
+    char error[256];
+    if (!scene_snapshot_load(argv[1], &scene, &cam, error, sizeof(error))) {
+      fprintf(stderr, "Failed to load compiled scene: %s\n", error);
+      scene_destroy(&scene);
+      fclose(out_file);
+      return EXIT_FAILURE;
+    }
+    world = scene.world;
+    printf("Compiled scene loaded (%d lights)\n", lightlist_size(scene.lights));
+    if (!use_bvh)
+      printf("Note: --no-bvh is fixed when the scene is compiled\n");
   } else {
-    printf("Building BVH for %d objects...\n", object_count);
-
-    // Create BVH acceleration structure
-    Hittable *bvh = bvhnode_create(scene.objects);
-
-    if (bvh) {
-      printf("BVH built successfully! Starting render...\n");
-      camera_render(&cam, bvh, out_file);
-      printf("Rendering complete! Starting BVH cleanup...\n");
+    world = prepare_scene(argv[1], &scene, &cam, use_bvh, false);
+  }
+  if (sampler_given)
+    cam.sampler = sampler;
+  cam.primary_packets = use_packets;
+  cam.wavefront_paths = wavefront_paths;
+  cam.sort_rays = sort_rays;
+  printf("Sampler: %s\n", sampler_type_name(cam.sampler));
 
-      // CRITICAL: Clean up BVH BEFORE scene destruction
-      bvh->destroy(bvh);
-      printf("BVH destroyed successfully\n");
-    } else {
-      printf("Failed to create BVH, falling back to linear rendering\n");
-      camera_render(&cam, scene.objects, out_file);
-    }
+  printf("Starting render (%s integrator)...\n",
+         use_wavefront ? "wavefront" : "megakernel");
+  if (use_wavefront) {
+    printf("Wavefront: %d paths in flight, ray sorting %s\n",
+           cam.wavefront_paths, cam.sort_rays ? "on" : "off");
+    wavefront_render(&cam, world, scene.lights, out_file);
+  } else {
+    if (sort_rays)
+      printf("Note: --ray-sort only applies to --integrator wavefront\n");
+    camera_render(&cam, world, scene.lights, out_file);
+  }
+  printf("Rendering complete!\n");
+  if (lazy_hittable_created_count() > 0) {
+    printf("Lazy models: %d of %d loaded by rays\n",
+           lazy_hittable_loaded_count(), lazy_hittable_created_count());
+  }
+  PageCacheStats pages = page_cache_stats();
+  if (pages.requests > 0) {
+    printf("Paged geometry: %llu page requests, %llu faults (%.1f MiB read, "
+           "%.1f ms stalled), %llu evictions, peak %.1f of %.1f MiB "
+           "resident\n",
+           pages.requests, pages.faults, pages.bytes_read / 1048576.0,
+           pages.stall_seconds * 1e3, pages.evictions,
+           pages.peak_resident_bytes / 1048576.0,
+           page_cache_budget() / 1048576.0);
   }
+  stats_print(stdout);
 
   printf("Closing output file...\n");
   fclose(out_file);
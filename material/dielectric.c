@@ -4,7 +4,9 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "core/arena.h"
 #include "core/color.h"
+#include "core/fast_math.h"
 #include "core/interval.h"
 #include "core/ray.h"
 #include "hittable/hit_record.h"
@@ -14,37 +16,61 @@ typedef struct Dielectric {
   // Refractive index in vacuum or air, or the ratio of the material's
   // refractive index over
   // the refractive index of the enclosing media
-  double refraction_index;
+  real refraction_index;
 } Dielectric;
 
-static double schlick_reflectance_approx(double cosine,
-                                         double refraction_index);
+static real schlick_reflectance_approx(real cosine, real refraction_index);
 
 static bool dielectric_scatter(const Material *self, Ray ray_in, HitRecord *rec,
-                               Color *attenuation, Ray *scattered) {
+                               Sampler *sampler, Color *attenuation,
+                               Ray *scattered) {
   assert(self != NULL);
   assert(rec != NULL);
 
   Dielectric *dielectric = self->data;
 
   *attenuation = (Color){1.0, 1.0, 1.0};
-  double ri = rec->front_face ? (1 / dielectric->refraction_index)
+  real ri = rec->front_face ? (1 / dielectric->refraction_index)
                               : dielectric->refraction_index;
   Vec3 unit_direction = vec3_normalized(ray_in.direction);
-  double cos_theta =
+  real cos_theta =
       fmin(vec3_dot(vec3_negate(unit_direction), rec->normal), 1.0);
-  double sin_theta = sqrt(1.0 - cos_theta * cos_theta);
+  real sin_theta = sqrt(1 - cos_theta * cos_theta);
 
-  bool cannot_refract = ri * sin_theta > 1.0;
+  bool cannot_refract = ri * sin_theta > 1;
   Vec3 direction;
 
   if (cannot_refract ||
-      schlick_reflectance_approx(cos_theta, ri) > random_double()) {
+      schlick_reflectance_approx(cos_theta, ri) > sampler_get_1d(sampler)) {
     direction = vec3_reflect(unit_direction, rec->normal);
   } else {
     direction = vec3_refract(unit_direction, rec->normal, ri);
   }
-  *scattered = (Ray){.origin = rec->p, .direction = direction, .time = ray_in.time};
+  *scattered = ray_spawn(rec->p, rec->normal, direction, ray_in.time);
+  return true;
+}
+
+// Reflection and refraction are both perfectly specular.
+static Color dielectric_eval(const Material *self, Ray ray_in,
+                             const HitRecord *rec, Vec3 wi) {
+  (void)self;
+  (void)ray_in;
+  (void)rec;
+  (void)wi;
+  return vec3_zero();
+}
+
+static real dielectric_pdf(const Material *self, Ray ray_in,
+                           const HitRecord *rec, Vec3 wi) {
+  (void)self;
+  (void)ray_in;
+  (void)rec;
+  (void)wi;
+  return 0.0;
+}
+
+static bool dielectric_is_delta(const Material *self) {
+  (void)self;
   return true;
 }
 
@@ -52,15 +78,15 @@ static void dielectric_destroy(void *self) {
   assert(self != NULL);
   Material *mat = (Material *)self;
   if (mat->data)
-    free(mat->data);
-  free(self);
+    rt_free(mat->data);
+  rt_free(self);
 }
 
-Material *dielectric_create(double refractive_index) {
-  Material *mat = malloc(sizeof(struct Material));
+Material *dielectric_create(real refractive_index) {
+  Material *mat = rt_alloc(sizeof(struct Material));
   assert(mat != NULL);
 
-  Dielectric *dielectric = malloc(sizeof(struct Dielectric));
+  Dielectric *dielectric = rt_alloc(sizeof(struct Dielectric));
   assert(dielectric != NULL);
 
   dielectric->refraction_index = refractive_index;
@@ -69,6 +95,9 @@ Material *dielectric_create(double refractive_index) {
   mat->scatter = (ScatterFn)dielectric_scatter;
   mat->destroy = (MaterialDestroyFn)dielectric_destroy;
   mat->emitted = NULL;
+  mat->eval = dielectric_eval;
+  mat->pdf = dielectric_pdf;
+  mat->is_delta = dielectric_is_delta;
   mat->data = dielectric;
 
   return mat;
@@ -85,9 +114,8 @@ void dielectric_print(const Material *self) {
 }
 
 // Use Schlick's approximation for reflectance.
-static double schlick_reflectance_approx(double cosine,
-                                         double refraction_index) {
-  double r0 = (1 - refraction_index) / (1 + refraction_index);
+static real schlick_reflectance_approx(real cosine, real refraction_index) {
+  real r0 = (1 - refraction_index) / (1 + refraction_index);
   r0 = r0 * r0;
-  return r0 + (1 - r0) * pow((1 - cosine), 5);
+  return r0 + (1 - r0) * pow5(1 - cosine);
 }
\ No newline at end of file
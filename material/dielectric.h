@@ -4,7 +4,7 @@
 #include "core/color.h"
 #include "material.h"
 
-extern Material *dielectric_create(double refraction_index);
+extern Material *dielectric_create(real refraction_index);
 extern void dielectric_print(const Material *self);
 
 #endif // DIELECTRIC_H
\ No newline at end of file
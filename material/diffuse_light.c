@@ -1,3 +1,4 @@
+#include "core/arena.h"
 #include "diffuse_light.h"
 #include "texture/solid_color.h"
 #include <assert.h>
@@ -9,10 +10,12 @@ typedef struct DiffuseLight {
 } DiffuseLight;
 
 static bool diffuse_light_scatter(Material *mat, Ray ray_in, HitRecord *rec,
-                                  Color *attenuation, Ray *scattered) {
+                                  Sampler *sampler, Color *attenuation,
+                                  Ray *scattered) {
   (void)mat;
   (void)ray_in;
   (void)rec;
+  (void)sampler;
   (void)attenuation;
   (void)scattered;
   return false;
@@ -22,9 +25,9 @@ static void diffuse_light_destroy(void *self) {
   assert(self != NULL);
   Material *mat = (Material *)self;
   if (mat->data) {
-    free(mat->data);
+    rt_free(mat->data);
   }
-  free(self);
+  rt_free(self);
 }
 
 void diffuse_light_print(const Material *self) {
@@ -36,7 +39,7 @@ void diffuse_light_print(const Material *self) {
   printf("Diffuse Light { texture: %p }\n", (void *)diff_l->tex);
 }
 
-Color diffuse_light_emitted(Material *self, double u, double v, const Vec3 *p) {
+Color diffuse_light_emitted(Material *self, real u, real v, const Vec3 *p) {
   if (!self || self->type != MATERIAL_DIFFUSE_LIGHT) {
     return vec3_zero();
   }
@@ -46,10 +49,10 @@ Color diffuse_light_emitted(Material *self, double u, double v, const Vec3 *p) {
 }
 
 Material *diffuse_light_create_texture(Texture *tex) {
-  Material *mat = malloc(sizeof(struct Material));
+  Material *mat = rt_alloc(sizeof(struct Material));
   assert(mat != NULL);
 
-  DiffuseLight *diff_l = malloc(sizeof(struct DiffuseLight));
+  DiffuseLight *diff_l = rt_alloc(sizeof(struct DiffuseLight));
   assert(diff_l != NULL);
 
   diff_l->tex = tex;
@@ -58,6 +61,9 @@ Material *diffuse_light_create_texture(Texture *tex) {
   mat->scatter = (ScatterFn)diffuse_light_scatter;
   mat->destroy = (MaterialDestroyFn)diffuse_light_destroy;
   mat->emitted = diffuse_light_emitted;
+  mat->eval = NULL;
+  mat->pdf = NULL;
+  mat->is_delta = NULL;
   mat->data = diff_l;
   return mat;
 }
@@ -66,3 +72,8 @@ Material *diffuse_light_create(Color emit_color) {
   SolidColor *sol_col = solid_color_create_albedo(&emit_color);
   return diffuse_light_create_texture((Texture *)sol_col);
 }
+
+Texture **diffuse_light_texture_slot(Material *self) {
+  assert(self != NULL && self->type == MATERIAL_DIFFUSE_LIGHT);
+  return &((DiffuseLight *)self->data)->tex;
+}
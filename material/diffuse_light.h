@@ -7,8 +7,9 @@
 #include "texture/texture.h"
 
 Material* diffuse_light_create(Color emit_color);
-extern Color diffuse_light_emitted(Material *self, double u, double v, const Vec3 *p);
+extern Color diffuse_light_emitted(Material *self, real u, real v, const Vec3 *p);
 extern void diffuse_light_print(const Material *self);
 extern Material *diffuse_light_create_texture(Texture *tex);
+extern Texture **diffuse_light_texture_slot(Material *self);
 
 #endif // DIFFUSE_LIGHT_H
\ No newline at end of file
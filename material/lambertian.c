@@ -4,9 +4,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "core/arena.h"
 #include "core/color.h"
 #include "core/interval.h"
+#include "core/onb.h"
 #include "core/ray.h"
+#include "core/sampling.h"
 #include "hittable/hit_record.h"
 #include "material.h"
 #include "texture/solid_color.h"
@@ -16,35 +19,57 @@ typedef struct Lambertian {
 } Lambertian;
 
 static bool lambertian_scatter(const Material *self, Ray ray_in, HitRecord *rec,
-                               Color *attenuation, Ray *scattered) {
+                               Sampler *sampler, Color *attenuation,
+                               Ray *scattered) {
   assert(self != NULL);
   assert(rec != NULL);
 
   Lambertian *lamb = self->data;
 
-  Vec3 scatter_direction = vec3_add(rec->normal, vec3_random_unit_vector());
-  // Catch degenerate scatter direction
-  if (vec3_is_near_zero(scatter_direction))
-    scatter_direction = rec->normal;
-  *scattered = (Ray){.origin = rec->p, .direction = scatter_direction, .time = ray_in.time};
+  double u1, u2;
+  sampler_get_2d(sampler, &u1, &u2);
+  Onb onb = onb_from_w(rec->normal);
+  Vec3 scatter_direction = onb_local(&onb, sample_cosine_hemisphere(u1, u2));
+  *scattered = ray_spawn(rec->p, rec->normal, scatter_direction, ray_in.time);
   *attenuation = lamb->tex->value(lamb->tex, rec->u, rec->v, &rec->p);
 
   return true;
 }
 
+// Cosine-weighted hemisphere about the normal.
+static real lambertian_pdf(const Material *self, Ray ray_in,
+                           const HitRecord *rec, Vec3 wi) {
+  (void)self;
+  (void)ray_in;
+  real cosine = vec3_dot(rec->normal, wi);
+  return cosine > 0 ? cosine / PI : 0.0;
+}
+
+static Color lambertian_eval(const Material *self, Ray ray_in,
+                             const HitRecord *rec, Vec3 wi) {
+  Lambertian *lamb = self->data;
+  Color albedo = lamb->tex->value(lamb->tex, rec->u, rec->v, &rec->p);
+  return vec3_scale(albedo, lambertian_pdf(self, ray_in, rec, wi));
+}
+
+static bool lambertian_is_delta(const Material *self) {
+  (void)self;
+  return false;
+}
+
 static void lambertian_destroy(void *self) {
   assert(self != NULL);
   Material *mat = (Material *)self;
   if (mat->data)
-    free(mat->data);
-  free(self);
+    rt_free(mat->data);
+  rt_free(self);
 }
 
 Material *lambertian_create_texture(Texture *tex) {
-  Material *mat = malloc(sizeof(struct Material));
+  Material *mat = rt_alloc(sizeof(struct Material));
   assert(mat != NULL);
 
-  Lambertian *lamb = malloc(sizeof(struct Lambertian));
+  Lambertian *lamb = rt_alloc(sizeof(struct Lambertian));
   assert(lamb != NULL);
 
   lamb->tex = tex;
@@ -53,6 +78,9 @@ Material *lambertian_create_texture(Texture *tex) {
   mat->scatter = (ScatterFn)lambertian_scatter;
   mat->destroy = (MaterialDestroyFn)lambertian_destroy;
   mat->emitted = NULL;
+  mat->eval = lambertian_eval;
+  mat->pdf = lambertian_pdf;
+  mat->is_delta = lambertian_is_delta;
   mat->data = lamb;
 
   return mat;
@@ -71,3 +99,8 @@ void lambertian_print(const Material *self) {
   const Lambertian *lamb = (const Lambertian *)self->data;
   printf("Lambertian { texture: %p}\n", (void*)lamb->tex);
 }
+
+Texture **lambertian_texture_slot(Material *self) {
+  assert(self != NULL && self->type == MATERIAL_LAMBERTIAN);
+  return &((Lambertian *)self->data)->tex;
+}
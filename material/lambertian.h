@@ -8,5 +8,6 @@
 extern Material *lambertian_create(Color albedo);
 extern void lambertian_print(const Material *self);
 extern Material *lambertian_create_texture(Texture *tex);
+extern Texture **lambertian_texture_slot(Material *self);
 
 #endif // LAMBERTIAN_H
\ No newline at end of file
@@ -27,9 +27,42 @@ void material_print(const Material *self) {
   }
 }
 
-Color material_emitted(Material *mat, double u, double v, const Vec3 *p) {
+Texture **material_texture_slot(Material *self) {
+  switch (self->type) {
+  case MATERIAL_LAMBERTIAN:
+    return lambertian_texture_slot(self);
+  case MATERIAL_METAL:
+    return metal_texture_slot(self);
+  case MATERIAL_DIFFUSE_LIGHT:
+    return diffuse_light_texture_slot(self);
+  default:
+    return NULL;
+  }
+}
+
+Color material_emitted(Material *mat, real u, real v, const Vec3 *p) {
     if (!mat || !mat->emitted) {
         return vec3_zero(); 
     }
     return mat->emitted(mat, u, v, p);
-}
\ No newline at end of file
+}
+
+Color material_eval(const Material *mat, Ray ray_in, const HitRecord *rec,
+                    Vec3 wi) {
+  if (!mat->eval)
+    return vec3_zero();
+  return mat->eval(mat, ray_in, rec, wi);
+}
+
+real material_pdf(const Material *mat, Ray ray_in, const HitRecord *rec,
+                  Vec3 wi) {
+  if (!mat->pdf)
+    return 0.0;
+  return mat->pdf(mat, ray_in, rec, wi);
+}
+
+bool material_is_delta(const Material *mat) {
+  if (!mat->is_delta)
+    return true;
+  return mat->is_delta(mat);
+}
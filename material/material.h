@@ -5,15 +5,30 @@
 
 #include "core/color.h"
 #include "core/ray.h"
+#include "core/sampler.h"
 #include "hittable/hit_record.h"
 
 typedef struct HitRecord HitRecord;
 typedef struct Material Material;
+typedef struct Texture Texture;
+// Draws its variates from `sampler`, one request per call.
 typedef bool (*ScatterFn)(Material *mat, Ray ray_in, HitRecord *rec,
-                          Color *attenuation, Ray *scattered);
+                          Sampler *sampler, Color *attenuation,
+                          Ray *scattered);
 typedef void (*MaterialDestroyFn)(Material *self);
 typedef void (*MaterialPrintFn)(Material *self);
-typedef Color (*MaterialEmittedFn)(Material *self, double u, double v, const Vec3 *p); 
+typedef Color (*MaterialEmittedFn)(Material *self, real u, real v, const Vec3 *p); 
+// BSDF times |cos| at the hit for light arriving along `ray_in` and leaving
+// along the unit direction `wi`, i.e. the value that `scatter` estimates
+// with attenuation = eval / pdf.
+typedef Color (*MaterialEvalFn)(const Material *self, Ray ray_in,
+                                const HitRecord *rec, Vec3 wi);
+// Solid-angle density with which `scatter` picks the unit direction `wi`.
+typedef real (*MaterialPdfFn)(const Material *self, Ray ray_in,
+                              const HitRecord *rec, Vec3 wi);
+// True if every scattered direction comes from a delta lobe (perfect
+// mirror or glass), for which eval and pdf are zero everywhere.
+typedef bool (*MaterialIsDeltaFn)(const Material *self);
 
 typedef enum { MATERIAL_LAMBERTIAN, MATERIAL_METAL, MATERIAL_DIELECTRIC, MATERIAL_DIFFUSE_LIGHT } MaterialType;
 
@@ -22,11 +37,22 @@ typedef struct Material {
   ScatterFn scatter;
   MaterialDestroyFn destroy;
   MaterialEmittedFn emitted;
+  MaterialEvalFn eval;        // NULL for materials that do not scatter
+  MaterialPdfFn pdf;          // NULL for materials that do not scatter
+  MaterialIsDeltaFn is_delta; // NULL is treated as a delta lobe
   void *data;
 } Material;
 
 extern void material_destroy(Material *self);
 extern void material_print(const Material *self);
-extern Color material_emitted(Material *mat, double u, double v, const Vec3 *p);
+// Address of the material's texture pointer, or NULL for materials without
+// one (dielectric).
+extern Texture **material_texture_slot(Material *self);
+extern Color material_emitted(Material *mat, real u, real v, const Vec3 *p);
+extern Color material_eval(const Material *mat, Ray ray_in,
+                           const HitRecord *rec, Vec3 wi);
+extern real material_pdf(const Material *mat, Ray ray_in,
+                         const HitRecord *rec, Vec3 wi);
+extern bool material_is_delta(const Material *mat);
 
 #endif // MATERIAL_Hss
\ No newline at end of file
@@ -4,9 +4,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "core/arena.h"
 #include "core/color.h"
 #include "core/interval.h"
 #include "core/ray.h"
+#include "core/sampling.h"
 #include "hittable/hit_record.h"
 #include "material.h"
 #include "texture/solid_color.h"
@@ -14,38 +16,81 @@
 
 typedef struct Metal {
   Texture *tex;
-  double fuzz;
+  real fuzz;
 } Metal;
 
 static bool metal_scatter(const Material *self, Ray ray_in, HitRecord *rec,
-                          Color *attenuation, Ray *scattered) {
+                          Sampler *sampler, Color *attenuation,
+                          Ray *scattered) {
   assert(self != NULL);
   assert(rec != NULL);
 
   Metal *metal = self->data;
 
+  double u1, u2;
+  sampler_get_2d(sampler, &u1, &u2);
   Vec3 reflected = vec3_reflect(ray_in.direction, rec->normal);
-  reflected = vec3_add(vec3_normalized(reflected),
-                       vec3_scale(vec3_random_unit_vector(), metal->fuzz));
-  *scattered = (Ray){.origin = rec->p, .direction = reflected, .time = ray_in.time};
+  reflected =
+      vec3_add(vec3_normalized(reflected),
+               vec3_scale(sample_uniform_sphere(u1, u2), metal->fuzz));
+  *scattered = ray_spawn(rec->p, rec->normal, reflected, ray_in.time);
   *attenuation = metal->tex->value(metal->tex, rec->u, rec->v, &rec->p);
 
   return true;
 }
 
+// Scatter picks a point uniformly on the sphere of radius `fuzz` around the
+// mirror direction r. A unit direction w meets that sphere where
+// t^2 - 2t(w.r) + 1 - fuzz^2 = 0, and each root t > 0 adds
+// t^2 / (4 pi fuzz sqrt(disc)) to the solid-angle density.
+static real metal_pdf(const Material *self, Ray ray_in, const HitRecord *rec,
+                      Vec3 wi) {
+  const Metal *metal = self->data;
+  real fuzz = metal->fuzz;
+  if (fuzz <= 0)
+    return 0.0;
+
+  Vec3 mirror = vec3_normalized(vec3_reflect(ray_in.direction, rec->normal));
+  real b = vec3_dot(wi, mirror);
+  real disc = b * b - (1 - fuzz * fuzz);
+  if (disc <= 0)
+    return 0.0;
+
+  real root = sqrt(disc);
+  real pdf = 0.0;
+  for (int i = 0; i < 2; i++) {
+    real t = i == 0 ? b - root : b + root;
+    if (t > 0)
+      pdf += t * t / (4 * PI * fuzz * root);
+  }
+  return pdf;
+}
+
+static Color metal_eval(const Material *self, Ray ray_in, const HitRecord *rec,
+                        Vec3 wi) {
+  Metal *metal = self->data;
+  Color albedo = metal->tex->value(metal->tex, rec->u, rec->v, &rec->p);
+  return vec3_scale(albedo, metal_pdf(self, ray_in, rec, wi));
+}
+
+static bool metal_is_delta(const Material *self) {
+  const Metal *metal = self->data;
+  return metal->fuzz <= 0;
+}
+
 static void metal_destroy(void *self) {
   assert(self != NULL);
   Material *mat = (Material *)self;
   if (mat->data)
-    free(mat->data);
-  free(self);
+    rt_free(mat->data);
+  rt_free(self);
 }
 
-Material *metal_create_texture(Texture* tex, double fuzz) {
-    Material *mat = malloc(sizeof(struct Material));
+Material *metal_create_texture(Texture* tex, real fuzz) {
+    Material *mat = rt_alloc(sizeof(struct Material));
     assert(mat != NULL);
     
-    Metal *metal = malloc(sizeof(struct Metal));
+    Metal *metal = rt_alloc(sizeof(struct Metal));
     assert(metal != NULL);
     
     metal->tex = tex;
@@ -55,11 +100,14 @@ Material *metal_create_texture(Texture* tex, double fuzz) {
     mat->scatter = (ScatterFn)metal_scatter;
     mat->destroy = (MaterialDestroyFn)metal_destroy;
     mat->emitted = NULL;
+    mat->eval = metal_eval;
+    mat->pdf = metal_pdf;
+    mat->is_delta = metal_is_delta;
     mat->data = metal;
     return mat;
 }
 
-Material *metal_create(Color albedo, double fuzz) {
+Material *metal_create(Color albedo, real fuzz) {
     SolidColor *sol_col = solid_color_create_albedo(&albedo);
     return metal_create_texture((Texture*)sol_col, fuzz);
 }
@@ -72,3 +120,8 @@ void metal_print(const Material *self) {
   const Metal *metal = (const Metal *)self->data;
   printf("Metal { texture: %p, fuzz: %.3f }\n", (void*)metal->tex, metal->fuzz);
 }
+
+Texture **metal_texture_slot(Material *self) {
+  assert(self != NULL && self->type == MATERIAL_METAL);
+  return &((Metal *)self->data)->tex;
+}
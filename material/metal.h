@@ -5,8 +5,9 @@
 #include "material.h"
 #include "texture/texture.h"
 
-extern Material *metal_create(Color albedo, double fuzz);
+extern Material *metal_create(Color albedo, real fuzz);
 extern void metal_print(const Material *self);
-extern Material *metal_create_texture(Texture* tex, double fuzz);            // Add this new one
+extern Material *metal_create_texture(Texture* tex, real fuzz);            // Add this new one
+extern Texture **metal_texture_slot(Material *self);
 
 #endif // METAL_H
\ No newline at end of file
@@ -0,0 +1,131 @@
+#include "mesh_cache.h"
+#include "core/mapped_file.h"
+#include "core/vec3.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define MESH_CACHE_PATH_MAX 4096
+
+_Static_assert(sizeof(Vec3) == 3 * sizeof(real),
+               "cached positions are stored as packed Vec3");
+_Static_assert(sizeof(MeshCacheHeader) % sizeof(real) == 0,
+               "positions must start aligned after the header");
+
+// Numbers the temporary files of this process, so that models loaded on
+// several threads never write to the same one
+static atomic_uint temp_serial;
+
+static bool cache_path(const char *source, char *out, size_t size) {
+  int n = snprintf(out, size, "%s%s", source, MESH_CACHE_EXTENSION);
+  return n > 0 && (size_t)n < size;
+}
+
+bool mesh_cache_stat(const char *source, MeshCacheSource *out) {
+  struct stat st;
+  if (stat(source, &st) != 0)
+    return false;
+  memset(out, 0, sizeof(*out));
+  out->size = (uint64_t)st.st_size;
+  out->mtime_sec = (int64_t)st.st_mtim.tv_sec;
+  out->mtime_nsec = (int64_t)st.st_mtim.tv_nsec;
+  return true;
+}
+
+static size_t cache_size(uint64_t vertex_count, uint64_t triangle_count) {
+  return sizeof(MeshCacheHeader) + vertex_count * sizeof(Vec3) +
+         triangle_count * 3 * sizeof(uint32_t);
+}
+
+bool mesh_cache_open(MeshCache *self, const char *source,
+                     const MeshCacheSource *stamp) {
+  memset(self, 0, sizeof(*self));
+  char path[MESH_CACHE_PATH_MAX];
+  if (!cache_path(source, path, sizeof(path)) ||
+      !mapped_file_open(&self->file, path))
+    return false;
+
+  const MeshCacheHeader *header = (const MeshCacheHeader *)self->file.data;
+  if (self->file.size < sizeof(*header) ||
+      memcmp(header->magic, MESH_CACHE_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != MESH_CACHE_VERSION ||
+      header->source.size != stamp->size ||
+      header->source.mtime_sec != stamp->mtime_sec ||
+      header->source.mtime_nsec != stamp->mtime_nsec ||
+      self->file.size !=
+          cache_size(header->vertex_count, header->triangle_count)) {
+    mesh_cache_close(self);
+    return false;
+  }
+
+  self->header = header;
+  self->positions = (const Vec3 *)(header + 1);
+  self->indices = (const uint32_t *)(self->positions + header->vertex_count);
+  for (size_t k = 0; k < (size_t)header->triangle_count * 3; k++) {
+    if (self->indices[k] >= header->vertex_count) {
+      mesh_cache_close(self);
+      return false;
+    }
+  }
+  return true;
+}
+
+void mesh_cache_close(MeshCache *self) {
+  mapped_file_close(&self->file);
+  self->header = NULL;
+  self->positions = NULL;
+  self->indices = NULL;
+}
+
+bool mesh_cache_write(const char *source, const MeshCacheSource *stamp,
+                      const Vec3 *positions, int vertex_count,
+                      const uint32_t *indices, int triangle_count,
+                      int degenerate_faces) {
+  char path[MESH_CACHE_PATH_MAX];
+  char temp_path[MESH_CACHE_PATH_MAX];
+  if (!cache_path(source, path, sizeof(path)))
+    return false;
+  int n = snprintf(temp_path, sizeof(temp_path), "%s.%ld.%u", path,
+                   (long)getpid(), atomic_fetch_add(&temp_serial, 1));
+  if (n < 0 || (size_t)n >= sizeof(temp_path))
+    return false;
+
+  MeshCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+  header.version = MESH_CACHE_VERSION;
+  header.vertex_count = (uint32_t)vertex_count;
+  header.triangle_count = (uint32_t)triangle_count;
+  header.degenerate_faces = (uint32_t)degenerate_faces;
+  header.source = *stamp;
+  if (vertex_count > 0)
+    header.bounds_min = header.bounds_max = positions[0];
+  for (int k = 1; k < vertex_count; k++) {
+    Vec3 p = positions[k];
+    header.bounds_min = (Vec3){fmin(header.bounds_min.x, p.x),
+                               fmin(header.bounds_min.y, p.y),
+                               fmin(header.bounds_min.z, p.z)};
+    header.bounds_max = (Vec3){fmax(header.bounds_max.x, p.x),
+                               fmax(header.bounds_max.y, p.y),
+                               fmax(header.bounds_max.z, p.z)};
+  }
+
+  FILE *file = fopen(temp_path, "wb");
+  if (!file)
+    return false;
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(positions, sizeof(Vec3), (size_t)vertex_count, file) ==
+                (size_t)vertex_count &&
+            fwrite(indices, 3 * sizeof(uint32_t), (size_t)triangle_count,
+                   file) == (size_t)triangle_count;
+  ok = fclose(file) == 0 && ok;
+  if (!ok || rename(temp_path, path) != 0) {
+    remove(temp_path);
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,65 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include "core/mapped_file.h"
+#include "core/vec3.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Binary copy of a parsed OBJ file, written next to it as `<file>.rtmesh`
+// the first time it is loaded. It holds the vertex positions as read (before
+// the obj_model transform), the triangles left after fan triangulation as
+// index triples, and their bounds, so a later load maps it and builds the
+// triangles straight from the mapping instead of parsing text. Data is in
+// the writing machine's byte order; a cache from another machine fails the
+// magic check and is rebuilt.
+#define MESH_CACHE_EXTENSION ".rtmesh"
+#define MESH_CACHE_MAGIC "RTMESH\r\n"
+#define MESH_CACHE_VERSION REAL_FORMAT_VERSION(1)
+
+// Identifies the source file the cache was made from; a cache is only used
+// while the source's size and modification time still match.
+typedef struct MeshCacheSource {
+  uint64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+} MeshCacheSource;
+
+typedef struct MeshCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t vertex_count;
+  uint32_t triangle_count;
+  uint32_t degenerate_faces; // Faces with repeated corners, not stored
+  MeshCacheSource source;
+  Vec3 bounds_min, bounds_max; // Over all positions
+  // Followed by vertex_count Vec3 positions, then triangle_count * 3
+  // uint32_t indices into them
+} MeshCacheHeader;
+
+typedef struct MeshCache {
+  MappedFile file;
+  const MeshCacheHeader *header;
+  const Vec3 *positions;
+  const uint32_t *indices;
+} MeshCache;
+
+// Reads the size and modification time of `source`.
+extern bool mesh_cache_stat(const char *source, MeshCacheSource *out);
+
+// Maps the cache for `source` if there is one, it matches `stamp` and it is
+// well formed (sizes agree, every index is in range). Returns false and
+// leaves `self` empty otherwise.
+extern bool mesh_cache_open(MeshCache *self, const char *source,
+                            const MeshCacheSource *stamp);
+extern void mesh_cache_close(MeshCache *self);
+
+// Writes the cache for `source`, through a temporary file renamed into
+// place so readers never see a partial one. Returns false, leaving no file
+// behind, if it cannot be written (read-only model directory and the like).
+extern bool mesh_cache_write(const char *source, const MeshCacheSource *stamp,
+                             const Vec3 *positions, int vertex_count,
+                             const uint32_t *indices, int triangle_count,
+                             int degenerate_faces);
+
+#endif // MESH_CACHE_H
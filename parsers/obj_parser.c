@@ -1,55 +1,108 @@
 #include "obj_parser.h"
+#include "core/arena.h"
+#include "core/mapped_file.h"
+#include "core/parse_number.h"
+#include "core/transform.h"
 #include "core/vec3.h"
+#include "hittable/bvh_node.h"
+#include "hittable/hittable_list.h"
+#include "hittable/lazy_hittable.h"
+#include "hittable/paged_mesh.h"
 #include "hittable/triangle_mesh.h"
+#include "mesh_cache.h"
+#include "ply_parser.h"
 #include <assert.h>
+#include <errno.h>
+#include <limits.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-#define MAX_LINE_LENGTH 512
-#define INITIAL_VERTEX_CAPACITY 1000
+#define INITIAL_VERTEX_CAPACITY 1024
+// Files are parsed in parallel chunks of at least this size, up to the
+// number of CPUs or OBJ_MAX_CHUNKS
+#define OBJ_MIN_CHUNK_BYTES (1 << 20)
+#define OBJ_MAX_CHUNKS 64
 
-// ===== TRANSFORM FUNCTIONS =====
+// ===== TOKENIZER =====
 
-static Vec3 rotate_x(Vec3 v, double angle) {
-  if (angle == 0.0)
-    return v; // Skip if no rotation
-  double cos_a = cos(angle);
-  double sin_a = sin(angle);
-  return (Vec3){v.x, v.y * cos_a - v.z * sin_a, v.y * sin_a + v.z * cos_a};
+// The scanners below read from `*p` up to `end`, never past it, since the
+// mapped file has no terminating NUL (see core/parse_number.h).
+
+static inline bool is_blank(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
 }
 
-static Vec3 rotate_y(Vec3 v, double angle) {
-  if (angle == 0.0)
-    return v; // Skip if no rotation
-  double cos_a = cos(angle);
-  double sin_a = sin(angle);
-  return (Vec3){v.x * cos_a + v.z * sin_a, v.y, -v.x * sin_a + v.z * cos_a};
+static inline void skip_blanks(const char **p, const char *end) {
+  while (*p < end && is_blank(**p))
+    (*p)++;
 }
 
-static Vec3 rotate_z(Vec3 v, double angle) {
-  if (angle == 0.0)
-    return v; // Skip if no rotation
-  double cos_a = cos(angle);
-  double sin_a = sin(angle);
-  return (Vec3){v.x * cos_a - v.y * sin_a, v.x * sin_a + v.y * cos_a, v.z};
+// Moves to the first character of the next line.
+static inline void skip_line(const char **p, const char *end) {
+  const char *newline = memchr(*p, '\n', (size_t)(end - *p));
+  *p = newline ? newline + 1 : end;
 }
 
-static void apply_transforms(Vec3 *vertex, Vec3 scale, Vec3 position,
-                             Vec3 rotation) {
-  // 1. Scale first
-  vertex->x *= scale.x;
-  vertex->y *= scale.y;
-  vertex->z *= scale.z;
+static inline bool at_line_end(const char *p, const char *end) {
+  return p == end || *p == '\n' || *p == '#';
+}
 
-  // 2. Rotate (X, Y, Z order)
-  *vertex = rotate_x(*vertex, rotation.x);
-  *vertex = rotate_y(*vertex, rotation.y);
-  *vertex = rotate_z(*vertex, rotation.z);
+// Reads three coordinates.
+static bool parse_vertex_fields(const char **p, const char *end, Vec3 *v) {
+  double x, y, z;
+  skip_blanks(p, end);
+  if (!parse_double(p, end, &x))
+    return false;
+  skip_blanks(p, end);
+  if (!parse_double(p, end, &y))
+    return false;
+  skip_blanks(p, end);
+  if (!parse_double(p, end, &z))
+    return false;
+  *v = (Vec3){x, y, z};
+  return true;
+}
 
-  // 3. Set absolute position (not translate)
-  *vertex = vec3_add(*vertex, position);
+// Reads one face corner, `v`, `v/vt`, `v//vn` or `v/vt/vn`, and returns
+// its position index as written (1-based, or negative if relative).
+static bool parse_face_corner(const char **p, const char *end, long *index) {
+  if (!parse_int(p, end, index))
+    return false;
+  for (int field = 0; field < 2 && *p < end && **p == '/'; field++) {
+    (*p)++;
+    long ignored;
+    parse_int(p, end, &ignored); // Texture or normal index, may be empty
+  }
+  return *p == end || is_blank(**p) || **p == '\n' || **p == '#';
+}
+
+// Turns an index as written into a 0-based one, or -1 if out of range.
+static inline long resolve_index(long index, int vertex_count) {
+  long resolved = index > 0 ? index - 1 : vertex_count + index;
+  return index != 0 && resolved >= 0 && resolved < vertex_count ? resolved
+                                                                 : -1;
+}
+
+// ===== TRANSFORM =====
+
+// The per-vertex transform: scale, then rotate about X, Y and Z (angles in
+// radians), then move to `position`, folded into one matrix.
+static Transform obj_transform(Vec3 scale, Vec3 position, Vec3 rotation) {
+  Transform xf = transform_scale(scale);
+  Transform rx = transform_rotation_x(rotation.x * 180.0 / PI);
+  Transform ry = transform_rotation_y(rotation.y * 180.0 / PI);
+  Transform rz = transform_rotation_z(rotation.z * 180.0 / PI);
+  Transform move = transform_translation(position);
+  xf = transform_compose(&rx, &xf);
+  xf = transform_compose(&ry, &xf);
+  xf = transform_compose(&rz, &xf);
+  return transform_compose(&move, &xf);
 }
 
 // ===== PARSING FUNCTIONS =====
@@ -59,83 +112,401 @@ bool obj_parse_vertex(const char *line, Vec3 *vertex) {
     return false;
   }
 
-  int result =
-      sscanf(line + 2, "%lf %lf %lf", &vertex->x, &vertex->y, &vertex->z);
-  return result == 3;
+  const char *p = line + 2;
+  return parse_vertex_fields(&p, line + strlen(line), vertex);
 }
 
-// Updated function signature to handle both triangles and quads
 bool obj_parse_face(const char *line, int *v1, int *v2, int *v3, int *v4,
                     bool *is_quad) {
   if (line[0] != 'f' || line[1] != ' ') {
     return false;
   }
 
-  int dummy;
-  *is_quad = false;
-
-  // Initialize all vertices to invalid values
+  const char *p = line + 2;
+  const char *end = line + strlen(line);
+  int *corners[4] = {v1, v2, v3, v4};
+  int count = 0;
   *v1 = *v2 = *v3 = *v4 = -1;
+  for (;;) {
+    skip_blanks(&p, end);
+    if (at_line_end(p, end))
+      break;
+    long index;
+    if (count == 4 || !parse_face_corner(&p, end, &index))
+      return false;
+    *corners[count++] = (int)index;
+  }
+  *is_quad = count == 4;
+  return count >= 3;
+}
 
-  // Try quad formats first
-  int result = sscanf(line + 2, "%d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d", v1,
-                      &dummy, &dummy, v2, &dummy, &dummy, v3, &dummy, &dummy,
-                      v4, &dummy, &dummy);
-  if (result == 12) {
-    *is_quad = true;
-    return true;
+// ===== CHUNKED PARSING =====
+
+// The file is split into line-aligned chunks parsed on separate threads.
+// A chunk cannot resolve face indices itself, since relative ones depend on
+// how many vertices came before it, so it only records what it read; the
+// merge below then walks the chunks in file order, resolving indices
+// exactly as a single pass would, errors included.
+typedef struct ObjChunk {
+  const char *begin;
+  const char *end;
+
+  Vec3 *vertices; // As read, in file order
+  int vertex_count;
+  int vertex_capacity;
+
+  // Faces as a stream of ints: line, vertices read so far in this chunk,
+  // corner count, then the corner indices as written
+  int *faces;
+  size_t face_length;
+  size_t face_capacity;
+
+  int line_count;
+  const char *error; // First syntax error, at error_line, or NULL
+  int error_line;
+} ObjChunk;
+
+// A parsed file: positions as read and the triangles of its faces, in the
+// same form the mesh cache stores.
+typedef struct ObjMesh {
+  Vec3 *vertices;
+  int vertex_count;
+  uint32_t *indices; // Three per triangle
+  int triangle_count;
+  int triangle_capacity;
+  int degenerate_faces;
+} ObjMesh;
+
+static void chunk_push(ObjChunk *chunk, int value) {
+  if (chunk->face_length == chunk->face_capacity) {
+    chunk->face_capacity = chunk->face_capacity ? chunk->face_capacity * 2
+                                                : INITIAL_VERTEX_CAPACITY;
+    chunk->faces =
+        realloc(chunk->faces, chunk->face_capacity * sizeof(chunk->faces[0]));
+    assert(chunk->faces != NULL);
   }
+  chunk->faces[chunk->face_length++] = value;
+}
 
-  result = sscanf(line + 2, "%d//%d %d//%d %d//%d %d//%d", v1, &dummy, v2,
-                  &dummy, v3, &dummy, v4, &dummy);
-  if (result == 8) {
-    *is_quad = true;
-    return true;
+static void chunk_fail(ObjChunk *chunk, int line, const char *what) {
+  chunk->error = what;
+  chunk->error_line = line;
+}
+
+// Reads one face after its `f`. A face cut short by bad input is still
+// recorded with the corners read so far, because a single pass would have
+// added their triangles before stopping.
+static bool chunk_parse_face(ObjChunk *chunk, const char **p, int line) {
+  chunk_push(chunk, line);
+  chunk_push(chunk, chunk->vertex_count);
+  size_t count_at = chunk->face_length;
+  chunk_push(chunk, 0);
+  int corners = 0;
+  for (;;) {
+    skip_blanks(p, chunk->end);
+    if (at_line_end(*p, chunk->end))
+      break;
+    long index;
+    if (!parse_face_corner(p, chunk->end, &index)) {
+      chunk_fail(chunk, line, "Invalid face format");
+      break;
+    }
+    chunk_push(chunk, (int)index);
+    corners++;
   }
+  chunk->faces[count_at] = corners;
+  if (!chunk->error && corners < 3)
+    chunk_fail(chunk, line, "Face with fewer than 3 vertices");
+  return chunk->error == NULL;
+}
 
-  result = sscanf(line + 2, "%d/%d %d/%d %d/%d %d/%d", v1, &dummy, v2, &dummy,
-                  v3, &dummy, v4, &dummy);
-  if (result == 8) {
-    *is_quad = true;
-    return true;
+static void *chunk_parse(void *arg) {
+  ObjChunk *chunk = arg;
+  const char *p = chunk->begin;
+  const char *end = chunk->end;
+  while (p < end) {
+    int line = ++chunk->line_count;
+    skip_blanks(&p, end);
+
+    // Vertex: v x y z
+    if (end - p > 1 && p[0] == 'v' && is_blank(p[1])) {
+      p++;
+      Vec3 vertex;
+      if (!parse_vertex_fields(&p, end, &vertex)) {
+        chunk_fail(chunk, line, "Invalid vertex format");
+        break;
+      }
+      if (chunk->vertex_count == chunk->vertex_capacity) {
+        chunk->vertex_capacity *= 2;
+        size_t bytes = (size_t)chunk->vertex_capacity * sizeof(Vec3);
+        chunk->vertices = realloc(chunk->vertices, bytes);
+        assert(chunk->vertices != NULL);
+      }
+      chunk->vertices[chunk->vertex_count++] = vertex;
+    }
+    // Face: f followed by three or more corners
+    else if (end - p > 1 && p[0] == 'f' && is_blank(p[1])) {
+      p++;
+      if (!chunk_parse_face(chunk, &p, line))
+        break;
+    }
+    // Ignore other line types (vt, vn, comments, groups, etc.)
+    skip_line(&p, end);
   }
+  return NULL;
+}
 
-  // Try simple quad format
-  result = sscanf(line + 2, "%d %d %d %d", v1, v2, v3, v4);
-  if (result == 4) {
-    *is_quad = true;
-    return true;
+// Threads parsing OBJ text in all loads together, the calling threads
+// included. Models load on a thread pool with a worker per CPU (see
+// parse_scene), so a parse only starts chunk threads for CPUs no other parse
+// holds: one large model gets them all, while models loading side by side
+// each parse on their own worker rather than each starting a thread per CPU.
+static atomic_int obj_parse_threads;
+
+// One chunk per online CPU not already parsing, but none smaller than
+// OBJ_MIN_CHUNK_BYTES, so ordinary models are still read on the calling
+// thread. The chunks are counted in obj_parse_threads until
+// obj_release_chunks.
+static int obj_reserve_chunks(size_t size) {
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t by_size = size / OBJ_MIN_CHUNK_BYTES;
+  long wanted = cpus < (long)by_size ? cpus : (long)by_size;
+  if (wanted > OBJ_MAX_CHUNKS)
+    wanted = OBJ_MAX_CHUNKS;
+
+  int busy = atomic_load(&obj_parse_threads);
+  int count;
+  do {
+    long idle = cpus - busy;
+    count = wanted < idle ? (int)wanted : (int)idle;
+    if (count < 1)
+      count = 1;
+  } while (!atomic_compare_exchange_weak(&obj_parse_threads, &busy,
+                                         busy + count));
+  return count;
+}
+
+static void obj_release_chunks(int count) {
+  atomic_fetch_sub(&obj_parse_threads, count);
+}
+
+// Splits [data, data + size) into `count` chunks, each ending just after a
+// newline (or at the end of the file). Chunks may come out empty.
+static void obj_split_chunks(ObjChunk *chunks, int count, const char *data,
+                             size_t size) {
+  const char *end = data + size;
+  const char *begin = data;
+  for (int k = 0; k < count; k++) {
+    const char *split = k == count - 1 ? end : data + size / count * (k + 1);
+    if (split < begin)
+      split = begin;
+    if (split < end && split > data && split[-1] != '\n')
+      skip_line(&split, end);
+    chunks[k].begin = begin;
+    chunks[k].end = split;
+    begin = split;
   }
+}
 
-  // Reset v4 for triangle parsing (important!)
-  *v4 = -1;
+static void mesh_push_triangle(ObjMesh *mesh, long a, long b, long c) {
+  if (mesh->triangle_count == mesh->triangle_capacity) {
+    mesh->triangle_capacity = mesh->triangle_capacity
+                                  ? mesh->triangle_capacity * 2
+                                  : INITIAL_VERTEX_CAPACITY;
+    size_t bytes = (size_t)mesh->triangle_capacity * 3 * sizeof(uint32_t);
+    mesh->indices = realloc(mesh->indices, bytes);
+    assert(mesh->indices != NULL);
+  }
+  uint32_t *t = &mesh->indices[(size_t)mesh->triangle_count++ * 3];
+  t[0] = (uint32_t)a;
+  t[1] = (uint32_t)b;
+  t[2] = (uint32_t)c;
+}
 
-  // Try triangle formats
-  result = sscanf(line + 2, "%d/%d/%d %d/%d/%d %d/%d/%d", v1, &dummy, &dummy,
-                  v2, &dummy, &dummy, v3, &dummy, &dummy);
-  if (result == 9) {
-    return true;
+static ObjParseResult obj_fail(ObjParseResult result, int line_number,
+                               const char *what) {
+  result.success = false;
+  snprintf(result.error_message, sizeof(result.error_message), "%s at line %d",
+           what, line_number);
+  printf("ERROR: %s\n", result.error_message);
+  return result;
+}
+
+// Resolves and fan-triangulates the faces of every chunk in file order.
+// On failure `mesh` keeps the triangles before the error.
+static ObjParseResult obj_merge_chunks(const ObjChunk *chunks, int chunk_count,
+                                       ObjMesh *mesh) {
+  ObjParseResult result = {0};
+  int vertex_base = 0;
+  int line_base = 0;
+  for (int k = 0; k < chunk_count; k++) {
+    const ObjChunk *chunk = &chunks[k];
+    size_t at = 0;
+    while (at < chunk->face_length) {
+      int line = line_base + chunk->faces[at];
+      int vertex_count = vertex_base + chunk->faces[at + 1];
+      int corners = chunk->faces[at + 2];
+      const int *indices = &chunk->faces[at + 3];
+      at += 3 + (size_t)corners;
+
+      long first = -1, previous = -1;
+      for (int c = 0; c < corners; c++) {
+        long current = resolve_index(indices[c], vertex_count);
+        if (current < 0) {
+          char message[96];
+          snprintf(message, sizeof(message),
+                   "Invalid face vertex index %d (vertex_count=%d)", indices[c],
+                   vertex_count);
+          result.vertex_count = vertex_count;
+          return obj_fail(result, line, message);
+        }
+        if (c == 0) {
+          first = current;
+        } else if (c >= 2) {
+          if (first == previous || first == current || previous == current)
+            mesh->degenerate_faces++;
+          else
+            mesh_push_triangle(mesh, first, previous, current);
+        }
+        previous = current;
+      }
+    }
+    vertex_base += chunk->vertex_count;
+    if (chunk->error) {
+      result.vertex_count = vertex_base;
+      return obj_fail(result, line_base + chunk->error_line, chunk->error);
+    }
+    line_base += chunk->line_count;
+  }
+  result.vertex_count = vertex_base;
+  result.success = true;
+  return result;
+}
+
+// Parses the text of an OBJ file into `mesh`, which the caller frees.
+static ObjParseResult obj_parse_text(const MappedFile *file, ObjMesh *mesh,
+                                     int *chunks_used) {
+  int chunk_count = obj_reserve_chunks(file->size);
+  ObjChunk chunks[OBJ_MAX_CHUNKS];
+  memset(chunks, 0, sizeof(chunks));
+  obj_split_chunks(chunks, chunk_count, file->data, file->size);
+  for (int k = 0; k < chunk_count; k++) {
+    chunks[k].vertex_capacity = INITIAL_VERTEX_CAPACITY;
+    chunks[k].vertices = malloc(INITIAL_VERTEX_CAPACITY * sizeof(Vec3));
+    assert(chunks[k].vertices != NULL);
   }
 
-  result = sscanf(line + 2, "%d//%d %d//%d %d//%d", v1, &dummy, v2, &dummy, v3,
-                  &dummy);
-  if (result == 6) {
-    return true;
+  // The first chunk is parsed here while the others run; a chunk whose
+  // thread cannot be started is parsed here too
+  pthread_t threads[OBJ_MAX_CHUNKS];
+  bool started[OBJ_MAX_CHUNKS] = {false};
+  for (int k = 1; k < chunk_count; k++)
+    started[k] =
+        pthread_create(&threads[k], NULL, chunk_parse, &chunks[k]) == 0;
+  chunk_parse(&chunks[0]);
+  for (int k = 1; k < chunk_count; k++) {
+    if (started[k])
+      pthread_join(threads[k], NULL);
+    else
+      chunk_parse(&chunks[k]);
+  }
+  obj_release_chunks(chunk_count);
+
+  // Gather the vertices into one array, taking over the first chunk's if
+  // there is only one
+  if (chunk_count == 1) {
+    mesh->vertices = chunks[0].vertices;
+    chunks[0].vertices = NULL;
+  } else {
+    size_t total = 0;
+    for (int k = 0; k < chunk_count; k++)
+      total += (size_t)chunks[k].vertex_count;
+    mesh->vertices = malloc((total ? total : 1) * sizeof(Vec3));
+    assert(mesh->vertices != NULL);
+    size_t at = 0;
+    for (int k = 0; k < chunk_count; k++) {
+      memcpy(mesh->vertices + at, chunks[k].vertices,
+             (size_t)chunks[k].vertex_count * sizeof(Vec3));
+      at += (size_t)chunks[k].vertex_count;
+    }
   }
 
-  result =
-      sscanf(line + 2, "%d/%d %d/%d %d/%d", v1, &dummy, v2, &dummy, v3, &dummy);
-  if (result == 6) {
-    return true;
+  ObjParseResult result = obj_merge_chunks(chunks, chunk_count, mesh);
+  mesh->vertex_count = result.vertex_count;
+  for (int k = 0; k < chunk_count; k++) {
+    free(chunks[k].vertices);
+    free(chunks[k].faces);
   }
+  *chunks_used = chunk_count;
+  return result;
+}
+
+// Parses `file` into `mesh` as binary PLY if `filename` says it is one,
+// else as OBJ text.
+static ObjParseResult obj_parse_mesh(const char *filename,
+                                     const MappedFile *file, ObjMesh *mesh,
+                                     int *chunks_used) {
+  if (!ply_is_ply(filename))
+    return obj_parse_text(file, mesh, chunks_used);
 
-  result = sscanf(line + 2, "%d %d %d", v1, v2, v3);
-  if (result == 3) {
-    return true;
+  ObjParseResult result = {0};
+  PlyMesh ply;
+  *chunks_used = 1;
+  if (!ply_parse(file, &ply, true, result.error_message,
+                 sizeof(result.error_message))) {
+    printf("ERROR: %s\n", result.error_message);
+    return result;
   }
+  mesh->vertices = ply.vertices;
+  mesh->vertex_count = ply.vertex_count;
+  mesh->indices = ply.indices;
+  mesh->triangle_count = ply.triangle_count;
+  mesh->triangle_capacity = ply.triangle_count;
+  mesh->degenerate_faces = ply.degenerate_faces;
+  result.vertex_count = ply.vertex_count;
+  result.success = true;
+  return result;
+}
 
-  return false;
+// ===== TRIANGLES =====
+
+static inline bool triangle_has_area(Vec3 a, Vec3 b, Vec3 c) {
+  Vec3 normal = vec3_cross(vec3_sub(b, a), vec3_sub(c, a));
+  return vec3_length(normal) * 0.5 >= 1e-10;
+}
+
+// Adds triangle (a, b, c) unless it has no area. Returns true if added.
+static bool add_triangle(MeshLoader *loader, Hittable *hittable_list, Vec3 a,
+                         Vec3 b, Vec3 c) {
+  if (!triangle_has_area(a, b, c))
+    return false;
+  mesh_loader_add_triangle(loader, hittable_list, a, b, c);
+  return true;
 }
+
+// Transforms `positions` and adds the indexed triangles, whether they came
+// from the text or straight from a mapped cache. Returns how many were added.
+static int obj_add_triangles(MeshLoader *loader, Hittable *hittable_list,
+                             const Transform *xf, const Vec3 *positions,
+                             int vertex_count, const uint32_t *indices,
+                             int triangle_count) {
+  Vec3 *vertices = malloc((size_t)(vertex_count ? vertex_count : 1) *
+                          sizeof(Vec3));
+  assert(vertices != NULL);
+  for (int k = 0; k < vertex_count; k++)
+    vertices[k] = transform_point(xf, positions[k]);
+
+  int added = 0;
+  for (int k = 0; k < triangle_count; k++) {
+    const uint32_t *t = &indices[(size_t)k * 3];
+    if (add_triangle(loader, hittable_list, vertices[t[0]], vertices[t[1]],
+                     vertices[t[2]]))
+      added++;
+  }
+  free(vertices);
+  return added;
+}
+
 ObjParseResult obj_parse_file_to_hittables(const char *filename,
                                            MeshLoader *loader,
                                            Hittable *hittable_list, Vec3 scale,
@@ -155,12 +526,11 @@ ObjParseResult obj_parse_file_to_hittables(const char *filename,
     return result;
   }
 
-  // Try to open the file
-  FILE *file = fopen(filename, "r");
-  if (!file) {
+  MeshCacheSource stamp;
+  if (!mesh_cache_stat(filename, &stamp)) {
     result.success = false;
     snprintf(result.error_message, sizeof(result.error_message),
-             "Could not open file: %s", filename);
+             "Could not open file: %s (%s)", filename, strerror(errno));
     return result;
   }
 
@@ -169,202 +539,62 @@ ObjParseResult obj_parse_file_to_hittables(const char *filename,
       (scale.x != 1.0 || scale.y != 1.0 || scale.z != 1.0 ||
        position.x != 0.0 || position.y != 0.0 || position.z != 0.0 ||
        rotation.x != 0.0 || rotation.y != 0.0 || rotation.z != 0.0);
-
-  printf("Parsing OBJ file: %s", filename);
-  if (has_transforms) {
-    printf(" (with transforms)");
-  }
-  printf("\n");
-
-  // Create vertex storage using DynArray
-  DynArray *vertices = dynarray_create(100, NULL, (GDestroyFn)free);
-  char line[MAX_LINE_LENGTH];
-  int line_number = 0;
-
-  // Read file line by line
-  while (fgets(line, sizeof(line), file)) {
-    line_number++;
-
-    // Remove newline character
-    line[strcspn(line, "\n")] = '\0';
-
-    // Skip empty lines and comments
-    if (line[0] == '\0' || line[0] == '#') {
-      continue;
+  Transform xf = obj_transform(scale, position, rotation);
+
+  int degenerate_faces = 0;
+  int chunk_count = 0;
+  MeshCache cache;
+  if (mesh_cache_open(&cache, filename, &stamp)) {
+    printf("Loading OBJ file: %s from its mesh cache%s\n", filename,
+           has_transforms ? " (with transforms)" : "");
+
+    const MeshCacheHeader *header = cache.header;
+    result.vertex_count = (int)header->vertex_count;
+    degenerate_faces = (int)header->degenerate_faces;
+    result.face_count = obj_add_triangles(
+        loader, hittable_list, &xf, cache.positions, result.vertex_count,
+        cache.indices, (int)header->triangle_count);
+    mesh_cache_close(&cache);
+  } else {
+    MappedFile file;
+    if (!mapped_file_open(&file, filename)) {
+      result.success = false;
+      snprintf(result.error_message, sizeof(result.error_message),
+               "Could not open file: %s (%s)", filename, strerror(errno));
+      return result;
     }
 
-    // Parse vertex lines (v x y z)
-    if (line[0] == 'v' && line[1] == ' ') {
-      Vec3 *vertex = malloc(sizeof(Vec3));
-      assert(vertex != NULL);
-
-      if (obj_parse_vertex(line, vertex)) {
-        // Apply transforms
-        apply_transforms(vertex, scale, position, rotation);
-
-        // Add to dynamic array
-        dynarray_push(vertices, vertex);
-        result.vertex_count++;
-
-        // Debug output for first few vertices
-        static int debug_count = 0;
-        if (debug_count < 3) {
-          printf("  Vertex %d: (%.3f, %.3f, %.3f)\n", debug_count + 1,
-                 vertex->x, vertex->y, vertex->z);
-          debug_count++;
-        }
-      } else {
-        free(vertex);
-        result.success = false;
-        snprintf(result.error_message, sizeof(result.error_message),
-                 "Invalid vertex format at line %d", line_number);
-        dynarray_destroy(vertices);
-        fclose(file);
-        return result;
-      }
+    // Binary PLY is read about as fast as a mesh cache, so it gets none
+    bool is_ply = ply_is_ply(filename);
+    printf("%s file: %s%s\n", is_ply ? "Reading PLY" : "Parsing OBJ",
+           filename, has_transforms ? " (with transforms)" : "");
+
+    ObjMesh mesh = {0};
+    result = obj_parse_mesh(filename, &file, &mesh, &chunk_count);
+    mapped_file_close(&file);
+    // Triangles before an error are still added, as they always were
+    if (result.success && !is_ply && mesh.vertex_count > 0 &&
+        mesh.triangle_count > 0 &&
+        !mesh_cache_write(filename, &stamp, mesh.vertices, mesh.vertex_count,
+                          mesh.indices, mesh.triangle_count,
+                          mesh.degenerate_faces)) {
+      printf("WARNING: Could not write mesh cache for %s\n", filename);
     }
-    // Parse face lines (f v1 v2 v3 or f v1 v2 v3 v4)
-    else if (line[0] == 'f' && line[1] == ' ') {
-      int v1, v2, v3, v4;
-      bool is_quad;
-
-      if (obj_parse_face(line, &v1, &v2, &v3, &v4, &is_quad)) {
-        // OBJ files use 1-based indexing, convert to 0-based
-        v1--;
-        v2--;
-        v3--;
-        if (is_quad) {
-          v4--;
-        }
-
-        // Validate indices more thoroughly
-        int vertex_count = dynarray_size(vertices);
-
-        // Check basic triangle indices
-        if (v1 < 0 || v1 >= vertex_count || v2 < 0 || v2 >= vertex_count ||
-            v3 < 0 || v3 >= vertex_count) {
-          result.success = false;
-          snprintf(result.error_message, sizeof(result.error_message),
-                   "Invalid triangle vertex indices at line %d: v1=%d v2=%d "
-                   "v3=%d (vertex_count=%d)",
-                   line_number, v1, v2, v3, vertex_count);
-          printf("ERROR: %s\n", result.error_message);
-          dynarray_destroy(vertices);
-          fclose(file);
-          return result;
-        }
-
-        // Check quad fourth vertex if needed
-        if (is_quad && (v4 < 0 || v4 >= vertex_count)) {
-          result.success = false;
-          snprintf(
-              result.error_message, sizeof(result.error_message),
-              "Invalid quad vertex index at line %d: v4=%d (vertex_count=%d)",
-              line_number, v4, vertex_count);
-          printf("ERROR: %s\n", result.error_message);
-          dynarray_destroy(vertices);
-          fclose(file);
-          return result;
-        }
-
-        // Check for duplicate vertices (degenerate faces)
-        if (v1 == v2 || v1 == v3 || v2 == v3) {
-          printf("WARNING: Degenerate triangle at line %d: v1=%d v2=%d v3=%d\n",
-                 line_number, v1, v2, v3);
-          continue; // Skip this face
-        }
-
-        if (is_quad && (v1 == v4 || v2 == v4 || v3 == v4)) {
-          printf(
-              "WARNING: Degenerate quad at line %d: v1=%d v2=%d v3=%d v4=%d\n",
-              line_number, v1, v2, v3, v4);
-          continue; // Skip this face
-        }
-
-        // Get vertices safely
-        Vec3 vert1, vert2, vert3, vert4;
-
-        Vec3 *v1_ptr = (Vec3 *)dynarray_get(vertices, v1);
-        Vec3 *v2_ptr = (Vec3 *)dynarray_get(vertices, v2);
-        Vec3 *v3_ptr = (Vec3 *)dynarray_get(vertices, v3);
-
-        if (!v1_ptr || !v2_ptr || !v3_ptr) {
-          result.success = false;
-          snprintf(result.error_message, sizeof(result.error_message),
-                   "Null vertex pointer at line %d", line_number);
-          dynarray_destroy(vertices);
-          fclose(file);
-          return result;
-        }
-
-        vert1 = *v1_ptr;
-        vert2 = *v2_ptr;
-        vert3 = *v3_ptr;
-
-        if (is_quad) {
-          Vec3 *v4_ptr = (Vec3 *)dynarray_get(vertices, v4);
-          if (!v4_ptr) {
-            result.success = false;
-            snprintf(result.error_message, sizeof(result.error_message),
-                     "Null vertex pointer for v4 at line %d", line_number);
-            dynarray_destroy(vertices);
-            fclose(file);
-            return result;
-          }
-          vert4 = *v4_ptr;
-
-          // Check for degenerate triangles before creating them
-          Vec3 edge1 = vec3_sub(vert2, vert1);
-          Vec3 edge2 = vec3_sub(vert3, vert1);
-          Vec3 normal1 = vec3_cross(edge1, edge2);
-          double area1 = vec3_length(normal1) * 0.5;
-
-          Vec3 edge3 = vec3_sub(vert3, vert1);
-          Vec3 edge4 = vec3_sub(vert4, vert1);
-          Vec3 normal2 = vec3_cross(edge3, edge4);
-          double area2 = vec3_length(normal2) * 0.5;
-
-          if (area1 >= 1e-10) {
-            mesh_loader_add_triangle(loader, hittable_list, vert1, vert2,
-                                     vert3);
-            result.face_count++;
-          }
-
-          if (area2 >= 1e-10) {
-            mesh_loader_add_triangle(loader, hittable_list, vert1, vert3,
-                                     vert4);
-            result.face_count++;
-          }
-        } else {
-          // Single triangle - check for degeneracy
-          Vec3 edge1 = vec3_sub(vert2, vert1);
-          Vec3 edge2 = vec3_sub(vert3, vert1);
-          Vec3 normal = vec3_cross(edge1, edge2);
-          double area = vec3_length(normal) * 0.5;
-
-          if (area >= 1e-10) {
-            mesh_loader_add_triangle(loader, hittable_list, vert1, vert2,
-                                     vert3);
-            result.face_count++;
-          }
-        }
-      } else {
-        result.success = false;
-        snprintf(result.error_message, sizeof(result.error_message),
-                 "Invalid face format at line %d: '%s'", line_number, line);
-        dynarray_destroy(vertices);
-        fclose(file);
-        return result;
-      }
-    }
-    // Ignore other line types (vt, vn, etc.)
+    result.face_count =
+        obj_add_triangles(loader, hittable_list, &xf, mesh.vertices,
+                          mesh.vertex_count, mesh.indices, mesh.triangle_count);
+    degenerate_faces = mesh.degenerate_faces;
+    free(mesh.vertices);
+    free(mesh.indices);
+    if (!result.success)
+      return result;
   }
 
-  // Cleanup
-  dynarray_destroy(vertices);
-  fclose(file);
+  if (degenerate_faces > 0) {
+    printf("WARNING: Skipped %d degenerate triangles with repeated vertices\n",
+           degenerate_faces);
+  }
 
-  // MOVED THESE CHECKS OUTSIDE THE LOOP!
   if (result.vertex_count == 0) {
     result.success = false;
     strcpy(result.error_message, "No vertices found in OBJ file");
@@ -380,9 +610,15 @@ ObjParseResult obj_parse_file_to_hittables(const char *filename,
   }
 
   result.success = true;
-  printf("=== Successfully loaded OBJ file! ===\n");
+  // Models load in parallel (see parse_scene); keep the summary together
+  flockfile(stdout);
+  printf("=== Successfully loaded %s file! ===\n",
+         ply_is_ply(filename) ? "PLY" : "OBJ");
   printf("  Vertices: %d\n", result.vertex_count);
   printf("  Faces: %d\n", result.face_count);
+  if (chunk_count > 1) {
+    printf("  Parsed in %d chunks\n", chunk_count);
+  }
   if (has_transforms) {
     printf("  Applied transforms: scale(%.1f,%.1f,%.1f) pos(%.1f,%.1f,%.1f) "
            "rot(%.0f°,%.0f°,%.0f°)\n",
@@ -391,6 +627,253 @@ ObjParseResult obj_parse_file_to_hittables(const char *filename,
            rotation.z * 180.0 / PI);
   }
   printf("=====================================\n");
+  funlockfile(stdout);
 
   return result;
-}
\ No newline at end of file
+}
+
+// ===== LAZY MODELS =====
+
+// Matches the padding of triangle bounds, so the proxy encloses them
+#define OBJ_LAZY_BOUNDS_PADDING 0.001
+
+typedef struct ObjLazyModel {
+  char *filename;
+  Material *material;
+  Vec3 scale, position, rotation;
+} ObjLazyModel;
+
+static void bounds_add(Vec3 *lo, Vec3 *hi, bool *any, Vec3 p) {
+  if (!*any) {
+    *lo = *hi = p;
+    *any = true;
+    return;
+  }
+  *lo = (Vec3){fmin(lo->x, p.x), fmin(lo->y, p.y), fmin(lo->z, p.z)};
+  *hi = (Vec3){fmax(hi->x, p.x), fmax(hi->y, p.y), fmax(hi->z, p.z)};
+}
+
+// Bounds of the model's vertices after `xf`. A valid mesh cache gives them
+// from its header (the box of the transformed corners, which may be looser);
+// otherwise only the `v` lines, or the vertices of a PLY file, are read.
+static bool obj_model_bounds(const char *filename, const Transform *xf,
+                             AABB *out) {
+  Vec3 lo = {0, 0, 0}, hi = {0, 0, 0};
+  bool any = false;
+
+  MeshCacheSource stamp;
+  MeshCache cache;
+  if (!mesh_cache_stat(filename, &stamp))
+    return false;
+  if (mesh_cache_open(&cache, filename, &stamp)) {
+    Vec3 c0 = cache.header->bounds_min, c1 = cache.header->bounds_max;
+    for (int k = 0; k < 8 && cache.header->vertex_count > 0; k++) {
+      Vec3 corner = {k & 1 ? c1.x : c0.x, k & 2 ? c1.y : c0.y,
+                     k & 4 ? c1.z : c0.z};
+      bounds_add(&lo, &hi, &any, transform_point(xf, corner));
+    }
+    mesh_cache_close(&cache);
+  } else {
+    MappedFile file;
+    if (!mapped_file_open(&file, filename))
+      return false;
+    PlyMesh ply;
+    char error[256];
+    if (!ply_is_ply(filename)) {
+      const char *p = file.data;
+      const char *end = file.data + file.size;
+      while (p < end) {
+        skip_blanks(&p, end);
+        Vec3 v;
+        if (end - p > 1 && p[0] == 'v' && is_blank(p[1])) {
+          p++;
+          if (parse_vertex_fields(&p, end, &v))
+            bounds_add(&lo, &hi, &any, transform_point(xf, v));
+        }
+        skip_line(&p, end);
+      }
+    } else if (ply_parse(&file, &ply, false, error, sizeof(error))) {
+      // Only the vertex stream is read
+      for (int k = 0; k < ply.vertex_count; k++)
+        bounds_add(&lo, &hi, &any, transform_point(xf, ply.vertices[k]));
+      free(ply.vertices);
+    }
+    mapped_file_close(&file);
+  }
+  if (!any)
+    return false;
+
+  Vec3 padding = {OBJ_LAZY_BOUNDS_PADDING, OBJ_LAZY_BOUNDS_PADDING,
+                  OBJ_LAZY_BOUNDS_PADDING};
+  *out = aabb_from_points(vec3_sub(lo, padding), vec3_add(hi, padding));
+  return true;
+}
+
+static Hittable *obj_lazy_load(void *ctx) {
+  const ObjLazyModel *model = ctx;
+  printf("Loading lazy OBJ model: %s\n", model->filename);
+  Hittable *triangles = hittablelist_empty();
+  MeshLoader *loader = mesh_loader_create(model->material);
+  ObjParseResult result =
+      obj_parse_file_to_hittables(model->filename, loader, triangles,
+                                  model->scale, model->position,
+                                  model->rotation);
+  if (!result.success) {
+    printf("WARNING: Failed to load %s: %s\n", model->filename,
+           result.error_message);
+  }
+  mesh_loader_destroy(loader);
+
+  Hittable *inner = NULL;
+  if (dynarray_size((DynArray *)triangles->data) > 0)
+    inner = bvhnode_create(triangles);
+  triangles->destroy(triangles);
+  return inner;
+}
+
+Hittable *obj_lazy_model_create(const char *filename, Material *material,
+                                Vec3 scale, Vec3 translation, Vec3 rotation) {
+  assert(filename != NULL && material != NULL);
+  Transform xf = obj_transform(scale, translation, rotation);
+  AABB bounds;
+  if (!obj_model_bounds(filename, &xf, &bounds))
+    return NULL;
+
+  // Allocated with the scene, like the proxy that refers to it
+  ObjLazyModel *model = rt_alloc(sizeof(ObjLazyModel));
+  assert(model != NULL);
+  size_t length = strlen(filename);
+  model->filename = rt_alloc(length + 1);
+  assert(model->filename != NULL);
+  memcpy(model->filename, filename, length + 1);
+  model->material = material;
+  model->scale = scale;
+  model->position = translation;
+  model->rotation = rotation;
+  return lazy_hittable_create(bounds, obj_lazy_load, model);
+}
+
+// ===== PAGED MODELS =====
+
+// The model's triangles after `xf`, as the eager loader would add them:
+// from its mesh cache if valid, else parsed (writing the cache on the way).
+// Returns NULL if the file cannot be read, fails to parse, has more
+// triangles than a page file can count or has none.
+static TriangleRaw *obj_paged_triangles(const char *filename,
+                                        const MeshCacheSource *stamp,
+                                        const Transform *xf, int *count) {
+  MeshCache cache;
+  ObjMesh mesh = {0};
+  const Vec3 *positions;
+  const uint32_t *indices;
+  size_t vertex_count, triangle_count;
+  bool cached = mesh_cache_open(&cache, filename, stamp);
+  if (cached) {
+    // mesh_cache_open checked both counts against the size of the mapping
+    positions = cache.positions;
+    indices = cache.indices;
+    vertex_count = cache.header->vertex_count;
+    triangle_count = cache.header->triangle_count;
+  } else {
+    MappedFile file;
+    if (!mapped_file_open(&file, filename))
+      return NULL;
+    int chunk_count;
+    ObjParseResult result =
+        obj_parse_mesh(filename, &file, &mesh, &chunk_count);
+    mapped_file_close(&file);
+    if (!result.success || mesh.vertex_count < 0 || mesh.triangle_count < 0) {
+      free(mesh.vertices);
+      free(mesh.indices);
+      return NULL;
+    }
+    if (!ply_is_ply(filename) && mesh.vertex_count > 0 &&
+        mesh.triangle_count > 0 &&
+        !mesh_cache_write(filename, stamp, mesh.vertices, mesh.vertex_count,
+                          mesh.indices, mesh.triangle_count,
+                          mesh.degenerate_faces)) {
+      printf("WARNING: Could not write mesh cache for %s\n", filename);
+    }
+    positions = mesh.vertices;
+    indices = mesh.indices;
+    vertex_count = (size_t)mesh.vertex_count;
+    triangle_count = (size_t)mesh.triangle_count;
+  }
+
+  *count = 0;
+  TriangleRaw *triangles = NULL;
+  if (triangle_count > 0 && triangle_count <= INT_MAX) {
+    Vec3 *vertices = malloc((vertex_count ? vertex_count : 1) * sizeof(Vec3));
+    triangles = malloc(triangle_count * sizeof(TriangleRaw));
+    assert(vertices != NULL && triangles != NULL);
+    for (size_t k = 0; k < vertex_count; k++)
+      vertices[k] = transform_point(xf, positions[k]);
+    for (size_t k = 0; k < triangle_count; k++) {
+      const uint32_t *t = &indices[k * 3];
+      Vec3 a = vertices[t[0]], b = vertices[t[1]], c = vertices[t[2]];
+      if (triangle_has_area(a, b, c))
+        triangles[(*count)++] = triangle_raw_create(a, b, c);
+    }
+    free(vertices);
+  }
+
+  if (cached)
+    mesh_cache_close(&cache);
+  free(mesh.vertices);
+  free(mesh.indices);
+  if (*count == 0) {
+    free(triangles);
+    return NULL;
+  }
+  return triangles;
+}
+
+Hittable *obj_paged_model_create(const char *filename, Material *material,
+                                 Vec3 scale, Vec3 translation, Vec3 rotation) {
+  assert(filename != NULL && material != NULL);
+  MeshCacheSource stamp;
+  if (!mesh_cache_stat(filename, &stamp))
+    return NULL;
+
+  PagedMeshKey key;
+  memset(&key, 0, sizeof(key));
+  key.source_size = stamp.size;
+  key.source_mtime_sec = stamp.mtime_sec;
+  key.source_mtime_nsec = stamp.mtime_nsec;
+  key.scale = scale;
+  key.position = translation;
+  key.rotation = rotation;
+
+  // Instances of one model under different transforms each get a file,
+  // named by an FNV-1a hash of the transform
+  uint32_t transform_hash = 2166136261u;
+  const unsigned char *bytes = (const unsigned char *)&key.scale;
+  for (size_t k = 0; k < 3 * sizeof(Vec3); k++)
+    transform_hash = (transform_hash ^ bytes[k]) * 16777619u;
+  size_t path_size = strlen(filename) + sizeof(PAGED_MESH_EXTENSION) + 9;
+  char *path = malloc(path_size);
+  assert(path != NULL);
+  snprintf(path, path_size, "%s.%08x%s", filename, (unsigned)transform_hash,
+           PAGED_MESH_EXTENSION);
+
+  Hittable *mesh = paged_mesh_open(path, &key, material);
+  if (!mesh) {
+    printf("Building page file for OBJ model: %s\n", filename);
+    Transform xf = obj_transform(scale, translation, rotation);
+    int count = 0;
+    TriangleRaw *triangles =
+        obj_paged_triangles(filename, &stamp, &xf, &count);
+    if (triangles && paged_mesh_write(path, &key, triangles, count))
+      mesh = paged_mesh_open(path, &key, material);
+    else if (triangles)
+      printf("WARNING: Could not write page file %s\n", path);
+    free(triangles);
+  }
+  free(path);
+  if (mesh) {
+    printf("Paged OBJ model: %s: ", filename);
+    paged_mesh_print(mesh);
+    printf("\n");
+  }
+  return mesh;
+}
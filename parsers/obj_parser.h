@@ -18,11 +18,31 @@ typedef struct ObjParseResult {
 } ObjParseResult;
 
 // NEW: Main function for loading OBJ with MeshLoader (individual triangles)
+// Maps the file and reads `v` and `f` lines; faces may use any of the
+// v, v/vt, v//vn and v/vt/vn corner forms, negative (relative) indices and
+// any number of corners, split into a triangle fan. Each vertex is scaled,
+// rotated about X, Y and Z (radians) and moved to `translation`.
 ObjParseResult obj_parse_file_to_hittables(const char *filename,
                                            MeshLoader *loader,
                                            Hittable *hittable_list, Vec3 scale,
                                            Vec3 translation, Vec3 rotation);
 
+// Creates a proxy for the same model that is only parsed, and its triangles
+// put in a BVH of their own, once a ray first enters its bounds (see
+// hittable/lazy_hittable.h). The bounds come from the model's mesh cache
+// when it has a valid one, else from a scan of its `v` lines alone. Returns
+// NULL if the file cannot be read or has no vertices.
+Hittable *obj_lazy_model_create(const char *filename, Material *material,
+                                Vec3 scale, Vec3 translation, Vec3 rotation);
+
+// Creates the same model as a paged mesh (hittable/paged_mesh.h): its
+// triangles are kept in `<file>.<transform hash>.rtpages`, built on first
+// use and rebuilt when the file changes, and only read into memory page by
+// page as rays reach them. Returns NULL if the model cannot be read or
+// its page file cannot be written.
+Hittable *obj_paged_model_create(const char *filename, Material *material,
+                                 Vec3 scale, Vec3 translation, Vec3 rotation);
+
 // Utility functions for parsing individual lines
 bool obj_parse_vertex(const char *line, Vec3 *vertex);
 bool obj_parse_face(const char *line, int *v1, int *v2, int *v3, int *v4,
@@ -0,0 +1,548 @@
+#include "ply_parser.h"
+#include "core/mapped_file.h"
+#include "core/vec3.h"
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define PLY_MAX_ELEMENTS 16
+#define PLY_MAX_PROPERTIES 32
+#define PLY_NAME_LENGTH 32
+#define PLY_LINE_LENGTH 256
+
+typedef enum {
+  PLY_INT8,
+  PLY_UINT8,
+  PLY_INT16,
+  PLY_UINT16,
+  PLY_INT32,
+  PLY_UINT32,
+  PLY_FLOAT32,
+  PLY_FLOAT64,
+} PlyType;
+
+static const struct {
+  const char *name;
+  PlyType type;
+} ply_type_names[] = {
+    {"char", PLY_INT8},     {"int8", PLY_INT8},       {"uchar", PLY_UINT8},
+    {"uint8", PLY_UINT8},   {"short", PLY_INT16},     {"int16", PLY_INT16},
+    {"ushort", PLY_UINT16}, {"uint16", PLY_UINT16},   {"int", PLY_INT32},
+    {"int32", PLY_INT32},   {"uint", PLY_UINT32},     {"uint32", PLY_UINT32},
+    {"float", PLY_FLOAT32}, {"float32", PLY_FLOAT32}, {"double", PLY_FLOAT64},
+    {"float64", PLY_FLOAT64},
+};
+
+static const size_t ply_type_size[] = {1, 1, 2, 2, 4, 4, 4, 8};
+
+typedef struct PlyProperty {
+  char name[PLY_NAME_LENGTH];
+  PlyType type;       // Of the value, or of the items of a list
+  bool is_list;
+  PlyType count_type; // Of a list's length
+} PlyProperty;
+
+typedef struct PlyElement {
+  char name[PLY_NAME_LENGTH];
+  long count;
+  PlyProperty properties[PLY_MAX_PROPERTIES];
+  int property_count;
+} PlyElement;
+
+typedef struct PlyHeader {
+  bool swap; // File byte order differs from ours
+  PlyElement elements[PLY_MAX_ELEMENTS];
+  int element_count;
+  const unsigned char *body; // First byte after end_header
+} PlyHeader;
+
+static bool ply_fail(char *error, size_t error_size, const char *format,
+                     ...) {
+  va_list args;
+  va_start(args, format);
+  vsnprintf(error, error_size, format, args);
+  va_end(args);
+  return false;
+}
+
+bool ply_is_ply(const char *filename) {
+  size_t length = strlen(filename);
+  size_t extension = strlen(PLY_EXTENSION);
+  return length > extension &&
+         strcasecmp(filename + length - extension, PLY_EXTENSION) == 0;
+}
+
+// ===== HEADER =====
+
+static bool ply_type_parse(const char *name, PlyType *out) {
+  for (size_t k = 0; k < sizeof(ply_type_names) / sizeof(ply_type_names[0]);
+       k++) {
+    if (strcmp(name, ply_type_names[k].name) == 0) {
+      *out = ply_type_names[k].type;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Copies the header line at `*p` into `line` without its line break and
+// moves `*p` to the next line. Returns false at the end of the file or for
+// a line too long to be a header line.
+static bool ply_next_line(const char **p, const char *end, char *line) {
+  const char *newline = memchr(*p, '\n', (size_t)(end - *p));
+  if (!newline || newline - *p >= PLY_LINE_LENGTH)
+    return false;
+  size_t length = (size_t)(newline - *p);
+  if (length > 0 && (*p)[length - 1] == '\r')
+    length--;
+  memcpy(line, *p, length);
+  line[length] = '\0';
+  *p = newline + 1;
+  return true;
+}
+
+static bool ply_parse_property(PlyElement *element, char **save, char *error,
+                               size_t error_size) {
+  if (element->property_count == PLY_MAX_PROPERTIES)
+    return ply_fail(error, error_size, "PLY element %s has more than %d "
+                    "properties", element->name, PLY_MAX_PROPERTIES);
+  PlyProperty *property = &element->properties[element->property_count];
+  memset(property, 0, sizeof(*property));
+
+  const char *type = strtok_r(NULL, " \t", save);
+  if (type && strcmp(type, "list") == 0) {
+    property->is_list = true;
+    const char *count_type = strtok_r(NULL, " \t", save);
+    if (!count_type || !ply_type_parse(count_type, &property->count_type) ||
+        property->count_type == PLY_FLOAT32 ||
+        property->count_type == PLY_FLOAT64)
+      return ply_fail(error, error_size, "Bad PLY list length type: %s",
+                      count_type ? count_type : "(none)");
+    type = strtok_r(NULL, " \t", save);
+  }
+  const char *name = strtok_r(NULL, " \t", save);
+  if (!type || !ply_type_parse(type, &property->type))
+    return ply_fail(error, error_size, "Bad PLY property type: %s",
+                    type ? type : "(none)");
+  if (!name || strlen(name) >= PLY_NAME_LENGTH)
+    return ply_fail(error, error_size, "Bad PLY property name");
+  strcpy(property->name, name);
+  element->property_count++;
+  return true;
+}
+
+static bool ply_parse_header(const MappedFile *file, PlyHeader *header,
+                             char *error, size_t error_size) {
+  memset(header, 0, sizeof(*header));
+  const char *p = file->data;
+  const char *end = file->data + file->size;
+  char line[PLY_LINE_LENGTH];
+  if (!ply_next_line(&p, end, line) || strcmp(line, "ply") != 0)
+    return ply_fail(error, error_size, "Not a PLY file");
+
+  bool have_format = false;
+  while (true) {
+    if (!ply_next_line(&p, end, line))
+      return ply_fail(error, error_size, "PLY header has no end_header");
+    char *save = NULL;
+    const char *keyword = strtok_r(line, " \t", &save);
+    if (!keyword || strcmp(keyword, "comment") == 0 ||
+        strcmp(keyword, "obj_info") == 0)
+      continue;
+
+    if (strcmp(keyword, "end_header") == 0) {
+      break;
+    } else if (strcmp(keyword, "format") == 0) {
+      const char *format = strtok_r(NULL, " \t", &save);
+      bool host_big = __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+      if (format && strcmp(format, "binary_little_endian") == 0) {
+        header->swap = host_big;
+      } else if (format && strcmp(format, "binary_big_endian") == 0) {
+        header->swap = !host_big;
+      } else {
+        return ply_fail(error, error_size,
+                        "Unsupported PLY format %s (only binary PLY is read)",
+                        format ? format : "(none)");
+      }
+      have_format = true;
+    } else if (strcmp(keyword, "element") == 0) {
+      if (header->element_count == PLY_MAX_ELEMENTS)
+        return ply_fail(error, error_size, "PLY file has more than %d "
+                        "elements", PLY_MAX_ELEMENTS);
+      PlyElement *element = &header->elements[header->element_count++];
+      const char *name = strtok_r(NULL, " \t", &save);
+      const char *count = strtok_r(NULL, " \t", &save);
+      char *count_end = NULL;
+      element->count = count ? strtol(count, &count_end, 10) : -1;
+      if (!name || strlen(name) >= PLY_NAME_LENGTH || !count ||
+          *count_end != '\0' || element->count < 0 ||
+          element->count > INT_MAX)
+        return ply_fail(error, error_size, "Bad PLY element line");
+      strcpy(element->name, name);
+    } else if (strcmp(keyword, "property") == 0) {
+      if (header->element_count == 0)
+        return ply_fail(error, error_size,
+                        "PLY property before any element");
+      if (!ply_parse_property(&header->elements[header->element_count - 1],
+                              &save, error, error_size))
+        return false;
+    } else {
+      return ply_fail(error, error_size, "Unknown PLY header line: %s",
+                      keyword);
+    }
+  }
+  if (!have_format)
+    return ply_fail(error, error_size, "PLY header has no format line");
+  header->body = (const unsigned char *)p;
+  return true;
+}
+
+// ===== BODY =====
+
+static inline double ply_scalar(const unsigned char *p, PlyType type,
+                                bool swap) {
+  unsigned char bytes[8];
+  size_t size = ply_type_size[type];
+  if (swap) {
+    for (size_t k = 0; k < size; k++)
+      bytes[k] = p[size - 1 - k];
+  } else {
+    memcpy(bytes, p, size);
+  }
+  switch (type) {
+  case PLY_INT8: {
+    int8_t v;
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+  }
+  case PLY_UINT8:
+    return bytes[0];
+  case PLY_INT16: {
+    int16_t v;
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+  }
+  case PLY_UINT16: {
+    uint16_t v;
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+  }
+  case PLY_INT32: {
+    int32_t v;
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+  }
+  case PLY_UINT32: {
+    uint32_t v;
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+  }
+  case PLY_FLOAT32: {
+    float v;
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+  }
+  default: {
+    double v;
+    memcpy(&v, bytes, sizeof(v));
+    return v;
+  }
+  }
+}
+
+// Size of a record of `element` whose properties are all scalars, or 0 if
+// it has lists and records vary in size.
+static size_t ply_fixed_stride(const PlyElement *element) {
+  size_t stride = 0;
+  for (int k = 0; k < element->property_count; k++) {
+    if (element->properties[k].is_list)
+      return 0;
+    stride += ply_type_size[element->properties[k].type];
+  }
+  return stride;
+}
+
+// Converts a list length read as `count`, which must be a whole number no
+// larger than a uint count type holds. Checked before the conversion, which
+// is undefined for negative or huge values.
+static bool ply_list_length(double count, size_t *length) {
+  if (!(count >= 0 && count <= UINT32_MAX) || count != floor(count))
+    return false;
+  *length = (size_t)count;
+  return true;
+}
+
+// Moves `*p` past one list property, or returns false if it runs past `end`.
+static bool ply_skip_list(const unsigned char **p, const unsigned char *end,
+                          const PlyProperty *property, bool swap) {
+  size_t count_size = ply_type_size[property->count_type];
+  if ((size_t)(end - *p) < count_size)
+    return false;
+  size_t length;
+  if (!ply_list_length(ply_scalar(*p, property->count_type, swap), &length))
+    return false;
+  *p += count_size;
+  size_t item_size = ply_type_size[property->type];
+  if ((size_t)(end - *p) / item_size < length)
+    return false;
+  *p += length * item_size;
+  return true;
+}
+
+// Moves `*p` past every record of an element that is not read.
+static bool ply_skip_element(const unsigned char **p,
+                             const unsigned char *end,
+                             const PlyElement *element, bool swap) {
+  size_t stride = ply_fixed_stride(element);
+  if (stride > 0) {
+    if ((size_t)(end - *p) / stride < (size_t)element->count)
+      return false;
+    *p += stride * (size_t)element->count;
+    return true;
+  }
+  for (long r = 0; r < element->count; r++) {
+    for (int k = 0; k < element->property_count; k++) {
+      const PlyProperty *property = &element->properties[k];
+      if (property->is_list) {
+        if (!ply_skip_list(p, end, property, swap))
+          return false;
+      } else {
+        size_t size = ply_type_size[property->type];
+        if ((size_t)(end - *p) < size)
+          return false;
+        *p += size;
+      }
+    }
+  }
+  return true;
+}
+
+static int ply_find_property(const PlyElement *element, const char *name) {
+  for (int k = 0; k < element->property_count; k++) {
+    if (strcmp(element->properties[k].name, name) == 0)
+      return k;
+  }
+  return -1;
+}
+
+// Reads the positions of the vertex element into mesh->vertices.
+static bool ply_read_vertices(const unsigned char **p,
+                              const unsigned char *end,
+                              const PlyElement *element, bool swap,
+                              PlyMesh *mesh, char *error, size_t error_size) {
+  int axes[3] = {ply_find_property(element, "x"),
+                 ply_find_property(element, "y"),
+                 ply_find_property(element, "z")};
+  for (int a = 0; a < 3; a++) {
+    if (axes[a] < 0 || element->properties[axes[a]].is_list)
+      return ply_fail(error, error_size,
+                      "PLY vertices have no x, y and z properties");
+  }
+  int count = (int)element->count;
+  size_t stride = ply_fixed_stride(element);
+  if (stride > 0 && (size_t)(end - *p) / stride < (size_t)count)
+    return ply_fail(error, error_size, "PLY vertex data is truncated");
+  mesh->vertices = malloc((size_t)(count ? count : 1) * sizeof(Vec3));
+  assert(mesh->vertices != NULL);
+  mesh->vertex_count = count;
+
+  if (stride > 0) {
+    // Every record has the same layout: read the coordinates at fixed
+    // offsets, with a direct copy for the usual native-order floats
+    size_t offsets[3];
+    PlyType types[3];
+    for (int a = 0; a < 3; a++) {
+      offsets[a] = 0;
+      for (int k = 0; k < axes[a]; k++)
+        offsets[a] += ply_type_size[element->properties[k].type];
+      types[a] = element->properties[axes[a]].type;
+    }
+    const unsigned char *record = *p;
+    if (!swap && types[0] == PLY_FLOAT32 && types[1] == PLY_FLOAT32 &&
+        types[2] == PLY_FLOAT32) {
+      for (int v = 0; v < count; v++, record += stride) {
+        float xyz[3];
+        for (int a = 0; a < 3; a++)
+          memcpy(&xyz[a], record + offsets[a], sizeof(float));
+        mesh->vertices[v] = (Vec3){xyz[0], xyz[1], xyz[2]};
+      }
+    } else {
+      for (int v = 0; v < count; v++, record += stride) {
+        mesh->vertices[v] = (Vec3){ply_scalar(record + offsets[0], types[0],
+                                              swap),
+                                   ply_scalar(record + offsets[1], types[1],
+                                              swap),
+                                   ply_scalar(record + offsets[2], types[2],
+                                              swap)};
+      }
+    }
+    *p += stride * (size_t)count;
+    return true;
+  }
+
+  // Records with lists in them are walked property by property
+  for (int v = 0; v < count; v++) {
+    double xyz[3] = {0, 0, 0};
+    for (int k = 0; k < element->property_count; k++) {
+      const PlyProperty *property = &element->properties[k];
+      if (property->is_list) {
+        if (!ply_skip_list(p, end, property, swap))
+          return ply_fail(error, error_size, "PLY vertex data is truncated");
+        continue;
+      }
+      size_t size = ply_type_size[property->type];
+      if ((size_t)(end - *p) < size)
+        return ply_fail(error, error_size, "PLY vertex data is truncated");
+      for (int a = 0; a < 3; a++) {
+        if (k == axes[a])
+          xyz[a] = ply_scalar(*p, property->type, swap);
+      }
+      *p += size;
+    }
+    mesh->vertices[v] = (Vec3){xyz[0], xyz[1], xyz[2]};
+  }
+  return true;
+}
+
+static void ply_push_triangle(PlyMesh *mesh, int *capacity, uint32_t a,
+                              uint32_t b, uint32_t c) {
+  if (mesh->triangle_count == *capacity) {
+    *capacity = *capacity ? *capacity * 2 : 1024;
+    mesh->indices =
+        realloc(mesh->indices, (size_t)*capacity * 3 * sizeof(uint32_t));
+    assert(mesh->indices != NULL);
+  }
+  uint32_t *t = &mesh->indices[(size_t)mesh->triangle_count++ * 3];
+  t[0] = a;
+  t[1] = b;
+  t[2] = c;
+}
+
+// Reads the index lists of the face element and fan triangulates them into
+// mesh->indices. Needs the vertex count from the header, not the vertices.
+static bool ply_read_faces(const unsigned char **p, const unsigned char *end,
+                           const PlyElement *element, bool swap,
+                           long vertex_count, PlyMesh *mesh, char *error,
+                           size_t error_size) {
+  int list = ply_find_property(element, "vertex_indices");
+  if (list < 0)
+    list = ply_find_property(element, "vertex_index");
+  if (list < 0 || !element->properties[list].is_list)
+    return ply_fail(error, error_size,
+                    "PLY faces have no vertex_indices list");
+
+  // Most faces are triangles, so one per face is the first guess
+  int capacity = (int)element->count;
+  mesh->indices =
+      malloc((size_t)(capacity ? capacity : 1) * 3 * sizeof(uint32_t));
+  assert(mesh->indices != NULL);
+
+  const PlyProperty *indices = &element->properties[list];
+  size_t count_size = ply_type_size[indices->count_type];
+  size_t index_size = ply_type_size[indices->type];
+  for (long f = 0; f < element->count; f++) {
+    for (int k = 0; k < element->property_count; k++) {
+      const PlyProperty *property = &element->properties[k];
+      if (k != list) {
+        bool ok;
+        if (property->is_list) {
+          ok = ply_skip_list(p, end, property, swap);
+        } else {
+          ok = (size_t)(end - *p) >= ply_type_size[property->type];
+          if (ok)
+            *p += ply_type_size[property->type];
+        }
+        if (!ok)
+          return ply_fail(error, error_size, "PLY face data is truncated");
+        continue;
+      }
+
+      if ((size_t)(end - *p) < count_size)
+        return ply_fail(error, error_size, "PLY face data is truncated");
+      size_t corners;
+      if (!ply_list_length(ply_scalar(*p, indices->count_type, swap),
+                           &corners))
+        return ply_fail(error, error_size, "Bad PLY face length in face %ld",
+                        f);
+      *p += count_size;
+      if ((size_t)(end - *p) / index_size < corners)
+        return ply_fail(error, error_size, "PLY face data is truncated");
+
+      uint32_t first = 0, previous = 0;
+      for (size_t c = 0; c < corners; c++, *p += index_size) {
+        double index = ply_scalar(*p, indices->type, swap);
+        if (!(index >= 0 && index < vertex_count))
+          return ply_fail(error, error_size,
+                          "Invalid face vertex index %.0f in face %ld "
+                          "(vertex_count=%ld)",
+                          index, f, vertex_count);
+        uint32_t current = (uint32_t)index;
+        if (c == 0) {
+          first = current;
+        } else if (c >= 2) {
+          if (first == previous || first == current || previous == current)
+            mesh->degenerate_faces++;
+          else
+            ply_push_triangle(mesh, &capacity, first, previous, current);
+        }
+        previous = current;
+      }
+    }
+  }
+  return true;
+}
+
+bool ply_parse(const MappedFile *file, PlyMesh *mesh, bool read_faces,
+               char *error, size_t error_size) {
+  assert(file != NULL && mesh != NULL);
+  memset(mesh, 0, sizeof(*mesh));
+  PlyHeader header;
+  if (!ply_parse_header(file, &header, error, error_size))
+    return false;
+
+  // Faces index the vertices of the one vertex element
+  long vertex_count = -1;
+  for (int e = 0; e < header.element_count; e++) {
+    if (strcmp(header.elements[e].name, "vertex") != 0)
+      continue;
+    if (vertex_count >= 0)
+      return ply_fail(error, error_size,
+                      "PLY file has more than one vertex element");
+    vertex_count = header.elements[e].count;
+  }
+  if (vertex_count < 0)
+    return ply_fail(error, error_size, "PLY file has no vertex element");
+
+  // Elements follow each other in header order
+  const unsigned char *p = header.body;
+  const unsigned char *end =
+      (const unsigned char *)file->data + file->size;
+  bool ok = true;
+  for (int e = 0; ok && e < header.element_count; e++) {
+    const PlyElement *element = &header.elements[e];
+    if (strcmp(element->name, "vertex") == 0 && !mesh->vertices) {
+      ok = ply_read_vertices(&p, end, element, header.swap, mesh, error,
+                             error_size);
+    } else if (strcmp(element->name, "face") == 0 && read_faces &&
+               !mesh->indices) {
+      ok = ply_read_faces(&p, end, element, header.swap, vertex_count, mesh,
+                          error, error_size);
+    } else if (!read_faces && mesh->vertices) {
+      break; // Nothing else is needed
+    } else if (!ply_skip_element(&p, end, element, header.swap)) {
+      ok = ply_fail(error, error_size, "PLY %s data is truncated",
+                    element->name);
+    }
+  }
+  if (!ok) {
+    free(mesh->vertices);
+    free(mesh->indices);
+    memset(mesh, 0, sizeof(*mesh));
+  }
+  return ok;
+}
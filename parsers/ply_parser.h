@@ -0,0 +1,38 @@
+#ifndef PLY_PARSER_H
+#define PLY_PARSER_H
+
+#include "core/mapped_file.h"
+#include "core/vec3.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Reader for binary PLY meshes (little or big endian), as scanners and
+// mesh tools export them. The header is parsed to learn the layout of each
+// element; the vertex and face streams are then read straight out of the
+// mapped file into one array each, converting x, y and z and the face
+// indices from whatever property types the file declares. Other properties
+// (normals, colours, ...) and other elements are skipped. Faces are fan
+// triangulated like OBJ faces.
+#define PLY_EXTENSION ".ply"
+
+// A mesh in the same form obj_parser.c builds from OBJ text.
+typedef struct PlyMesh {
+  Vec3 *vertices; // vertex_count positions, as stored in the file
+  int vertex_count;
+  uint32_t *indices; // Three per triangle
+  int triangle_count;
+  int degenerate_faces; // Faces or fan triangles with repeated corners
+} PlyMesh;
+
+// True if `filename` ends in PLY_EXTENSION, in any case.
+extern bool ply_is_ply(const char *filename);
+
+// Reads the mesh in `file` into `mesh`, whose arrays the caller frees; with
+// `read_faces` false only the vertices are read. Returns false with the
+// reason in `error`, and `mesh` empty, if the file is not a well-formed
+// binary PLY with vertex positions (ASCII PLY is rejected too).
+extern bool ply_parse(const MappedFile *file, PlyMesh *mesh, bool read_faces,
+                      char *error, size_t error_size);
+
+#endif // PLY_PARSER_H
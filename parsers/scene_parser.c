@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -9,10 +10,19 @@
 #include "../app/camera.h"
 #include "core/dyn_array.h"
 #include "core/generic_types.h"
+#include "core/mapped_file.h"
+#include "core/name_table.h"
+#include "core/parse_number.h"
+#include "core/thread_pool.h"
 #include "core/vec3.h"
+#include "hittable/box.h"
+#include "hittable/bvh_node.h"
+#include "hittable/hittable_list.h"
 #include "hittable/plane.h"
 #include "hittable/quad.h"
+#include "hittable/rotate_y.h"
 #include "hittable/sphere.h"
+#include "hittable/translate.h"
 #include "hittable/triangle_hittable.h"
 #include "hittable/triangle_mesh.h"
 #include "material/dielectric.h"
@@ -49,6 +59,7 @@ typedef enum {
   TRIANGLE_STATE,
   PLANE_STATE,
   QUAD_STATE,
+  BOX_STATE,
   OBJ_MODEL_STATE,
 } ParserState;
 
@@ -65,7 +76,7 @@ void validate_hittable(const Hittable *obj, const char *context) {
   printf("Data pointer: %p\n", (void *)obj->data);
 
   // Validate type is in range
-  if (obj->type < 0 || obj->type > HITTABLE_TRIANGLE_MESH) {
+  if (obj->type < 0 || obj->type > HITTABLE_PAGED_MESH) {
     printf("ERROR: Invalid hittable type: %d\n", obj->type);
   }
 
@@ -115,32 +126,74 @@ void debug_scene_addition(Scene *scene, Hittable *new_obj,
   printf(">>> END ADDING %s <<<\n\n", obj_name);
 }
 
-static int tokenize(char *line, char *tokens[]) {
-  int num_toks = 0;
-  char *saveptr = NULL;
-  char *token = strtok_r(line, " \t\n", &saveptr);
-
-  while (token && num_toks < MAX_TOKENS) {
-    tokens[num_toks++] = token;
-    token = strtok_r(NULL, " \t\n", &saveptr);
+// Wraps a block's primitive in the rotate_y/translate nodes it requested.
+// Rotation is applied first, about the object's own origin.
+static Hittable *wrap_transforms(Hittable *obj, double rotate_y_degrees,
+                                 Vec3 translate) {
+  if (rotate_y_degrees != 0.0) {
+    obj = rotate_y_create(obj, rotate_y_degrees);
   }
+  if (!vec3_is_near_zero(translate)) {
+    obj = translate_create(obj, translate);
+  }
+  return obj;
+}
 
+static inline bool is_separator(char c) {
+  return c == ' ' || c == '\t' || c == '\r';
+}
+
+// Splits the line [begin, end) into NUL-terminated tokens, copied into
+// `buffer` (at least end - begin + 1 bytes) in one pass. Words past
+// MAX_TOKENS are dropped.
+static int tokenize(const char *begin, const char *end, char *buffer,
+                    char *tokens[]) {
+  int num_toks = 0;
+  char *out = buffer;
+  const char *p = begin;
+  for (;;) {
+    while (p < end && is_separator(*p))
+      p++;
+    if (p == end)
+      break;
+    char *token = out;
+    while (p < end && !is_separator(*p))
+      *out++ = *p++;
+    *out++ = '\0';
+    if (num_toks < MAX_TOKENS)
+      tokens[num_toks++] = token;
+  }
   return num_toks;
 }
 
-static Vec3 parse_vec3(char **tokens) {
-  return (Vec3){
-      .x = atof(tokens[1]), .y = atof(tokens[2]), .z = atof(tokens[3])};
+// The whole token as a number. Ordinary decimals go through parse_double;
+// anything it does not take (inf, hex floats) is left to strtod, and a
+// token neither reads completely is an error rather than atof's 0.
+static double token_double(const char *token) {
+  const char *end = token + strlen(token);
+  const char *p = token;
+  double value;
+  if (parse_double(&p, end, &value) && p == end)
+    return value;
+  char *rest;
+  value = strtod(token, &rest);
+  PANIC_IF(rest == token || *rest != '\0', "Invalid number: %s", token);
+  return value;
 }
 
-static int name_index(const DynArray *name_array, const char *name) {
-  size_t n = dynarray_size(name_array);
-  for (size_t i = 0; i < n; i++) {
-    const char *name_at_index = (const char *)dynarray_get(name_array, i);
-    if (name_at_index && strcmp(name_at_index, name) == 0)
-      return (int)i;
-  }
-  return -1;
+static int token_int(const char *token) {
+  const char *end = token + strlen(token);
+  const char *p = token;
+  long value;
+  PANIC_IF(!parse_int(&p, end, &value) || p != end, "Invalid integer: %s",
+           token);
+  return (int)value;
+}
+
+static Vec3 parse_vec3(char **tokens) {
+  return (Vec3){.x = token_double(tokens[1]),
+                .y = token_double(tokens[2]),
+                .z = token_double(tokens[3])};
 }
 
 static void parse_camera(char *tokens[], int num_toks, Vec3 *lookfrom,
@@ -150,10 +203,10 @@ static void parse_camera(char *tokens[], int num_toks, Vec3 *lookfrom,
                          double *aspect_ratio, int *width, Color *background,
                          bool *is_lighting) {
   if (num_toks == 2 && strcmp(tokens[0], "width") == 0) {
-    *width = atoi(tokens[1]);
+    *width = token_int(tokens[1]);
   } else if (num_toks == 3 && strcmp(tokens[0], "aspect_ratio") == 0) {
-    double w = atof(tokens[1]);
-    double h = atof(tokens[2]);
+    double w = token_double(tokens[1]);
+    double h = token_double(tokens[2]);
     *aspect_ratio = w / h;
   } else if (num_toks == 4 && strcmp(tokens[0], "lookfrom") == 0) {
     *lookfrom = parse_vec3(tokens);
@@ -162,15 +215,15 @@ static void parse_camera(char *tokens[], int num_toks, Vec3 *lookfrom,
   } else if (num_toks == 4 && strcmp(tokens[0], "vup") == 0) {
     *vup = parse_vec3(tokens);
   } else if (num_toks == 2 && strcmp(tokens[0], "vfov") == 0) {
-    *vfov = atof(tokens[1]);
+    *vfov = token_double(tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "defocus_angle") == 0) {
-    *defocus_angle = atof(tokens[1]);
+    *defocus_angle = token_double(tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "focus_distance") == 0) {
-    *focus_dist = atof(tokens[1]);
+    *focus_dist = token_double(tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "samples_per_pixel") == 0) {
-    *samples_per_pixel = atoi(tokens[1]);
+    *samples_per_pixel = token_int(tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "max_depth") == 0) {
-    *max_depth = atoi(tokens[1]);
+    *max_depth = token_int(tokens[1]);
   } else if (num_toks == 4 && strcmp(tokens[0], "background") == 0) {
     *background = parse_vec3(tokens);
   } else if (num_toks == 2 && strcmp(tokens[0], "lighting") == 0) {
@@ -187,7 +240,7 @@ static void parse_texture(char *tokens[], int num_toks, char *name, char *type,
   } else if (num_toks == 2 && strcmp(tokens[0], "type") == 0) {
     strcpy(type, tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "scale") == 0) {
-    *scale = atof(tokens[1]);
+    *scale = token_double(tokens[1]);
   } else if (num_toks == 4 && (strcmp(tokens[0], "color1") == 0 ||
                                strcmp(tokens[0], "color") == 0)) {
     *color1 = parse_vec3(tokens);
@@ -198,7 +251,7 @@ static void parse_texture(char *tokens[], int num_toks, char *name, char *type,
   }
 }
 
-static void add_texture(Scene *scene, DynArray *tex_names, const char *name,
+static void add_texture(Scene *scene, NameTable *tex_names, const char *name,
                         const char *type, double scale, Vec3 color1,
                         Vec3 color2) {
   Texture *tex;
@@ -212,9 +265,8 @@ static void add_texture(Scene *scene, DynArray *tex_names, const char *name,
 
   PANIC_IF(!tex, "Failed to create texture: %s", name);
 
+  name_table_insert(tex_names, name, dynarray_size(scene->textures));
   scene_add_texture(scene, tex);
-  char *name_dup = strdup(name);
-  dynarray_push(tex_names, name_dup);
 }
 
 static void parse_material(char *tokens[], int num_toks, char *name, char *type,
@@ -229,9 +281,9 @@ static void parse_material(char *tokens[], int num_toks, char *name, char *type,
                                strcmp(tokens[0], "albedo") == 0)) {
     *color = parse_vec3(tokens);
   } else if (num_toks == 2 && strcmp(tokens[0], "fuzz") == 0) {
-    *fuzz = atof(tokens[1]);
+    *fuzz = token_double(tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "ref_idx") == 0) {
-    *ref_index = atof(tokens[1]);
+    *ref_index = token_double(tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "texture") == 0) {
     strcpy(texture_name, tokens[1]);
   } else {
@@ -239,14 +291,15 @@ static void parse_material(char *tokens[], int num_toks, char *name, char *type,
   }
 }
 
-static void add_material(Scene *scene, DynArray *mat_names, DynArray *tex_names,
+static void add_material(Scene *scene, NameTable *mat_names,
+                         const NameTable *tex_names,
                          const char *name, const char *type, Vec3 color,
                          double fuzz, double ref_index,
                          const char *texture_name) {
   Material *mat;
   if (strcmp(type, "lambertian") == 0) {
     if (strlen(texture_name) > 0) {
-      int index = name_index(tex_names, texture_name);
+      int index = name_table_find(tex_names, texture_name);
       PANIC_IF(index < 0, "Texture not found: %s", texture_name);
       Texture *tex = (Texture *)dynarray_get(scene->textures, (size_t)index);
       mat = lambertian_create_texture(tex);
@@ -255,7 +308,7 @@ static void add_material(Scene *scene, DynArray *mat_names, DynArray *tex_names,
     }
   } else if (strcmp(type, "metal") == 0) {
     if (strlen(texture_name) > 0) {
-      int index = name_index(tex_names, texture_name);
+      int index = name_table_find(tex_names, texture_name);
       PANIC_IF(index < 0, "Texture not found: %s", texture_name);
       Texture *tex = (Texture *)dynarray_get(scene->textures, (size_t)index);
       mat = metal_create_texture(tex, fuzz);
@@ -266,7 +319,7 @@ static void add_material(Scene *scene, DynArray *mat_names, DynArray *tex_names,
     mat = dielectric_create(ref_index);
   } else if (strcmp(type, "diffuse_light") == 0) {
     if (strlen(texture_name) > 0) {
-      int index = name_index(tex_names, texture_name);
+      int index = name_table_find(tex_names, texture_name);
       PANIC_IF(index < 0, "Texture not found: %s", texture_name);
       Texture *tex = (Texture *)dynarray_get(scene->textures, (size_t)index);
       mat = diffuse_light_create_texture(tex);
@@ -279,16 +332,15 @@ static void add_material(Scene *scene, DynArray *mat_names, DynArray *tex_names,
 
   PANIC_IF(!mat, "Failed to create material: %s", name);
 
+  name_table_insert(mat_names, name, dynarray_size(scene->materials));
   scene_add_material(scene, mat);
-  char *name_dup = strdup(name);
-  dynarray_push(mat_names, name_dup);
 }
 static void parse_geometry(ParserState state, char *tokens[], int num_toks,
                            Vec3 *center_start, Vec3 *center_end,
                            bool *is_moving, double *radius, Vec3 *point,
                            Vec3 *normal, Vec3 *Q, Vec3 *u, Vec3 *v,
                            Vec3 *triangle_v0, Vec3 *triangle_v1,
-                           Vec3 *triangle_v2) {
+                           Vec3 *triangle_v2, Vec3 *box_min, Vec3 *box_max) {
   if (state == SPHERE_STATE) {
     if (num_toks == 4 && (strcmp(tokens[0], "center") == 0 ||
                           strcmp(tokens[0], "center_start") == 0)) {
@@ -297,7 +349,7 @@ static void parse_geometry(ParserState state, char *tokens[], int num_toks,
       *center_end = parse_vec3(tokens);
       *is_moving = true;
     } else if (num_toks == 2 && strcmp(tokens[0], "radius") == 0) {
-      *radius = atof(tokens[1]);
+      *radius = token_double(tokens[1]);
     } else {
       PANIC("Unknown sphere parameter: %s", tokens[0]);
     }
@@ -329,13 +381,21 @@ static void parse_geometry(ParserState state, char *tokens[], int num_toks,
     } else {
       PANIC("Unknown triangle parameter: %s", tokens[0]);
     }
+  } else if (state == BOX_STATE) {
+    if (num_toks == 4 && strcmp(tokens[0], "min") == 0) {
+      *box_min = parse_vec3(tokens);
+    } else if (num_toks == 4 && strcmp(tokens[0], "max") == 0) {
+      *box_max = parse_vec3(tokens);
+    } else {
+      PANIC("Unknown box parameter: %s", tokens[0]);
+    }
   } else {
     PANIC("Unknown geometry state");
   }
 }
 void parse_obj_model(char *tokens[], int num_toks, char *filename,
                      char *material_name, Vec3 *position, Vec3 *scale,
-                     Vec3 *rotation) {
+                     Vec3 *rotation, bool *lazy, bool *paged) {
   if (num_toks == 2 && strcmp(tokens[0], "file") == 0) {
     strcpy(filename, tokens[1]);
   } else if (num_toks == 2 && strcmp(tokens[0], "material") == 0) {
@@ -346,33 +406,205 @@ void parse_obj_model(char *tokens[], int num_toks, char *filename,
     *scale = parse_vec3(tokens);
   } else if (num_toks == 4 && strcmp(tokens[0], "rotation") == 0) {
     // Convert degrees to radians
-    rotation->x = atof(tokens[1]) * PI / 180.0;
-    rotation->y = atof(tokens[2]) * PI / 180.0;
-    rotation->z = atof(tokens[3]) * PI / 180.0;
+    rotation->x = token_double(tokens[1]) * PI / 180.0;
+    rotation->y = token_double(tokens[2]) * PI / 180.0;
+    rotation->z = token_double(tokens[3]) * PI / 180.0;
+  } else if (num_toks == 2 && strcmp(tokens[0], "lazy") == 0) {
+    *lazy = (strcmp(tokens[1], "on") == 0);
+  } else if (num_toks == 2 && strcmp(tokens[0], "paged") == 0) {
+    *paged = (strcmp(tokens[1], "on") == 0);
   } else {
     PANIC("Unknown obj_model parameter: %s", tokens[0]);
   }
 }
 
-static Material *find_material_by_name(Scene *scene, DynArray *mat_names,
-                                       const char *name) {
-  size_t num_materials = dynarray_size(mat_names);
-  for (size_t i = 0; i < num_materials; i++) {
-    char *mat_name_str = (char *)dynarray_get(mat_names, i);
-    if (mat_name_str && strcmp(name, mat_name_str) == 0) {
-      return (Material *)dynarray_get(scene->materials, i);
-    }
+// ===== MODEL LOADING =====
+
+// An obj_model block, loaded on the asset pool while parsing goes on. Its
+// place among the scene's objects is held by `placeholder` until the loads
+// are joined, so objects end up in file order whichever load finishes
+// first.
+typedef struct ModelFile ModelFile;
+typedef struct ModelLoads ModelLoads;
+
+typedef struct ModelLoad {
+  Hittable placeholder;
+  char filename[128];
+  Material *material;
+  Vec3 scale, position, rotation;
+  bool lazy, paged;
+  bool emissive; // Triangles stay individual objects so lights find them
+
+  Hittable *model;     // Lazy proxy, paged mesh or BVH over the triangles
+  Hittable *triangles; // Loaded eagerly, if there is no `model`
+  ObjParseResult result;
+
+  ModelLoads *owner;
+  ModelFile *file;
+  struct ModelLoad *next; // Next block naming the same file
+} ModelLoad;
+
+// Blocks naming the same file are run one after another by one job. The
+// first parses the file and writes its mesh cache (or page file), and the
+// ones after it map that instead of parsing the file again and writing the
+// same cache at the same time.
+struct ModelFile {
+  ModelLoad *last; // Latest block naming the file
+  bool running;    // A job is still working through the file's blocks
+};
+
+struct ModelLoads {
+  ThreadPool *pool; // Started by the first obj_model
+  DynArray *loads;
+  NameTable *file_names; // File name to its index in `files`
+  DynArray *files;
+  pthread_mutex_t lock; // Guards the `next` chains and ModelFile states
+};
+
+static void model_load_one(ModelLoad *load) {
+  load->result.success = true;
+  if (load->paged) {
+    load->model = obj_paged_model_create(load->filename, load->material,
+                                         load->scale, load->position,
+                                         load->rotation);
+  } else if (load->lazy) {
+    load->model = obj_lazy_model_create(load->filename, load->material,
+                                        load->scale, load->position,
+                                        load->rotation);
+  }
+  // A model that could not be proxied or paged is loaded now, which also
+  // reports why
+  if (load->model)
+    return;
+
+  load->triangles = hittablelist_empty();
+  MeshLoader *loader = mesh_loader_create(load->material);
+  load->result = obj_parse_file_to_hittables(
+      load->filename, loader, load->triangles, load->scale, load->position,
+      load->rotation);
+  mesh_loader_destroy(loader);
+
+  // The mesh's BVH is built here, as soon as its triangles are in, and
+  // becomes one object of the world BVH
+  if (!load->emissive &&
+      dynarray_size((DynArray *)load->triangles->data) > 0) {
+    load->model = bvhnode_create(load->triangles);
+    load->triangles->destroy(load->triangles);
+    load->triangles = NULL;
   }
-  return NULL;
 }
 
-void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
-  FILE *file = fopen(filename, "r");
+// Loads `ctx` and then every block queued behind it on the same file.
+static void model_load_run(void *ctx) {
+  ModelLoad *load = ctx;
+  ModelLoads *loads = load->owner;
+  while (load) {
+    model_load_one(load);
+    pthread_mutex_lock(&loads->lock);
+    ModelLoad *next = load->next;
+    if (!next)
+      load->file->running = false;
+    pthread_mutex_unlock(&loads->lock);
+    load = next;
+  }
+}
+
+static ModelFile *model_file_find(ModelLoads *self, const char *filename) {
+  int index = name_table_find(self->file_names, filename);
+  if (index >= 0)
+    return dynarray_get(self->files, index);
+  ModelFile *file = calloc(1, sizeof(ModelFile));
   assert(file != NULL);
+  name_table_insert(self->file_names, filename, dynarray_size(self->files));
+  dynarray_push(self->files, file);
+  return file;
+}
+
+static void model_load_submit(ModelLoads *self, Scene *scene,
+                              ModelLoad *load) {
+  if (!self->pool) {
+    self->pool = thread_pool_create(0);
+    self->loads = dynarray_create(8, NULL, NULL);
+    self->file_names = name_table_create();
+    self->files = dynarray_create(8, NULL, free);
+    pthread_mutex_init(&self->lock, NULL);
+    printf("Loading models on %d threads\n", thread_pool_size(self->pool));
+  }
+  memset(&load->placeholder, 0, sizeof(load->placeholder));
+  dynarray_push((DynArray *)scene->objects->data, &load->placeholder);
+  dynarray_push(self->loads, load);
+
+  load->owner = self;
+  load->file = model_file_find(self, load->filename);
+  pthread_mutex_lock(&self->lock);
+  bool queued = load->file->running;
+  if (queued)
+    load->file->last->next = load;
+  load->file->last = load;
+  load->file->running = true;
+  pthread_mutex_unlock(&self->lock);
+  if (!queued)
+    thread_pool_submit(self->pool, model_load_run, load);
+}
+
+// Waits for every load and puts what each produced in its placeholder's
+// place.
+static void model_loads_join(ModelLoads *self, Scene *scene) {
+  if (!self->pool)
+    return;
+  thread_pool_destroy(self->pool);
+
+  DynArray *objects = (DynArray *)scene->objects->data;
+  int count = dynarray_size(objects);
+  Hittable **parsed = malloc((size_t)(count ? count : 1) * sizeof(Hittable *));
+  assert(parsed != NULL);
+  for (int i = 0; i < count; i++)
+    parsed[i] = dynarray_get(objects, i);
+  while (dynarray_size(objects) > 0)
+    dynarray_pop(objects);
+  scene->objects->bbox = aabb_empty();
+
+  int next = 0;
+  for (int i = 0; i < count; i++) {
+    ModelLoad *load = next < dynarray_size(self->loads)
+                          ? dynarray_get(self->loads, next)
+                          : NULL;
+    if (!load || parsed[i] != &load->placeholder) {
+      scene_add_obj(scene, parsed[i]);
+      continue;
+    }
+    next++;
+    if (!load->result.success) {
+      printf("WARNING: Failed to load %s: %s\n", load->filename,
+             load->result.error_message);
+    }
+    if (load->model) {
+      scene_add_obj(scene, load->model);
+    } else if (load->triangles) {
+      // Triangles before an error are still added, as they always were
+      DynArray *triangles = (DynArray *)load->triangles->data;
+      for (int k = 0; k < dynarray_size(triangles); k++)
+        scene_add_obj(scene, dynarray_get(triangles, k));
+      load->triangles->destroy(load->triangles);
+    }
+    free(load);
+  }
+  free(parsed);
+  dynarray_release(self->loads);
+  name_table_destroy(self->file_names);
+  dynarray_destroy(self->files);
+  pthread_mutex_destroy(&self->lock);
+  self->pool = NULL;
+  self->loads = NULL;
+}
 
-  DynArray *mat_names = dynarray_create(8, NULL, (GDestroyFn)free);
+void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
+  MappedFile file;
+  PANIC_IF(!mapped_file_open(&file, filename), "Could not open scene file: %s",
+           filename);
 
-  DynArray *tex_names = dynarray_create(8, NULL, (GDestroyFn)free);
+  NameTable *mat_names = name_table_create();
+  NameTable *tex_names = name_table_create();
   char tex_name[32] = "";
   char tex_type[32] = "";
   char mat_texture_name[32] = "";
@@ -384,6 +616,9 @@ void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
 
   char line[MAX_LINE_LENGTH];
   char *tokens[MAX_TOKENS];
+  const char *next_line = file.data;
+  const char *file_end = file.data + file.size;
+  int line_number = 0;
 
   Vec3 center_start = {0, 0, 0};
   double radius = 0.5;
@@ -424,18 +659,35 @@ void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
   Vec3 triangle_v1 = {0, 0, 0};
   Vec3 triangle_v2 = {0, 0, 0};
 
+  Vec3 box_min = {0, 0, 0};
+  Vec3 box_max = {1, 1, 1};
+
+  // Optional per-object placement transforms
+  Vec3 obj_translate = {0, 0, 0};
+  double obj_rotate_y = 0.0;
+
   char obj_filename[128] = "";
   char obj_material_name[64] = "";
   Vec3 obj_position = {0.0, 0.0, 0.0};
   Vec3 obj_scale = {1.0, 1.0, 1.0};
   Vec3 obj_rotation = {0.0, 0.0, 0.0};
-
-  while (fgets(line, MAX_LINE_LENGTH, file)) {
-    if (line[0] == '\n') {
-      continue;
-    }
-
-    if (strchr(line, '}')) {
+  bool obj_lazy = false;
+  bool obj_paged = false;
+  ModelLoads model_loads = {0};
+
+  while (next_line < file_end) {
+    const char *line_begin = next_line;
+    const char *line_end =
+        memchr(line_begin, '\n', (size_t)(file_end - line_begin));
+    if (!line_end)
+      line_end = file_end;
+    next_line = line_end + 1;
+    line_number++;
+    PANIC_IF(line_end - line_begin >= MAX_LINE_LENGTH,
+             "Line %d of %s is longer than %d characters", line_number,
+             filename, MAX_LINE_LENGTH - 1);
+
+    if (memchr(line_begin, '}', (size_t)(line_end - line_begin))) {
       switch (state) {
       case MATERIAL_STATE:
         add_material(scene, mat_names, tex_names, mat_name, mat_type, color,
@@ -448,83 +700,76 @@ void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
         break;
       case SPHERE_STATE:
         if (is_moving) {
-          scene_add_obj(scene, sphere_create_moving(center_start, center_end,
-                                                    radius, current_mat));
+          scene_add_obj(scene, wrap_transforms(
+                                   sphere_create_moving(center_start, center_end,
+                                                        radius, current_mat),
+                                   obj_rotate_y, obj_translate));
         } else {
-          scene_add_obj(scene,
-                        sphere_create(center_start, radius, current_mat));
+          scene_add_obj(scene, wrap_transforms(sphere_create(center_start,
+                                                             radius, current_mat),
+                                               obj_rotate_y, obj_translate));
         }
         is_moving = false;
         break;
       case PLANE_STATE:
-        scene_add_obj(scene, plane_create(point, normal, current_mat));
+        scene_add_obj(scene,
+                      wrap_transforms(plane_create(point, normal, current_mat),
+                                      obj_rotate_y, obj_translate));
         break;
       case TRIANGLE_STATE:
-        scene_add_obj(scene,
-                      triangle_hittable_create(triangle_v0, triangle_v1,
-                                               triangle_v2, current_mat));
+        scene_add_obj(scene, wrap_transforms(
+                                 triangle_hittable_create(triangle_v0, triangle_v1,
+                                                          triangle_v2, current_mat),
+                                 obj_rotate_y, obj_translate));
         break;
       case QUAD_STATE:
-        scene_add_obj(scene, quad_create(Q, u, v, current_mat));
+        scene_add_obj(scene, wrap_transforms(quad_create(Q, u, v, current_mat),
+                                             obj_rotate_y, obj_translate));
+        break;
+      case BOX_STATE:
+        scene_add_obj(scene,
+                      wrap_transforms(box_create(box_min, box_max, current_mat),
+                                      obj_rotate_y, obj_translate));
         break;
       case OBJ_MODEL_STATE: {
-        printf("DEBUG: Processing OBJ_MODEL - filename: '%s', material: '%s'\n",
-               obj_filename, obj_material_name);
-
         if (strlen(obj_filename) == 0) {
-          printf("DEBUG: No filename specified, skipping OBJ\n");
+          printf("WARNING: obj_model without a file, skipped\n");
           goto cleanup_obj;
         }
 
         if (strlen(obj_material_name) == 0) {
-          printf("DEBUG: No material specified, skipping OBJ\n");
+          printf("WARNING: obj_model %s has no material, skipped\n",
+                 obj_filename);
           goto cleanup_obj;
         }
 
-        // Check if file exists
-        FILE *test_file = fopen(obj_filename, "r");
-        if (!test_file) {
-          printf("DEBUG: Cannot open OBJ file: %s\n", obj_filename);
+        int mat_index = name_table_find(mat_names, obj_material_name);
+        if (mat_index < 0) {
+          printf("WARNING: Material '%s' for %s not found, skipped\n",
+                 obj_material_name, obj_filename);
           goto cleanup_obj;
         }
-        fclose(test_file);
-
-        // Find material
         Material *obj_material =
-            find_material_by_name(scene, mat_names, obj_material_name);
-        if (!obj_material) {
-          printf("DEBUG: Material '%s' not found\n", obj_material_name);
-          goto cleanup_obj;
+            (Material *)dynarray_get(scene->materials, mat_index);
+
+        ModelLoad *load = calloc(1, sizeof(ModelLoad));
+        assert(load != NULL);
+        strcpy(load->filename, obj_filename);
+        load->material = obj_material;
+        load->scale = obj_scale;
+        load->position = obj_position;
+        load->rotation = obj_rotation;
+        load->lazy = obj_lazy;
+        load->paged = obj_paged;
+        // Emitters must be in the light list from the start, so they are
+        // always loaded up front
+        load->emissive = obj_material->type == MATERIAL_DIFFUSE_LIGHT;
+        if ((obj_lazy || obj_paged) && load->emissive) {
+          printf("WARNING: obj_model %s is emissive, loaded eagerly\n",
+                 obj_filename);
+          load->lazy = load->paged = false;
         }
-
-        printf("DEBUG: Starting OBJ parsing for %s\n", obj_filename);
-
-        // Create mesh loader
-        MeshLoader *loader = mesh_loader_create(obj_material);
-
-        // Get object count before OBJ loading
-        int objects_before = dynarray_size((DynArray *)scene->objects->data);
-        printf("DEBUG: Objects in scene before OBJ: %d\n", objects_before);
-
-        // Parse OBJ and add triangles
-        ObjParseResult result =
-            obj_parse_file_to_hittables(obj_filename, loader, scene->objects,
-                                        obj_scale, obj_position, obj_rotation);
-
-        // Get object count after OBJ loading
-        int objects_after = dynarray_size((DynArray *)scene->objects->data);
-        printf("DEBUG: Objects in scene after OBJ: %d (added %d)\n",
-               objects_after, objects_after - objects_before);
-
-        if (result.success) {
-          printf("DEBUG: Successfully loaded %s: %d vertices, %d faces\n",
-                 obj_filename, result.vertex_count, result.face_count);
-        } else {
-          printf("DEBUG: Failed to load %s: %s\n", obj_filename,
-                 result.error_message);
-        }
-
-        mesh_loader_destroy(loader);
+        model_load_submit(&model_loads, scene, load);
 
       cleanup_obj:
         // Reset variables
@@ -533,16 +778,20 @@ void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
         obj_position = (Vec3){0.0, 0.0, 0.0};
         obj_scale = (Vec3){1.0, 1.0, 1.0};
         obj_rotation = (Vec3){0.0, 0.0, 0.0};
+        obj_lazy = false;
+        obj_paged = false;
         break;
       }
       default:
         break;
       }
+      obj_translate = (Vec3){0, 0, 0};
+      obj_rotate_y = 0.0;
       state = TOPLEVEL_STATE;
       continue;
     }
 
-    int num_toks = tokenize(line, tokens);
+    int num_toks = tokenize(line_begin, line_end, line, tokens);
     if (num_toks == 0)
       continue;
 
@@ -561,8 +810,9 @@ void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
         state = TRIANGLE_STATE;
       } else if (strcmp(tokens[0], "quad") == 0) {
         state = QUAD_STATE;
+      } else if (strcmp(tokens[0], "box") == 0) {
+        state = BOX_STATE;
       } else if (strcmp(tokens[0], "obj_model") == 0) {
-        printf("entering OBJ model state");
         state = OBJ_MODEL_STATE;
       } else {
         PANIC("Unknown top level type: %s", tokens[0]);
@@ -581,27 +831,38 @@ void parse_scene(const char *filename, Scene *scene, Camera *out_cam) {
                       &tex_color1, &tex_color2);
       } else if (state == OBJ_MODEL_STATE) {
         parse_obj_model(tokens, num_toks, obj_filename, obj_material_name,
-                        &obj_position, &obj_scale, &obj_rotation);
+                        &obj_position, &obj_scale, &obj_rotation, &obj_lazy,
+                        &obj_paged);
       } else {
         if (num_toks == 2 && strcmp(tokens[0], "material") == 0) {
-          int index = name_index(mat_names, tokens[1]);
+          int index = name_table_find(mat_names, tokens[1]);
           PANIC_IF(index < 0, "Material not found: %s", tokens[1]);
           current_mat =
               (Material *)dynarray_get(scene->materials, (size_t)index);
           continue;
         }
+        if (num_toks == 4 && strcmp(tokens[0], "translate") == 0) {
+          obj_translate = parse_vec3(tokens);
+          continue;
+        }
+        if (num_toks == 2 && strcmp(tokens[0], "rotate_y") == 0) {
+          obj_rotate_y = token_double(tokens[1]);
+          continue;
+        }
         parse_geometry(state, tokens, num_toks, &center_start, &center_end,
                        &is_moving, &radius, &point, &normal, &Q, &u, &v,
-                       &triangle_v0, &triangle_v1, &triangle_v2);
+                       &triangle_v0, &triangle_v1, &triangle_v2, &box_min,
+                       &box_max);
       }
     }
   }
-  fclose(file);
+  mapped_file_close(&file);
+  model_loads_join(&model_loads, scene);
 
   *out_cam = camera_make(width, aspect_ratio, lookfrom, lookat, vup, vfov,
                          defocus_angle, focus_dist, samples_per_pixel,
                          max_depth, background, is_lighting);
 
-  dynarray_destroy(mat_names);
-  dynarray_destroy(tex_names);
+  name_table_destroy(mat_names);
+  name_table_destroy(tex_names);
 }
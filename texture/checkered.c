@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdbool.h>
+#include "core/arena.h"
 #include "checkered.h"
 #include "solid_color.h"
 
@@ -19,7 +20,7 @@ Color checkered_value(Texture* self, double u, double v, const Vec3* p) {
 }
 
 Checkered *checkered_create_textures(double scale, Texture *even, Texture *odd) {
-    Checkered *checkered = malloc(sizeof(struct Checkered));
+    Checkered *checkered = rt_alloc(sizeof(struct Checkered));
     assert(checkered != NULL);
     checkered->base_tex.value = checkered_value;
     checkered->base_tex.destroy = (void(*)(struct Texture*))checkered_destroy;
@@ -39,5 +40,5 @@ void checkered_destroy(Checkered* checkered) {
     assert(checkered != NULL);
     if (checkered->even) texture_destroy(checkered->even);
     if (checkered->odd) texture_destroy(checkered->odd);
-    free(checkered);
+    rt_free(checkered);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <stdlib.h> 
 
 #include "solid_color.h"
+#include "core/arena.h"
 #include "core/color.h"
 
 Color solid_color_value(Texture *self, double u, double v, const Vec3* p) {
@@ -13,7 +14,7 @@ Color solid_color_value(Texture *self, double u, double v, const Vec3* p) {
 }
 
 SolidColor *solid_color_create_albedo(const Color* albedo) {
-    SolidColor* sol_col = malloc(sizeof(struct SolidColor));
+    SolidColor* sol_col = rt_alloc(sizeof(struct SolidColor));
     assert(sol_col != NULL);
     sol_col->base_tex.value = solid_color_value;
     sol_col->base_tex.destroy = (void(*)(struct Texture*))solid_color_destroy;
@@ -28,5 +29,5 @@ SolidColor *solid_color_create_rgb(double r, double g, double b) {
 
 void solid_color_destroy(SolidColor *sol_col) {
     assert(sol_col != NULL);
-    free(sol_col);
+    rt_free(sol_col);
 }
\ No newline at end of file